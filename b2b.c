@@ -0,0 +1,38 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "defines.h"
+#include "includes.h"
+#include "throughput.h"
+#include "b2b.h"
+
+// the understanding of this code requires the knowledge of throughput.c
+// the measurement itself is done by Throughput::measure(), which sends trains, if train_length is set
+
+// after reading the parameters for throughput measurement, further one parameter is read
+int BackToBack::readCmdLine(int argc, const char *argv[]) {
+  if ( Throughput::readCmdLine(argc-1,argv) < 0 )
+    return -1;
+  if ( sscanf(argv[7], "%u", &train_length) != 1 || train_length < 1 || train_length > frame_rate ) {
+    std::cerr << "Input Error: Train length must be between 1 and the frame rate." << std::endl;
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,33 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef B2B_H_INCLUDED
+#define B2B_H_INCLUDED
+
+// the main class for RFC 2544 back-to-back frame measurements, adds a feature to class Throughput:
+// every second, a train of train_length frames is sent at the frame rate (which should be the maximum frame rate of the media),
+// and the rest of the second is idle; the number of trains is given by the duration
+class BackToBack : public Throughput {
+public:
+  BackToBack() : Throughput() { program = "b2b"; }; // default constructor
+  int readCmdLine(int argc, const char *argv[]);	// reads further one argument: train_length
+};
+
+#endif
@@ -19,16 +19,49 @@
  */
 
 #define CONFIGFILE "siitperf.conf"	/* name of the configuration file */
+#define CALIBRATIONFILE "siitperf.cal"	/* name of the file containing the maximum rates of the Tester, see calibrate.sh */
+#define CALIBRATION_MARGIN 0.9	/* a warning is given, if the frame rate is higher than this part of the calibrated maximum rate */
+#define BENCHFILE "siitperf-bench.baseline"	/* name of the baseline file of siitperf-bench */
+#define BENCH_TOLERANCE 1.1	/* siitperf-bench reports a regression, if a component is slower than its baseline times this value */
+#define BENCH_BUILDS 1000000	/* number of frames built by each frame builder benchmark */
+#define BENCH_FRAMES 20000000	/* number of frames sent by the send loop benchmark */
+#define BENCH_SECONDS 2		/* duration of each receiver benchmark */
+#define BENCH_TIMESTAMPS 10000000	/* number of synthetic timestamps for the evaluatePdv() benchmark */
 #define LINELEN 100             /* max. line length, used by config file reader */
 #define LEFTPORT 0		/* port ID of the "Left" port */
 #define RIGHTPORT 1		/* port ID of the "Right" port */
+#define MAX_PORT_PAIRS 4	/* maximum number of port pairs (Pair-Config), pair k uses ports LEFTPORT+2k and RIGHTPORT+2k */
 #define MAX_PORT_TRIALS 10      /* rte_eth_link_get() is attempted maximum so many times, and error is reported if still unsuccessful */
 #define START_DELAY 2000        /* Delay (ms) before senders start sending, used for synchronized start. Beware that DUT NICs need time to get ready! */
 #define TOLERANCE 1.00001       /* Maximum allowed time inaccuracy, 1.00001 allows 0.001% more time for sending */
+#define MAX_FRAME_SIZE 1538	/* maximum frame size (IPv6 frame size of pure IPv4 tests), the frame templates have this length */
 #define N 40			/* used for PDV: all frames exist is N copies to mitigate the problem of write after send */
+#define MAX_SIZE_CLASSES 8	/* maximum number of frame sizes in a frame size mix (Size-Mix) */
+#define MAX_SIZE_SEQ 1024	/* maximum sum of the weights of a frame size mix, it is the length of its size sequence */
+#define ARRIVAL_RING_BITS 16	/* the scheduled times of the frames of random arrival processes repeat after 2^ARRIVAL_RING_BITS frames */
+#define MAX_PROFILE_SEGMENTS 10000 /* maximum number of segments of a rate profile (Rate-Profile) */
+#define PROFILE_STEP_MS 10	/* the ramps of a rate profile are approximated by steps of this length (in milliseconds) */
+#define MAX_SOAK_DURATION 2592000 /* maximum duration of a soak test (30 days), other tests are limited to 3600 seconds */
+#define SOAK_RING_MIN 65536	/* minimum number of entries of the send timestamp ring of a soak test, MUST be a power of 2 */
+#define SOAK_RING_MAX 33554432	/* maximum number of entries of the send timestamp ring of a soak test, MUST be a power of 2 */
+#define SOAK_HIST_SIZE 10000	/* number of 1us buckets of the delay histograms of a soak test, longer delays go to the last one */
+#define IPDV_HIST_SIZE 100000	/* number of positive (and negative) buckets of the IPDV histogram of siitperf-pdv */
+#define IPDV_HIST_RES 100	/* resolution of the IPDV histogram in nanoseconds, the values beyond its range go to the outermost buckets */
+#define RECOVERY_OVERLOAD 110	/* system recovery test: the frame rate of the overload phase in the percentage of the throughput */
+#define RECOVERY_REDUCED 50	/* system recovery test: the frame rate of the recovery phase in the percentage of the throughput */
+#define TEMPLATE_CACHE_SIZE 8	/* number of frame template sets kept between the trials of a session */
+#define HW_PACING_AHEAD 256	/* with hardware pacing, frames are enqueued at most so many frames ahead of their scheduled time */
+#define HW_PACING_BURST 32	/* with hardware pacing, the frames are enqueued in bursts of so many frames (less than HW_PACING_AHEAD) */
+#define HW_PACING_SLEEP 100	/* with hardware pacing, the sender sleeps instead of spinning, if it is ahead by more than so many us */
+#define TIMELINE_RING_SIZE 1024 /* number of snapshots in a timeline ring, MUST be a power of 2 */
+#define REF_DUT_RING_SIZE 1024	/* size of the rings connecting the Tester and the reference DUT, MUST be a power of 2 */
+#define EAM_TABLE_SIZE 4096	/* number of slots in the hash tables of the reference DUT, MUST be a power of 2 */
+#define IMP_MAX_QUEUE_SIZE 1048576 /* max. number of frames delayed by the impairment stage of the reference DUT per direction */
+#define IMP_HIST_SIZE 100000	/* number of 1us buckets of the delay histogram of the impairment stage, longer delays go to the last one */
 
 // values taken from DPDK sample programs
 #define MAX_PKT_BURST 32        /* Maximum burst size for rte_eth_rx_burst() */
 #define PKTPOOL_CACHE 32        /* used by rte_pktmbuf_pool_create() */
+#define RX_POOL_CACHE 64	/* per-lcore cache of the receiver pools: two bursts, as the NIC refills its RX ring in bursts */
 #define PORT_RX_QUEUE_SIZE 1024	
 #define PORT_TX_QUEUE_SIZE 1024
@@ -0,0 +1,97 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "defines.h"
+#include "includes.h"
+#include "throughput.h"
+#include "frame.h"
+
+// length of the field after the signature (Latency Frame ID or PDV Frame counter) for each frame kind
+static const int id_length[NUM_FRAME_KINDS] = { 0, 2, 8 };
+static const char *kind_name[NUM_FRAME_KINDS] = { "Test Frame", "Latency Frame", "PDV Frame" };
+
+// the templates of the frames of each kind and IP version: the constant fields of the headers, and the UDP data of the
+// longest frame; they are made before main() is called, thus the builders may run on several lcores in parallel
+static class frameTemplateSet {
+public:
+  uint8_t frame[NUM_FRAME_KINDS][2][MAX_FRAME_SIZE];	// index 0: IPv4, index 1: IPv6
+  frameTemplateSet();
+} frame_templates;
+
+frameTemplateSet::frameTemplateSet() {
+  static const char *signature[NUM_FRAME_KINDS] = { "IDENTIFY", "Identify", "IDENTIFY" }; // Test Frames, Latency Frames, PDV Frames
+  struct ether_addr mac = {};	// the addresses are set by mkFrame()
+  uint32_t ipv4 = 0;
+  struct in6_addr ipv6 = {};
+  int i, k, v;
+
+  memset(frame, 0, sizeof(frame));
+  for ( k=0; k<NUM_FRAME_KINDS; k++ )
+    for ( v=0; v<2; v++ ) {
+      uint8_t *pkt = frame[k][v];
+      const frameLayout &l = layout(v ? 6 : 4);
+      mkEthHeader(reinterpret_cast<ether_hdr *>(pkt), &mac, &mac, v ? 0x86DD : 0x0800);
+      if ( v )
+        mkIpv6Header(reinterpret_cast<ipv6_hdr *>(pkt+l.ip), sizeof(ipv6_hdr), &ipv6, &ipv6);
+      else
+        mkIpv4Header(reinterpret_cast<ipv4_hdr *>(pkt+l.ip), sizeof(ipv4_hdr), &ipv4, &ipv4);
+      mkUdpHeader(reinterpret_cast<udp_hdr *>(pkt+l.udp), sizeof(udp_hdr));
+      memcpy(pkt+l.data, signature[k], 8);
+      uint8_t *data = pkt+l.id+id_length[k];	// the ID is 0 in the template
+      for ( i=0; data+i < pkt+MAX_FRAME_SIZE; i++ )
+        data[i] = i % 256;
+    }
+}
+
+// builds a frame of the given kind: its template is copied, and the variable fields are patched
+// Please refer to RFC 2544 Appendx C.2.6.4 Test Frames for the values set in the templates.
+struct rte_mbuf *mkFrame(frameKind kind, int ip_version, uint16_t length, rte_mempool *pkt_pool, const char *side,
+                         const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
+                         const void *src_ip, const void *dst_ip, uint64_t id) {
+  const frameLayout &l = layout(ip_version);
+  struct rte_mbuf *pkt_mbuf=rte_pktmbuf_alloc(pkt_pool); // message buffer for the frame
+  if ( !pkt_mbuf )
+    rte_exit(EXIT_FAILURE, "Error: %s sender can't allocate a new mbuf for the %s! \n", side, kind_name[kind]);
+  length -=  ETHER_CRC_LEN; // exclude CRC from the frame length
+  pkt_mbuf->pkt_len = pkt_mbuf->data_len = length; // set the length in both places
+  uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbuf, uint8_t *); // Access the frame in the message buffer
+  udp_hdr *udp_hd = reinterpret_cast<udp_hdr *>(pkt+l.udp); // UDP header
+
+  rte_memcpy(pkt, frame_templates.frame[kind][ip_version == 6], length); // headers and UDP data in one copy
+  rte_memcpy(pkt, dst_mac, sizeof(struct ether_addr));
+  rte_memcpy(pkt+sizeof(struct ether_addr), src_mac, sizeof(struct ether_addr));
+  udp_hd->dgram_len = htons(length-l.udp);
+  rte_memcpy(pkt+l.id, &id, id_length[kind]); // the lower bytes of the ID on a little endian CPU
+  if ( ip_version == 4 ) {
+    ipv4_hdr *ip_hdr = reinterpret_cast<ipv4_hdr *>(pkt+l.ip); // IPv4 header
+    ip_hdr->total_length = htons(length-l.ip);
+    rte_memcpy(&ip_hdr->src_addr,src_ip,4);
+    rte_memcpy(&ip_hdr->dst_addr,dst_ip,4);
+    udp_hd->dgram_cksum = rte_ipv4_udptcp_cksum( ip_hdr, udp_hd ); // UDP checksum is calculated and set
+    ip_hdr->hdr_checksum = rte_ipv4_cksum(ip_hdr);	// IPv4 header checksum is set now
+  } else { // IPv6
+    ipv6_hdr *ip_hdr = reinterpret_cast<ipv6_hdr *>(pkt+l.ip); // IPv6 header
+    ip_hdr->payload_len = htons(length-l.udp);
+    rte_mov16((uint8_t *)&ip_hdr->src_addr,(const uint8_t *)src_ip);
+    rte_mov16((uint8_t *)&ip_hdr->dst_addr,(const uint8_t *)dst_ip);
+    udp_hd->dgram_cksum = rte_ipv6_udptcp_cksum( ip_hdr, udp_hd ); // UDP checksum is calculated and set
+  }
+  return pkt_mbuf;
+}
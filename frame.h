@@ -0,0 +1,74 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_H_INCLUDED
+#define FRAME_H_INCLUDED
+
+// offsets of the fields of the frames of siitperf from the start of the Ethernet frame
+// (no IP options or IPv6 extension headers are used); the builders, the stampers and the receivers all use these values
+struct frameLayout {
+  uint16_t ether_type;		// EtherType
+  uint16_t ip;			// IP header
+  uint16_t proto;		// IPv4 Protocol or IPv6 Next Header
+  uint16_t ip_chksum;		// IPv4 header checksum, 0: there is none (IPv6)
+  uint16_t dst_addr;		// IP destination address
+  uint16_t flow;		// the byte of the destination address, which identifies the flow (see flowAddresses())
+  uint16_t udp;			// UDP header
+  uint16_t udp_chksum;		// UDP checksum
+  uint16_t data;		// UDP data: it starts with the 8-byte signature of the frame kind
+  uint16_t id;			// Latency Frame ID or PDV Frame counter, right after the signature
+  uint16_t ip_len;		// IPv4 Total Length or IPv6 Payload Length
+};
+
+constexpr frameLayout layout4 = {
+  12, 14, 14+offsetof(ipv4_hdr,next_proto_id), 14+offsetof(ipv4_hdr,hdr_checksum), 14+offsetof(ipv4_hdr,dst_addr), 14+offsetof(ipv4_hdr,dst_addr)+2,
+  14+sizeof(ipv4_hdr), 14+sizeof(ipv4_hdr)+offsetof(udp_hdr,dgram_cksum), 14+sizeof(ipv4_hdr)+sizeof(udp_hdr), 14+sizeof(ipv4_hdr)+sizeof(udp_hdr)+8,
+  14+offsetof(ipv4_hdr,total_length)
+};
+constexpr frameLayout layout6 = {
+  12, 14, 14+offsetof(ipv6_hdr,proto), 0, 14+offsetof(ipv6_hdr,dst_addr), 14+offsetof(ipv6_hdr,dst_addr)+7,
+  14+sizeof(ipv6_hdr), 14+sizeof(ipv6_hdr)+offsetof(udp_hdr,dgram_cksum), 14+sizeof(ipv6_hdr)+sizeof(udp_hdr), 14+sizeof(ipv6_hdr)+sizeof(udp_hdr)+8,
+  14+offsetof(ipv6_hdr,payload_len)
+};
+static_assert(sizeof(ether_hdr) == 14 && layout4.id == 50 && layout6.id == 70, "unexpected frame layout");
+
+// returns the layout of the frames of the given IP version
+constexpr const frameLayout &layout(int ip_version) {
+  return ip_version == 4 ? layout4 : layout6;
+}
+
+// the size of a received frame (including the FCS) calculated from the length field of its IP header,
+// it does not depend on whether the NIC strips the FCS
+inline uint16_t frameSize4(const uint8_t *pkt) {
+  return ntohs(*(const uint16_t *)&pkt[layout4.ip_len])+layout4.ip+4;
+}
+inline uint16_t frameSize6(const uint8_t *pkt) {
+  return ntohs(*(const uint16_t *)&pkt[layout6.ip_len])+layout6.udp+4;
+}
+
+// kinds of frames: they differ in their signature and in the field after it
+enum frameKind { TEST_FRAME, LATENCY_FRAME, PDV_FRAME, NUM_FRAME_KINDS };
+
+// builds a frame of the given kind by copying its prebuilt template and patching the addresses, lengths, ID and checksums
+struct rte_mbuf *mkFrame(frameKind kind, int ip_version, uint16_t length, rte_mempool *pkt_pool, const char *side,
+                         const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
+                         const void *src_ip, const void *dst_ip, uint64_t id);
+
+#endif
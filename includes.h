@@ -22,10 +22,12 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <string.h>
+#include <time.h>
 #include <numa.h>
 #include <random>
 #include <iostream>
 #include <algorithm>
+#include <vector>
 #include <rte_lcore.h>
 #include <rte_mempool.h>
 #include <rte_cycles.h>
@@ -34,4 +36,7 @@
 #include <rte_udp.h>
 #include <rte_ethdev.h>
 #include <rte_malloc.h>
+#include <rte_ring.h>
+#include <rte_eth_ring.h>
+#include <rte_bus_vdev.h>
 
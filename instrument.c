@@ -0,0 +1,50 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "defines.h"
+#include "includes.h"
+#include "instrument.h"
+
+// the cycles spent per frame (without waiting for the schedule) are compared to the cycles available per frame:
+// if they are close, then the sender core is the bottleneck, and not the DUT
+void reportSenderInstruments(const lcoreInstruments *ins, uint64_t sent_frames, uint64_t elapsed, uint64_t hz, uint32_t frame_rate, const char *side) {
+  if ( !sent_frames )
+    return;
+  printf("Info: %s sender (lcore %u): TX retries: %lu, cycles/frame: %.1lf (available: %.1lf), idle: %.2lf%%\n", side, rte_lcore_id(),
+         ins->tx_retries, (double)(elapsed-ins->spin_cycles)/sent_frames, (double)hz/frame_rate, 100.0*ins->spin_cycles/elapsed);
+}
+
+// the cycles spent per frame are calculated from the non-empty bursts only, as the empty polls are the idle time of the receiver
+void reportReceiverInstruments(const lcoreInstruments *ins, const char *side) {
+  uint64_t polls=0, frames=0;	// number of all polls and of all frames received (including non test frames)
+  int i;			// cycle variable
+
+  for ( i=0; i<=MAX_PKT_BURST; i++ ) {
+    polls += ins->burst[i];
+    frames += i*ins->burst[i];
+  }
+  printf("Info: %s receiver (lcore %u): polls: %lu, empty polls: %lu, frames: %lu, cycles/frame: %.1lf\n", side, rte_lcore_id(),
+         polls, ins->burst[0], frames, frames ? (double)ins->busy_cycles/frames : 0.0);
+  printf("Info: %s receiver (lcore %u) burst size distribution (size: polls):", side, rte_lcore_id());
+  for ( i=1; i<=MAX_PKT_BURST; i++ )
+    if ( ins->burst[i] )
+      printf(" %d: %lu", i, ins->burst[i]);
+  printf("\n");
+}
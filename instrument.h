@@ -0,0 +1,51 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef INSTRUMENT_H_INCLUDED
+#define INSTRUMENT_H_INCLUDED
+
+// Data-plane instrumentation: it is compiled in only if INSTRUMENT is defined (see the Makefiles),
+// otherwise the INSTR() statements disappear, and the send*() and receive*() loops are exactly the same as without it.
+// Beware that the instrumentation reads the TSC twice more per frame in the senders, and once more per burst in the receivers.
+
+#ifdef INSTRUMENT
+#define INSTR(statement) statement
+#else
+#define INSTR(statement)
+#endif
+
+// counters of a single sender or receiver lcore
+struct lcoreInstruments {
+  uint64_t tx_retries;			// sender: number of unsuccessful rte_eth_tx_burst() calls
+  uint64_t spin_cycles;			// sender: TSC cycles spent waiting for the scheduled time of the frames
+  uint64_t busy_cycles;			// receiver: TSC cycles spent with receiving and processing non-empty bursts
+  uint64_t burst[MAX_PKT_BURST+1];	// receiver: distribution of the number of frames returned by rte_eth_rx_burst(), burst[0] counts the empty polls
+  uint64_t t0;				// temporary: start of the currently measured period
+
+  lcoreInstruments() { memset(this, 0, sizeof(*this)); }
+};
+
+// print the report of a sender: elapsed is the whole sending time in TSC cycles
+void reportSenderInstruments(const lcoreInstruments *ins, uint64_t sent_frames, uint64_t elapsed, uint64_t hz, uint32_t frame_rate, const char *side);
+
+// print the report of a receiver
+void reportReceiverInstruments(const lcoreInstruments *ins, const char *side);
+
+#endif
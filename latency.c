@@ -22,6 +22,12 @@
 #include "includes.h"
 #include "throughput.h"
 #include "latency.h"
+#include "frame.h"
+#include "timeline.h"
+#include "live.h"
+#include "pacing.h"
+#include "instrument.h"
+#include "sender.h"
 
 // the understanding of this code requires the knowledge of throughput.c
 // only a few functions are redefined or added here
@@ -53,72 +59,74 @@ int Latency::senderPoolSize(int num_dest_nets) {
   return Throughput::senderPoolSize(num_dest_nets)+num_timestamps; // frames with timestamps are also pre-generated
 }
 
-// creates a special IPv4 Test Frame tagged for latency measurement using several helper functions
+uint64_t Latency::timestampMemory() {
+  return (uint64_t) (forward+reverse)*2*num_timestamps*sizeof(uint64_t);
+}
+
+// creates a special IPv4 Test Frame tagged for latency measurement from its template (see frame.c)
 struct rte_mbuf *mkLatencyFrame4(uint16_t length, rte_mempool *pkt_pool, const char *side,
                               const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
-                              const uint32_t *src_ip, const uint32_t *dst_ip, int id) {
-  struct rte_mbuf *pkt_mbuf=rte_pktmbuf_alloc(pkt_pool); // message buffer for the Latency Frame
-  if ( !pkt_mbuf )
-    rte_exit(EXIT_FAILURE, "Error: %s sender can't allocate a new mbuf for the Latency Frame! \n", side);
-  length -=  ETHER_CRC_LEN; // exclude CRC from the frame length
-  pkt_mbuf->pkt_len = pkt_mbuf->data_len = length; // set the length in both places
-  uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbuf, uint8_t *); // Access the Test Frame in the message buffer
-  ether_hdr *eth_hdr = reinterpret_cast<struct ether_hdr *>(pkt); // Ethernet header
-  ipv4_hdr *ip_hdr = reinterpret_cast<ipv4_hdr *>(pkt+sizeof(ether_hdr)); // IPv4 header
-  udp_hdr *udp_hd = reinterpret_cast<udp_hdr *>(pkt+sizeof(ether_hdr)+sizeof(ipv4_hdr)); // UDP header
-  uint8_t *udp_data = reinterpret_cast<uint8_t*>(pkt+sizeof(ether_hdr)+sizeof(ipv4_hdr)+sizeof(udp_hdr)); // UDP data
-
-  mkEthHeader(eth_hdr, dst_mac, src_mac, 0x0800);       // contains an IPv4 packet
-  int ip_length = length - sizeof(ether_hdr);
-  mkIpv4Header(ip_hdr, ip_length, src_ip, dst_ip);      // Does not set IPv4 header checksum
-  int udp_length = ip_length - sizeof(ipv4_hdr);        // No IP Options are used
-  mkUdpHeader(udp_hd, udp_length);
-  int data_legth = udp_length - sizeof(udp_hdr);
-  mkDataLatency(udp_data, data_legth, id);
-  udp_hd->dgram_cksum = rte_ipv4_udptcp_cksum( ip_hdr, udp_hd ); // UDP checksum is calculated and set
-  ip_hdr->hdr_checksum = rte_ipv4_cksum(ip_hdr);
-  return pkt_mbuf;
+                              const uint32_t *src_ip, const uint32_t *dst_ip, uint16_t id) {
+  return mkFrame(LATENCY_FRAME, 4, length, pkt_pool, side, dst_mac, src_mac, src_ip, dst_ip, id);
 }
 
-// creates a special IPv6 Test Frame tagged for latency measurement using several helper functions
+// creates a special IPv6 Test Frame tagged for latency measurement from its template (see frame.c)
 struct rte_mbuf *mkLatencyFrame6(uint16_t length, rte_mempool *pkt_pool, const char *side,
                               const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
                               const struct in6_addr *src_ip, const struct in6_addr *dst_ip, uint16_t id) {
-  struct rte_mbuf *pkt_mbuf=rte_pktmbuf_alloc(pkt_pool); // message buffer for the Latency Frame
-  if ( !pkt_mbuf )
-    rte_exit(EXIT_FAILURE, "Error: %s sender can't allocate a new mbuf for the Latency Frame! \n", side);
-  length -=  ETHER_CRC_LEN; // exclude CRC from the frame length
-  pkt_mbuf->pkt_len = pkt_mbuf->data_len = length; // set the length in both places
-  uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbuf, uint8_t *); // Access the Test Frame in the message buffer
-  ether_hdr *eth_hdr = reinterpret_cast<struct ether_hdr *>(pkt); // Ethernet header
-  ipv6_hdr *ip_hdr = reinterpret_cast<ipv6_hdr *>(pkt+sizeof(ether_hdr)); // IPv6 header
-  udp_hdr *udp_hd = reinterpret_cast<udp_hdr *>(pkt+sizeof(ether_hdr)+sizeof(ipv6_hdr)); // UDP header
-  uint8_t *udp_data = reinterpret_cast<uint8_t*>(pkt+sizeof(ether_hdr)+sizeof(ipv6_hdr)+sizeof(udp_hdr)); // UDP data
-
-  mkEthHeader(eth_hdr, dst_mac, src_mac, 0x86DD); // contains an IPv6 packet
-  int ip_length = length - sizeof(ether_hdr);
-  mkIpv6Header(ip_hdr, ip_length, src_ip, dst_ip);
-  int udp_length = ip_length - sizeof(ipv6_hdr); // No IP Options are used
-  mkUdpHeader(udp_hd, udp_length);
-  int data_legth = udp_length - sizeof(udp_hdr);
-  mkDataLatency(udp_data, data_legth, id);
-  udp_hd->dgram_cksum = rte_ipv6_udptcp_cksum( ip_hdr, udp_hd ); // UDP checksum is calculated and set
-  return pkt_mbuf;
+  return mkFrame(LATENCY_FRAME, 6, length, pkt_pool, side, dst_mac, src_mac, src_ip, dst_ip, id);
 }
 
-// fills the data field of the Latency Frame
-void mkDataLatency(uint8_t *data, uint16_t length, uint16_t latency_frame_id) {
-  unsigned i;
-  uint8_t identify[8]= { 'I', 'd', 'e', 'n', 't', 'i', 'f', 'y' };      // Identificion of the Latency Frames
-  uint64_t *id=(uint64_t *) identify;
-  *(uint64_t *)data = *id;
-  data += 8;
-  length -= 8;
-  *(uint16_t *)data = latency_frame_id;
-  data += 2;
-  length -=2;
-  for ( i=0; i<length; i++ )
-    data[i] = i % 256;
+// lcore function: pre-generates the Latency Frames of a sender (may be foreground frames and background frames as well) with
+// random destination networks; the frames of Latency Frame 0 of flow 0 are built, the others are their copies with rewritten
+// Latency Frame ID and flow, and incrementally adjusted checksums
+int mkLatencyFrames(void *par) {
+  // collecting input parameters:
+  class senderParametersLatency *p = (class senderParametersLatency *)par;
+  class senderCommonParametersLatency *cp = (class senderCommonParametersLatency *) p->cp;
+  uint32_t frame_rate = cp->frame_rate;
+  uint16_t num_timestamps = cp->num_timestamps;
+  int latency_test_time = cp->duration-cp->delay;	// lenght of the time interval, while latency frames are sent
+  uint64_t start_latency_frame = cp->delay*frame_rate; // the ordinal numbert of the very first latency frame
+  uint32_t dst_ipv4;     // IPv4 destination address of flow 0
+  in6_addr dst_ipv6;     // foreground IPv6 destination address of flow 0
+  in6_addr dst_bg;       // backround IPv6 destination address of flow 0
+  struct rte_mbuf *fg_master, *bg_master;	// Latency Frame 0 of flow 0
+
+  flowAddresses(p, 0, &dst_ipv4, &dst_ipv6, &dst_bg);
+  if ( p->ip_version == 4 )  // foreground frame, may be IPv4 or IPv6
+    fg_master = mkLatencyFrame4(cp->ipv4_frame_size, p->pkt_pool, p->side, p->dst_mac, p->src_mac, p->src_ipv4, &dst_ipv4, 0);
+  else  // IPv6
+    fg_master = mkLatencyFrame6(cp->ipv6_frame_size, p->pkt_pool, p->side, p->dst_mac, p->src_mac, p->src_ipv6, &dst_ipv6, 0);
+  bg_master = mkLatencyFrame6(cp->ipv6_frame_size, p->pkt_pool, p->side, p->dst_mac, p->src_mac, p->src_bg, &dst_bg, 0); // must be IPv6
+  const frameLayout &fg = layout(p->ip_version);
+
+  p->latency_frames = new struct rte_mbuf *[num_timestamps];
+  if ( !p->latency_frames )
+    rte_exit(EXIT_FAILURE, "Error: Tester can't allocate memory for latency frame pointers!\n");
+  randomFlow flows(p->num_dest_nets);
+  for ( int i=0; i<num_timestamps; i++ ) {
+    struct rte_mbuf *frame;
+    uint8_t *pkt;
+    int flow = flows.next();
+    if ( (start_latency_frame+i*frame_rate*latency_test_time/num_timestamps) % cp->n  < cp->m ) {
+      frame = copyFrame(rte_pktmbuf_mtod(fg_master, uint8_t *), fg_master->data_len, p->pkt_pool, p->side);
+      pkt = rte_pktmbuf_mtod(frame, uint8_t *);
+      patchWord(pkt, fg.id, (uint16_t) i, 0, fg.udp_chksum);
+      if ( p->num_dest_nets > 1 )
+        patchFlow(pkt, p->ip_version, flow);
+    } else {
+      frame = copyFrame(rte_pktmbuf_mtod(bg_master, uint8_t *), bg_master->data_len, p->pkt_pool, p->side);
+      pkt = rte_pktmbuf_mtod(frame, uint8_t *);
+      patchWord(pkt, layout6.id, (uint16_t) i, 0, layout6.udp_chksum);
+      if ( p->num_dest_nets > 1 )
+        patchFlow(pkt, 6, flow);
+    }
+    p->latency_frames[i] = frame;
+  }
+  rte_pktmbuf_free(fg_master); // they have never been sent
+  rte_pktmbuf_free(bg_master);
+  return 0;
 }
 
 // sends Test Frames for latency measurements including "num_timestamps" number of Latency frames
@@ -126,185 +134,18 @@ int sendLatency(void *par) {
   // collecting input parameters:
   class senderParametersLatency *p = (class senderParametersLatency *)par;
   class senderCommonParametersLatency *cp = (class senderCommonParametersLatency *) p->cp;
-
-  // parameters directly correspond to the data members of class Throughput
-  uint16_t ipv6_frame_size = cp->ipv6_frame_size;
-  uint16_t ipv4_frame_size = cp->ipv4_frame_size;
   uint32_t frame_rate = cp->frame_rate;
-  uint16_t duration = cp->duration;
-  uint32_t n = cp->n;
-  uint32_t m = cp->m;
-  uint64_t hz = cp->hz;
-  uint64_t start_tsc = cp->start_tsc;
-  // parameters directly correspond to the data members of class Latency
-  uint16_t delay = cp->delay;
-  uint16_t num_timestamps = cp->num_timestamps;
+  int latency_test_time = cp->duration-cp->delay;	// lenght of the time interval, while latency frames are sent
+  uint64_t start_latency_frame = cp->delay*frame_rate; // the ordinal numbert of the very first latency frame
 
-  // parameters which are different for the Left sender and the Right sender
-  int ip_version = p->ip_version;
-  rte_mempool *pkt_pool = p->pkt_pool;
-  uint8_t eth_id = p->eth_id;
-  const char *side = p->side;
-  struct ether_addr *dst_mac = p->dst_mac;
-  struct ether_addr *src_mac = p->src_mac;
-  uint16_t num_dest_nets = p->num_dest_nets;
-  uint32_t *src_ipv4 = p->src_ipv4;
-  uint32_t *dst_ipv4 = p->dst_ipv4;
-  struct in6_addr *src_ipv6 = p->src_ipv6;
-  struct in6_addr *dst_ipv6 = p->dst_ipv6;
-  struct in6_addr *src_bg= p->src_bg;
-  struct in6_addr *dst_bg = p->dst_bg;
-  uint64_t *send_ts = p->send_ts;
-
-  uint64_t frames_to_send = duration * frame_rate;      // Each active sender sends this number of packets
-  uint64_t sent_frames=0; // counts the number of sent frames
-  double elapsed_seconds; // for checking the elapsed seconds during sending
-  int latency_test_time = duration-delay;	// lenght of the time interval, while latency frames are sent
-  uint64_t frames_to_send_during_latency_test = latency_test_time * frame_rate; // precalcalculated value to speed up calculation in the loop
-
-  if ( num_dest_nets== 1 ) {
-    // optimized code for single flow: always the same foreground or background frame is sent, except latency frames, which are stored in an array
-    struct rte_mbuf *fg_pkt_mbuf, *bg_pkt_mbuf; // message buffers for fg. and bg. Test Frames
-    // create foreground Test Frame
-    if ( ip_version == 4 )
-      fg_pkt_mbuf = mkTestFrame4(ipv4_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv4, dst_ipv4);
-    else  // IPv6
-      fg_pkt_mbuf = mkTestFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv6, dst_ipv6);
-
-    // create backround Test Frame (always IPv6)
-    bg_pkt_mbuf = mkTestFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_bg, dst_bg);
-
-    // create Latency Test Frames (may be foreground frames and background frames as well)
-    struct rte_mbuf ** latency_frames = new struct rte_mbuf *[num_timestamps];
-    if ( !latency_frames )
-      rte_exit(EXIT_FAILURE, "Error: Tester can't allocate memory for latency frame pointers!\n");
-
-    uint64_t start_latency_frame = delay*frame_rate; // the ordinal numbert of the very first latency frame
-    for ( int i=0; i<num_timestamps; i++ )
-      if ( (start_latency_frame+i*frame_rate*latency_test_time/num_timestamps) % n  < m ) {
-        if ( ip_version == 4 )  // foreground frame, may be IPv4 or IPv6
-          latency_frames[i] = mkLatencyFrame4(ipv4_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv4, dst_ipv4, i);
-        else  // IPv6
-          latency_frames[i] = mkLatencyFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv6, dst_ipv6, i);
-      } else {
-        // background frame, must be IPv6
-        latency_frames[i] = mkLatencyFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_bg, dst_bg, i);
-      }
- 
-    // naive sender version: it is simple and fast
-    int latency_timestamp_no=0; // counter for the latency frames from 0 to num_timestamps-1
-    uint64_t send_next_latency_frame = start_latency_frame; // at what frame count to send the next latency frame 
-    for ( sent_frames = 0; sent_frames < frames_to_send; sent_frames++ ){ // Main cycle for the number of frames to send
-      while ( rte_rdtsc() < start_tsc+sent_frames*hz/frame_rate ); // Beware: an "empty" loop, and further three will come!
-      if ( unlikely( sent_frames == send_next_latency_frame ) ) {
-        // a latency frame is to be sent
-        while ( !rte_eth_tx_burst(eth_id, 0, &latency_frames[latency_timestamp_no], 1) ); // send latency frame
-        send_ts[latency_timestamp_no++]=rte_rdtsc();
-        send_next_latency_frame = start_latency_frame + latency_timestamp_no*frames_to_send_during_latency_test/num_timestamps; 
-      } else {
-        // normal test frame is to be sent
-        if ( sent_frames % n  < m )
-          while ( !rte_eth_tx_burst(eth_id, 0, &fg_pkt_mbuf, 1) ); // send foreground frame
-        else
-           while ( !rte_eth_tx_burst(eth_id, 0, &bg_pkt_mbuf, 1) ); // send background frame
-      }
-    } // this is the end of the sending cycle
-  } // end of optimized code for single flow
-  else {
-    // optimized code for multiple flows: foreground and background frames are generated for each flow and pointers are stored in arrays
-    // latency frames are also pre-generated and stored in an array
-    // num_dest_nets <= 256
-    struct rte_mbuf *fg_pkt_mbuf[256], *bg_pkt_mbuf[256]; // message buffers for fg. and bg. Test Frames
-    uint32_t curr_dst_ipv4;     // IPv4 destination address, which will be changed
-    in6_addr curr_dst_ipv6;     // foreground IPv6 destination address, which will be changed
-    in6_addr curr_dst_bg;       // backround IPv6 destination address, which will be changed
-    int i;                      // cycle variable for grenerating different destination network addresses
-    if ( ip_version == 4 )
-      curr_dst_ipv4 = *dst_ipv4;
-    else // IPv6
-      curr_dst_ipv6 = *dst_ipv6;
-    curr_dst_bg = *dst_bg;
-
-    for ( i=0; i<num_dest_nets; i++ ) {
-      // create foreground Test Frame
-      if ( ip_version == 4 ) {
-        ((uint8_t *)&curr_dst_ipv4)[2] = (uint8_t) i; // bits 16 to 23 of the IPv4 address are rewritten, like in 198.18.x.2
-        fg_pkt_mbuf[i] = mkTestFrame4(ipv4_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv4, &curr_dst_ipv4);
-      }
-      else { // IPv6
-        ((uint8_t *)&curr_dst_ipv6)[7] = (uint8_t) i; // bits 56 to 63 of the IPv6 address are rewritten, like in 2001:2:0:00xx::1
-        fg_pkt_mbuf[i] = mkTestFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv6, &curr_dst_ipv6);
-      }
-      // create backround Test Frame (always IPv6)
-      ((uint8_t *)&curr_dst_bg)[7] = (uint8_t) i; // see comment above
-      bg_pkt_mbuf[i] = mkTestFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_bg, &curr_dst_bg);
-    }
-
-    // random number infrastructure is taken from: https://en.cppreference.com/w/cpp/numeric/random/uniform_int_distribution
-    // MT64 is used because of https://medium.com/@odarbelaeze/how-competitive-are-c-standard-random-number-generators-f3de98d973f0
-    // thread_local is used on the basis of https://stackoverflow.com/questions/40655814/is-mersenne-twister-thread-safe-for-cpp
-    thread_local std::random_device rd;  //Will be used to obtain a seed for the random number engine
-    thread_local std::mt19937_64 gen(rd()); //Standard 64-bit mersenne_twister_engine seeded with rd()
-    std::uniform_int_distribution<int> uni_dis(0, num_dest_nets-1);     // uniform distribution in [0, num_dest_nets-1]
-
-    // create Latency Test Frames (may be foreground frames and background frames as well)
-    struct rte_mbuf ** latency_frames = new struct rte_mbuf *[num_timestamps];
-    if ( !latency_frames )
-      rte_exit(EXIT_FAILURE, "Error: Tester can't allocate memory for latency frame pointers!\n");
-
-    uint64_t start_latency_frame = delay*frame_rate; // the ordinal numbert of the very first latency frame
-    for ( int i=0; i<num_timestamps; i++ )
-      if ( (start_latency_frame+i*frame_rate*latency_test_time/num_timestamps) % n  < m ) {
-        if ( ip_version == 4 ) { 
-          // random IPv4 destination network
-          ((uint8_t *)&curr_dst_ipv4)[2] = (uint8_t) uni_dis(gen); // bits 16 to 23 of the IPv4 address are rewritten, like in 198.18.x.2
-          latency_frames[i] = mkLatencyFrame4(ipv4_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv4, &curr_dst_ipv4, i);
-        } else {
-          // random IPv6 destination network
-          ((uint8_t *)&curr_dst_ipv6)[7] = (uint8_t) i; // bits 56 to 63 of the IPv6 address are rewritten, like in 2001:2:0:00xx::1
-          latency_frames[i] = mkLatencyFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv6, &curr_dst_ipv6, i);
-        }
-      } else {
-        // background frame, must be IPv6, choose random network
-        ((uint8_t *)&curr_dst_bg)[7] = (uint8_t) i; // see comment above
-        latency_frames[i] = mkLatencyFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_bg, &curr_dst_bg, i);
-      }
-
-    // naive sender version: it is simple and fast
-    int latency_timestamp_no=0; // counter for the latency frames from 0 to num_timestamps-1
-    uint64_t send_next_latency_frame = start_latency_frame; // at what frame count to send the next latency frame
-    for ( sent_frames = 0; sent_frames < frames_to_send; sent_frames++ ){ // Main cycle for the number of frames to send
-      int index = uni_dis(gen); // index of the pre-generated frame (it will not be used, when a latency frame is sent)
-      while ( rte_rdtsc() < start_tsc+sent_frames*hz/frame_rate ); // Beware: an "empty" loop, and further two will come!
-      if ( unlikely( sent_frames == send_next_latency_frame ) ) {
-        // a latency frame is to be sent
-        while ( !rte_eth_tx_burst(eth_id, 0, &latency_frames[latency_timestamp_no], 1) ); // send latency frame
-        send_ts[latency_timestamp_no++]=rte_rdtsc();
-        send_next_latency_frame = start_latency_frame + latency_timestamp_no*frames_to_send_during_latency_test/num_timestamps;
-      } else {
-        // normal test frame is to be sent
-        if ( sent_frames % n  < m )
-          while ( !rte_eth_tx_burst(eth_id, 0, &fg_pkt_mbuf[index], 1) ); // send foreground frame
-        else
-           while ( !rte_eth_tx_burst(eth_id, 0, &bg_pkt_mbuf[index], 1) ); // send background frame
-      }
-    } // this is the end of the sending cycle
-  } // end of optimized code for multiple flows
-
-  // Now, we check the time
-  elapsed_seconds = (double)(rte_rdtsc()-start_tsc)/hz;
-  printf("Info: %s sender's sending took %3.10lf seconds.\n", side, elapsed_seconds);
-  if ( elapsed_seconds > duration*TOLERANCE )
-    rte_exit(EXIT_FAILURE, "%s sending exceeded the %3.10lf seconds limit, the test is invalid.\n", side, duration*TOLERANCE);
-  printf("%s frames sent: %lu\n", side, sent_frames);
+  // the Test Frames and the Latency Frames were pre-generated
+  latencyStamp stamper(p->latency_frames, p->send_ts, cp->num_timestamps, start_latency_frame, latency_test_time*frame_rate);
+  sendFrames(p, p->frames, &stamper);
   return 0;
 }
 
 // receives Test Frames for latency measurements including "num_timestamps" number of Latency frames
-// Offsets from the start of the Ethernet Frame:
-// EtherType: 6+6=12
-// IPv6 Next header: 14+6=20, UDP Data for IPv6: 14+40+8=62
-// IPv4 Protolcol: 14+9=23, UDP Data for IPv4: 14+20+8=42
+// the offsets of the fields are taken from the frame layouts (see frame.h)
 int receiveLatency(void *par) {
   // collecting input parameters:
   class receiverParametersLatency *p = (class receiverParametersLatency *)par;
@@ -317,39 +158,44 @@ int receiveLatency(void *par) {
   // further local variables
   int frames, i;
   struct rte_mbuf *pkt_mbufs[MAX_PKT_BURST]; // pointers for the mbufs of received frames
+  INSTR( lcoreInstruments ins; ) // data-plane instrumentation (if compiled in)
   uint16_t ipv4=htons(0x0800); // EtherType for IPv4 in Network Byte Order
   uint16_t ipv6=htons(0x86DD); // EtherType for IPv6 in Network Byte Order
   uint8_t identify[8]= { 'I', 'D', 'E', 'N', 'T', 'I', 'F', 'Y' };      // Identificion of the Test Frames
   uint64_t *id=(uint64_t *) identify;
   uint8_t identify_latency[8]= { 'I', 'd', 'e', 'n', 't', 'i', 'f', 'y' };      // Identificion of the Latency Frames
   uint64_t *id_lat=(uint64_t *) identify_latency;
+  uint64_t all_frames=0; // number of all frames received, the ones not matching the test signature are counted as foreign traffic
   uint64_t received=0;  // number of received frames
 
   while ( rte_rdtsc() < finish_receiving ){
+    INSTR( ins.t0 = rte_rdtsc() );
     frames = rte_eth_rx_burst(eth_id, 0, pkt_mbufs, MAX_PKT_BURST);
+    INSTR( ins.burst[frames]++ );
+    all_frames += frames;
     for (i=0; i < frames; i++){
       uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbufs[i], uint8_t *); // Access the Test Frame in the message buffer
       // check EtherType at offset 12: IPv6, IPv4, or anything else
-      if ( *(uint16_t *)&pkt[12]==ipv6 ) { /* IPv6 */
+      if ( *(uint16_t *)&pkt[layout6.ether_type]==ipv6 ) { /* IPv6 */
         /* check if IPv6 Next Header is UDP, and the first 8 bytes of UDP data is 'IDENTIFY' */
-        if ( likely( pkt[20]==17 && *(uint64_t *)&pkt[62]==*id ) )
+        if ( likely( pkt[layout6.proto]==17 && *(uint64_t *)&pkt[layout6.data]==*id ) )
           received++; // normal Test Frame
-        else if ( pkt[20]==17 && *(uint64_t *)&pkt[62]==*id_lat ) {
+        else if ( pkt[layout6.proto]==17 && *(uint64_t *)&pkt[layout6.data]==*id_lat ) {
           // Latency Frame
           uint64_t timestamp = rte_rdtsc(); // get a timestamp ASAP
-          int latency_frame_id = *(uint16_t *)&pkt[70]; 
+          int latency_frame_id = *(uint16_t *)&pkt[layout6.id]; 
           if ( latency_frame_id < 0 || latency_frame_id >= num_timestamps )
             rte_exit(EXIT_FAILURE, "Error: Latency Frame with invalid frame ID was received!\n"); // to avoid segmentation fault
           receive_ts[latency_frame_id] = timestamp;
           received++; // Latency Frame is also counted as Test Frame
         }
-      } else if ( *(uint16_t *)&pkt[12]==ipv4 ) { /* IPv4 */
-        if ( likely( pkt[23]==17 && *(uint64_t *)&pkt[42]==*id ) )
+      } else if ( *(uint16_t *)&pkt[layout4.ether_type]==ipv4 ) { /* IPv4 */
+        if ( likely( pkt[layout4.proto]==17 && *(uint64_t *)&pkt[layout4.data]==*id ) )
            received++; // normal Test Frame
-        else if ( pkt[23]==17 && *(uint64_t *)&pkt[42]==*id_lat ) {
+        else if ( pkt[layout4.proto]==17 && *(uint64_t *)&pkt[layout4.data]==*id_lat ) {
           // Latency Frame
           uint64_t timestamp = rte_rdtsc(); // get a timestamp ASAP
-          int latency_frame_id = *(uint16_t *)&pkt[50];
+          int latency_frame_id = *(uint16_t *)&pkt[layout4.id];
           if ( latency_frame_id < 0 || latency_frame_id >= num_timestamps )
             rte_exit(EXIT_FAILURE, "Error: Latency Frame with invalid frame ID was received!\n"); // to avoid segmentation fault
           receive_ts[latency_frame_id] = timestamp;
@@ -358,7 +204,10 @@ int receiveLatency(void *par) {
       }
       rte_pktmbuf_free(pkt_mbufs[i]);
     }
+    INSTR( if ( frames ) ins.busy_cycles += rte_rdtsc()-ins.t0 );
   }
+  INSTR( reportReceiverInstruments(&ins, side) );
+  printf("Info: %s foreign frames received: %lu\n", side, all_frames-received);
   printf("%s frames received: %lu\n", side, received);
   return received;
 }
@@ -366,19 +215,25 @@ int receiveLatency(void *par) {
 // performs latency measurement
 void Latency::measure(uint16_t leftport, uint16_t rightport) {
   uint64_t *left_send_ts, *right_send_ts, *left_receive_ts, *right_receive_ts; // pointers for timestamp arrays
+  senderParametersLatency *left_spars=0, *right_spars=0; // parameters of the active senders, they must exist until the senders finish
+
+  startPortStats(); // before anything is sent
 
   // set common parameters for senders
   senderCommonParametersLatency scp(ipv6_frame_size,ipv4_frame_size,frame_rate,duration,n,m,hz,start_tsc,delay,num_timestamps);
+  scp.max_lateness_tsc = hz*max_lateness/1000000;
+  scp.arrival_dist = arrival_dist;
+  scp.arrival_burst = arrival_burst;
+  scp.arrival_peak = arrival_peak;
 
   if ( forward ) {      // Left to right direction is active
 
-    // create dynamic arrays for timestamps
-    left_send_ts = new uint64_t[num_timestamps];
-    right_receive_ts = new uint64_t[num_timestamps];
+    // create dynamic arrays for timestamps on the NUMA nodes of the lcores writing them
+    // the receive timestamps are filled with 0 (will be used to chek, if frame with timestamp was received)
+    left_send_ts = (uint64_t *) rte_malloc_socket(0, num_timestamps*sizeof(uint64_t), 128, rte_lcore_to_socket_id(cpu_left_sender));
+    right_receive_ts = (uint64_t *) rte_zmalloc_socket(0, num_timestamps*sizeof(uint64_t), 128, rte_lcore_to_socket_id(cpu_right_receiver));
     if ( !left_send_ts || !right_receive_ts )
       rte_exit(EXIT_FAILURE, "Error: Tester can't allocate memory for timestamps!\n");
-    // fill with 0 (will be used to chek, if frame with timestamp was received)
-    memset(right_receive_ts, 0, num_timestamps*sizeof(uint64_t));
 
     // set individual parameters for the left sender
 
@@ -387,41 +242,62 @@ void Latency::measure(uint16_t leftport, uint16_t rightport) {
                &ipv6_left_real,&ipv6_right_real,&ipv6_left_virtual,&ipv6_right_virtual);
 
     // then, initialize the parameter class instance
-    senderParametersLatency spars(&scp,ip_left_version,pkt_pool_left_sender,leftport,"Forward",(ether_addr *)mac_left_dut,(ether_addr *)mac_left_tester,
-                                  ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_left_real,&ipv6_right_real,num_right_nets,left_send_ts);
-
-    // start left sender
-    if ( rte_eal_remote_launch(sendLatency, &spars, cpu_left_sender) )
-      std::cout << "Error: could not start Left Sender." << std::endl;
-
-    // set parameters for the right receiver
-    receiverParametersLatency rpars(finish_receiving,rightport,"Forward",num_timestamps,right_receive_ts);
+    left_spars = new senderParametersLatency(&scp,ip_left_version,pkt_pool_left_sender,leftport,"Forward",(ether_addr *)mac_left_dut,(ether_addr *)mac_left_tester,
+                                             ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_left_real,&ipv6_right_real,num_right_nets,left_send_ts);
 
-    // start right receiver
-    if ( rte_eal_remote_launch(receiveLatency, &rpars, cpu_right_receiver) )
-      std::cout << "Error: could not start Right Receiver." << std::endl;
+    // the Latency Frames are made by the idle right receiver, while the left sender makes the Test Frames
+    if ( rte_eal_remote_launch(mkLatencyFrames, left_spars, cpu_right_receiver) )
+      std::cout << "Error: could not start the pre-generation of the Forward Latency Frames." << std::endl;
   }
 
   if ( reverse ) {      // Right to Left direction is active
 
-    // create dynamic arrays for timestamps
-    right_send_ts = new uint64_t[num_timestamps];
-    left_receive_ts = new uint64_t[num_timestamps];
+    // create dynamic arrays for timestamps on the NUMA nodes of the lcores writing them
+    // the receive timestamps are filled with 0 (will be used to chek, if frame with timestamp was received)
+    right_send_ts = (uint64_t *) rte_malloc_socket(0, num_timestamps*sizeof(uint64_t), 128, rte_lcore_to_socket_id(cpu_right_sender));
+    left_receive_ts = (uint64_t *) rte_zmalloc_socket(0, num_timestamps*sizeof(uint64_t), 128, rte_lcore_to_socket_id(cpu_left_receiver));
     if ( !right_send_ts || !left_receive_ts )
       rte_exit(EXIT_FAILURE, "Error: Tester can't allocate memory for timestamps!\n");
-    // fill with 0 (will be used to chek, if frame with timestamp was received)
-    memset(left_receive_ts, 0, num_timestamps*sizeof(uint64_t));
 
     // first, collect the appropriate values dependig on the IP versions
     ipQuad ipq(ip_right_version,ip_left_version,&ipv4_right_real,&ipv4_left_real,&ipv4_right_virtual,&ipv4_left_virtual,
                &ipv6_right_real,&ipv6_left_real,&ipv6_right_virtual,&ipv6_left_virtual);
 
     // then, initialize the parameter class instance
-    senderParametersLatency spars(&scp,ip_right_version,pkt_pool_right_sender,rightport,"Reverse",(ether_addr *)mac_right_dut,(ether_addr *)mac_right_tester,
-                           ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_right_real,&ipv6_left_real,num_left_nets,right_send_ts);
+    right_spars = new senderParametersLatency(&scp,ip_right_version,pkt_pool_right_sender,rightport,"Reverse",(ether_addr *)mac_right_dut,(ether_addr *)mac_right_tester,
+                                              ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_right_real,&ipv6_left_real,num_left_nets,right_send_ts);
+
+    // the Latency Frames are made by the idle left receiver, while the right sender makes the Test Frames
+    if ( rte_eal_remote_launch(mkLatencyFrames, right_spars, cpu_left_receiver) )
+      std::cout << "Error: could not start the pre-generation of the Reverse Latency Frames." << std::endl;
+  }
+
+  // the Test Frames are pre-generated in parallel, and the senders start START_DELAY after all frames are ready
+  pregenerateFrames(this, left_spars, right_spars, latencyStamp::copies, mkTestFrame4, mkTestFrame6);
+  if ( forward )
+    rte_eal_wait_lcore(cpu_right_receiver);
+  if ( reverse )
+    rte_eal_wait_lcore(cpu_left_receiver);
+  setStartTime();
+  scp.start_tsc = start_tsc;
+  startRefDut();
+
+  if ( forward ) {
+    // start left sender
+    if ( rte_eal_remote_launch(sendLatency, left_spars, cpu_left_sender) )
+      std::cout << "Error: could not start Left Sender." << std::endl;
 
+    // set parameters for the right receiver
+    receiverParametersLatency rpars(finish_receiving,rightport,"Forward",num_timestamps,right_receive_ts);
+
+    // start right receiver
+    if ( rte_eal_remote_launch(receiveLatency, &rpars, cpu_right_receiver) )
+      std::cout << "Error: could not start Right Receiver." << std::endl;
+  }
+
+  if ( reverse ) {
     // start right sender
-    if (rte_eal_remote_launch(sendLatency, &spars, cpu_right_sender) )
+    if (rte_eal_remote_launch(sendLatency, right_spars, cpu_right_sender) )
       std::cout << "Error: could not start Right Sender." << std::endl;
 
     // set parameters for the left receiver
@@ -443,18 +319,32 @@ void Latency::measure(uint16_t leftport, uint16_t rightport) {
     rte_eal_wait_lcore(cpu_right_sender);
     rte_eal_wait_lcore(cpu_left_receiver);
   }
+  if ( left_spars )
+    delete [] left_spars->latency_frames;
+  if ( right_spars )
+    delete [] right_spars->latency_frames;
+  deleteSenderParameters(left_spars);
+  deleteSenderParameters(right_spars);
+  finishRefDut();
+  finishPortStats();
 
   // Process the timestamps
   int penalty=1000*(duration-delay)+global_timeout; // latency to be reported for lost timestamps, expressed in milliseconds
-  if ( forward )
+  if ( forward ) {
     evaluateLatency(num_timestamps, left_send_ts, right_receive_ts, hz, penalty, "Forward"); 
-  if ( reverse )
+    rte_free(left_send_ts);
+    rte_free(right_receive_ts);
+  }
+  if ( reverse ) {
     evaluateLatency(num_timestamps, right_send_ts, left_receive_ts, hz, penalty, "Reverse"); 
+    rte_free(right_send_ts);
+    rte_free(left_receive_ts);
+  }
 
   std::cout << "Info: Test finished." << std::endl;
 }
 
-senderCommonParametersLatency::senderCommonParametersLatency(uint16_t ipv6_frame_size_, uint16_t ipv4_frame_size_, uint32_t frame_rate_, uint16_t duration_,
+senderCommonParametersLatency::senderCommonParametersLatency(uint16_t ipv6_frame_size_, uint16_t ipv4_frame_size_, uint32_t frame_rate_, uint32_t duration_,
                                                              uint32_t n_, uint32_t m_, uint64_t hz_, uint64_t start_tsc_, 
                                                              uint16_t delay_, uint16_t num_timestamps_) :
   senderCommonParameters(ipv6_frame_size_,ipv4_frame_size_,frame_rate_,duration_,n_,m_,hz_,start_tsc_) {
@@ -468,6 +358,7 @@ senderParametersLatency::senderParametersLatency(class senderCommonParameters *c
                                                   uint16_t num_dest_nets_, uint64_t *send_ts_) :
   senderParameters(cp_,ip_version_,pkt_pool_,eth_id_,side_,dst_mac_,src_mac_,src_ipv4_,dst_ipv4_,src_ipv6_,dst_ipv6_,src_bg_,dst_bg_,num_dest_nets_) {
   send_ts = send_ts_;
+  latency_frames = 0;
 }
     
 receiverParametersLatency::receiverParametersLatency(uint64_t finish_receiving_, uint8_t eth_id_, const char *side_, 
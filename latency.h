@@ -27,19 +27,19 @@ public:
   uint16_t delay;               // time period while frames are sent, but no timestamps are used; then timestaps are used in the "duration-delay" length interval
   uint16_t num_timestamps;      // number of timestamps used, 1-50000 is accepted, RFC 8219 requires at least 500, RFC 2544 requires 1
 
-  Latency() : Throughput() { }; // default constructor
+  Latency() : Throughput() { program = "lat"; }; // default constructor
   int readCmdLine(int argc, const char *argv[]);	// reads further two arguments
   virtual int senderPoolSize(int numDestNets);		// adds num_timestamps, too
+  virtual uint64_t timestampMemory();			// send and receive timestamps of the Latency Frames
 
   // perform latency measurement
   void measure(uint16_t leftport, uint16_t rightport);
 };
 
-// functions to create Latency Frames (and their parts)
+// functions to create Latency Frames
 struct rte_mbuf *mkLatencyFrame4(uint16_t length, rte_mempool *pkt_pool, const char *side,
                                 const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
                                 const uint32_t *src_ip, const uint32_t *dst_ip, uint16_t id);
-void mkDataLatency(uint8_t *data, uint16_t length, uint16_t latency_frame_id);
 struct rte_mbuf *mkLatencyFrame6(uint16_t length, rte_mempool *pkt_pool, const char *side,
                                 const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
                                 const struct in6_addr *src_ip, const struct in6_addr *dst_ip, uint16_t id);
@@ -49,7 +49,7 @@ public:
   uint16_t delay; 
   uint16_t num_timestamps;
 
-  senderCommonParametersLatency(uint16_t ipv6_frame_size_, uint16_t ipv4_frame_size_, uint32_t frame_rate_, uint16_t duration_,
+  senderCommonParametersLatency(uint16_t ipv6_frame_size_, uint16_t ipv4_frame_size_, uint32_t frame_rate_, uint32_t duration_,
                                 uint32_t n_, uint32_t m_, uint64_t hz_, uint64_t start_tsc_,
                                 uint16_t delay_, uint16_t num_timestamps_);
 };
@@ -57,6 +57,7 @@ public:
 class senderParametersLatency : public senderParameters {
 public:
   uint64_t *send_ts;
+  struct rte_mbuf **latency_frames;	// pre-generated Latency Frames (set by mkLatencyFrames())
   senderParametersLatency(class senderCommonParameters *cp_, int ip_version_, rte_mempool *pkt_pool_, uint8_t eth_id_, const char *side_,
                           struct ether_addr *dst_mac_,  struct ether_addr *src_mac_,  uint32_t *src_ipv4_, uint32_t *dst_ipv4_,
                           struct in6_addr *src_ipv6_, struct in6_addr *dst_ipv6_, struct in6_addr *src_bg_, struct in6_addr *dst_bg_,
@@ -70,6 +71,13 @@ class receiverParametersLatency : public receiverParameters {
   receiverParametersLatency(uint64_t finish_receiving_, uint8_t eth_id_, const char *side_, uint16_t num_timestamps_, uint64_t *receive_ts_);
 };
 
+// pre-generates the Latency Frames of a sender
+int mkLatencyFrames(void *par);
+
+// send and receive Test Frames and Latency Frames
+int sendLatency(void *par);
+int receiveLatency(void *par);
+
 void evaluateLatency(uint16_t num_timestamps, uint64_t *send_ts, uint64_t *receive_ts, uint64_t hz, int penalty, const char *side);
 
 #endif
@@ -0,0 +1,57 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <iostream>
+#include "live.h"
+
+// An existing segment is reused (and not unlinked), thus a running siitperf-top keeps its valid mapping,
+// when the Tester is executed again and again by the measurement scripts.
+livePage *createLivePage(const char *name) {
+  int fd;	// file descriptor of the shared memory segment
+  void *page;	// mapping of the segment
+
+  fd = shm_open(name, O_CREAT|O_RDWR, 0644);
+  if ( fd < 0 ) {
+    std::cerr << "Error: Cannot open shared memory segment '" << name << "' for the live counters." << std::endl;
+    return 0;
+  }
+  if ( ftruncate(fd, sizeof(livePage)) < 0 ) {
+    std::cerr << "Error: Cannot set the size of shared memory segment '" << name << "'." << std::endl;
+    close(fd);
+    return 0;
+  }
+  page = mmap(0, sizeof(livePage), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);	// the mapping remains valid
+  if ( page == MAP_FAILED ) {
+    std::cerr << "Error: Cannot map shared memory segment '" << name << "'." << std::endl;
+    return 0;
+  }
+  livePage *live = reinterpret_cast<livePage *>(page);
+  if ( live->magic != LIVE_MAGIC ) {
+    memset(page, 0, sizeof(livePage));
+    live->magic = LIVE_MAGIC;
+  }
+  return live;
+}
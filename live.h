@@ -0,0 +1,62 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIVE_H_INCLUDED
+#define LIVE_H_INCLUDED
+
+// The live counters page is a named POSIX shared memory segment, which is updated by the senders and receivers
+// during the test, and which can be watched by siitperf-top (or anything else) from outside of the Tester.
+// This header is included by siitperf-top, too, thus it MUST NOT depend on DPDK.
+
+#include <stdint.h>
+
+#define LIVE_MAGIC 0x4556494c46524550ULL	/* "PERFLIVE" in little endian, identifies the page */
+#define LIVE_CACHE_LINE 64			/* counters of different lcores are kept in different cache lines */
+#define LIVE_UPDATE_MASK 0xff			/* senders publish their counters after every 256 frames */
+
+// the roles of the lcores, used as index in livePage::role
+enum liveRole { LIVE_LEFT_SENDER, LIVE_RIGHT_RECEIVER, LIVE_RIGHT_SENDER, LIVE_LEFT_RECEIVER, LIVE_ROLES };
+
+// counters of a single sender or receiver, written by that lcore only
+struct alignas(LIVE_CACHE_LINE) liveCounters {
+  volatile uint64_t sent;		// number of frames sent
+  volatile uint64_t received;		// number of frames received
+  volatile uint64_t tx_retries;		// number of unsuccessful rte_eth_tx_burst() calls
+  volatile uint64_t late_frames;	// number of frames started later than their scheduled time plus one inter-frame time
+  volatile uint64_t tx_lag;		// how late (in TSC) the last published frame was started compared to its schedule
+};
+
+// the whole page, the header is written by the main lcore at the beginning of each test
+struct livePage {
+  volatile uint64_t magic;		// LIVE_MAGIC, if the page is valid
+  volatile uint64_t trial;		// incremented at the beginning of each test
+  volatile uint64_t hz;			// number of TSC cycles per second
+  volatile uint64_t start_tsc;		// sending of the test frames begins at this time
+  volatile uint64_t finish_receiving;	// receiving of the test frames ends at this time
+  volatile uint32_t frame_rate;		// frames per second
+  volatile uint32_t duration;		// test duration in seconds
+  volatile uint32_t active;		// bit i is set, if role i is active
+  liveCounters role[LIVE_ROLES];	// counters of the senders and receivers
+};
+
+// creates (or reuses) and maps the named shared memory segment for writing; returns NULL on failure
+livePage *createLivePage(const char *name);
+
+#endif
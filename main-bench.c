@@ -0,0 +1,321 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// siitperf-bench: microbenchmarks of the hot components of siitperf, each of them is measured in isolation
+// Usage: siitperf-bench <IPv6 frame size> [save]
+// The lcores are taken from siitperf.conf: CPU-L-Send runs the senders and feeders, CPU-R-Recv runs the receivers.
+// The results are compared with the baseline file, and they replace it, if "save" is given.
+
+#include "defines.h"
+#include "includes.h"
+#include "throughput.h"
+#include "latency.h"
+#include "pdv.h"
+#include "frame.h"
+#include "pacing.h"
+#include "timeline.h"
+#include "live.h"
+#include "instrument.h"
+#include "sender.h"
+
+// result of a benchmark
+struct benchResult {
+  const char *name;	// name of the component
+  double ns;		// nanoseconds per frame (or per timestamp)
+};
+
+// parameters of the feeder, which keeps the RX queue of a receiver full
+class feederParameters {
+public:
+  uint16_t port;			// the frames are sent here
+  struct rte_mbuf *frames[MAX_PKT_BURST];	// they are sent again and again
+  uint64_t finish_tsc;			// the feeder stops at this time
+};
+
+// sends the same burst of frames until finish_tsc (the receiver frees them, but nobody allocates them from the pool)
+int feed(void *par) {
+  class feederParameters *p = (class feederParameters *)par;
+  while ( rte_rdtsc() < p->finish_tsc )
+    rte_eth_tx_burst(p->port, 0, p->frames, MAX_PKT_BURST);
+  return 0;
+}
+
+// builds and frees BENCH_BUILDS frames by the selected frame builder
+// return: ns/frame
+double benchBuilder(Throughput *t, rte_mempool *pool, int builder) {
+  struct rte_mbuf *m=0;
+  uint64_t start_tsc;
+  int i;
+
+  start_tsc = rte_rdtsc();
+  for ( i=0; i<BENCH_BUILDS; i++ ) {
+    switch ( builder ) {
+      case 0:
+        m = mkTestFrame4(t->ipv4_frame_size, pool, "Bench", (ether_addr *)t->mac_left_dut, (ether_addr *)t->mac_left_tester,
+                         &t->ipv4_left_real, &t->ipv4_right_real);
+        break;
+      case 1:
+        m = mkTestFrame6(t->ipv6_frame_size, pool, "Bench", (ether_addr *)t->mac_left_dut, (ether_addr *)t->mac_left_tester,
+                         &t->ipv6_left_real, &t->ipv6_right_real);
+        break;
+      case 2:
+        m = mkLatencyFrame4(t->ipv4_frame_size, pool, "Bench", (ether_addr *)t->mac_left_dut, (ether_addr *)t->mac_left_tester,
+                            &t->ipv4_left_real, &t->ipv4_right_real, 0);
+        break;
+      case 3:
+        m = mkLatencyFrame6(t->ipv6_frame_size, pool, "Bench", (ether_addr *)t->mac_left_dut, (ether_addr *)t->mac_left_tester,
+                            &t->ipv6_left_real, &t->ipv6_right_real, 0);
+        break;
+      case 4:
+        m = mkPdvFrame4(t->ipv4_frame_size, pool, "Bench", (ether_addr *)t->mac_left_dut, (ether_addr *)t->mac_left_tester,
+                        &t->ipv4_left_real, &t->ipv4_right_real);
+        break;
+      case 5:
+        m = mkPdvFrame6(t->ipv6_frame_size, pool, "Bench", (ether_addr *)t->mac_left_dut, (ether_addr *)t->mac_left_tester,
+                        &t->ipv6_left_real, &t->ipv6_right_real);
+        break;
+    }
+    rte_pktmbuf_free(m);
+  }
+  return 1e9*(rte_rdtsc()-start_tsc)/t->hz/BENCH_BUILDS;
+}
+
+// parameters of the sending cycle benchmark
+class sendBenchParameters {
+public:
+  senderParameters *p;	// the sender (its frames are sent to a net_null port)
+  uint64_t elapsed;	// result: TSC cycles used for sending the frames
+};
+
+// the real sending cycle of send(): sendFrames() chooses the same instantiation of sendCycle() as for a normal test,
+// but start_tsc is in the past, thus the pacer never waits
+int sendBench(void *par) {
+  class sendBenchParameters *b = (class sendBenchParameters *)par;
+  noStamp stamper;
+  uint64_t start_tsc = rte_rdtsc();
+
+  sendFrames(b->p, b->p->frames, &stamper);
+  b->elapsed = rte_rdtsc()-start_tsc;
+  return 0;
+}
+
+// runs a receiver on the Right port for BENCH_SECONDS, while the feeder keeps its RX queue full
+// return: ns/frame
+double benchReceiver(Throughput *t, feederParameters *fp, int (*receiver)(void *), receiverParameters *rp) {
+  int received;
+
+  if ( rte_eal_remote_launch(feed, fp, t->cpu_left_sender) )
+    rte_exit(EXIT_FAILURE, "Error: could not start the feeder.\n");
+  if ( rte_eal_remote_launch(receiver, rp, t->cpu_right_receiver) )
+    rte_exit(EXIT_FAILURE, "Error: could not start the receiver.\n");
+  rte_eal_wait_lcore(t->cpu_left_sender);
+  received = rte_eal_wait_lcore(t->cpu_right_receiver);
+  if ( received <= 0 )
+    rte_exit(EXIT_FAILURE, "Error: the receiver did not receive any frames.\n");
+  return 1e9*BENCH_SECONDS/received;
+}
+
+// compares the results with the baseline, and saves them, if requested
+// return: the number of regressions
+int compareBaseline(benchResult *results, int num_results, uint16_t frame_size, int save) {
+  FILE *f;		// file descriptor
+  char line[LINELEN+1];	// buffer for reading a line of the baseline file
+  char name[LINELEN+1];	// name of the component in the current line
+  uint16_t size;	// frame size in the current line
+  double ns;		// result in the current line
+  std::vector<std::string> others;	// lines for other frame sizes (they are kept when saving)
+  int i, regressions=0;
+
+  printf("%-16s %12s %12s %12s %8s\n", "component", "ns/frame", "Mfps/core", "baseline", "change");
+  for ( i=0; i<num_results; i++ ) {
+    double baseline=0;
+    if ( (f=fopen(BENCHFILE,"r")) ) {
+      while ( fgets(line, LINELEN+1, f) )
+        if ( sscanf(line, "%hu %100s %lf", &size, name, &ns) == 3 && size == frame_size && !strcmp(name, results[i].name) )
+          baseline = ns;
+      fclose(f);
+    }
+    if ( baseline ) {
+      printf("%-16s %12.2lf %12.3lf %12.2lf %+7.1lf%%\n", results[i].name, results[i].ns, 1000.0/results[i].ns, baseline,
+             100.0*(results[i].ns-baseline)/baseline);
+      if ( results[i].ns > BENCH_TOLERANCE*baseline ) {
+        printf("Warning: %s is %.1lf%% slower than its baseline!\n", results[i].name, 100.0*(results[i].ns-baseline)/baseline);
+        regressions++;
+      }
+    } else {
+      printf("%-16s %12.2lf %12.3lf %12s %8s\n", results[i].name, results[i].ns, 1000.0/results[i].ns, "-", "-");
+    }
+  }
+  if ( !save )
+    return regressions;
+
+  if ( (f=fopen(BENCHFILE,"r")) ) {
+    while ( fgets(line, LINELEN+1, f) )
+      if ( sscanf(line, "%hu", &size) == 1 && size != frame_size )
+        others.push_back(line);
+    fclose(f);
+  }
+  if ( !(f=fopen(BENCHFILE,"w")) )
+    rte_exit(EXIT_FAILURE, "Error: Cannot write the baseline file '%s'.\n", BENCHFILE);
+  for ( auto &l : others )
+    fputs(l.c_str(), f);
+  for ( i=0; i<num_results; i++ )
+    fprintf(f, "%hu %s %.2lf\n", frame_size, results[i].name, results[i].ns);
+  fclose(f);
+  std::cout << "Info: The results were saved as the baseline for frame size " << frame_size << "." << std::endl;
+  return regressions;
+}
+
+int main(int argc, const char **argv) {
+  class Throughput tester;
+  benchResult results[16];	// results of the benchmarks
+  int num_results=0;		// number of the results
+  rte_mempool *pool;		// for the frames of the benchmarks
+  uint16_t null_port;		// port ID of the net_null port
+  struct rte_eth_conf cfg_port;	// for configuring the net_null port
+  feederParameters fp;		// parameters of the feeder
+  uint64_t start_tsc;		// start of the evaluator benchmarks
+  int i;			// cycle variable
+  static const char *builders[] = { "mkTestFrame4", "mkTestFrame6", "mkLatencyFrame4", "mkLatencyFrame6", "mkPdvFrame4", "mkPdvFrame6" };
+
+  if ( tester.readConfigFile(CONFIGFILE) < 0 )
+    return -1;
+  if ( argc < 2 || sscanf(argv[1], "%hu", &tester.ipv6_frame_size) != 1 || tester.ipv6_frame_size < 84 || tester.ipv6_frame_size > 1518 ) {
+    std::cerr << "Usage: siitperf-bench <IPv6 frame size (84-1518)> [save]" << std::endl;
+    return -1;
+  }
+  // only the Left Sender and Right Receiver lcores are used with two net_ring ports connected back to back
+  tester.ipv4_frame_size = tester.ipv6_frame_size-20;
+  tester.forward = 1;
+  tester.reverse = 0;
+  tester.ring_loopback = 1;
+  tester.cpu_ref_dut = -1;
+  tester.live_page_name[0] = 0;
+  tester.frame_rate = 1;
+  tester.duration = 1;
+  tester.global_timeout = 0;
+  tester.n = tester.m = 2;
+  if ( tester.init(argv[0],LEFTPORT,RIGHTPORT) < 0 )
+     return -1;
+
+  pool = rte_pktmbuf_pool_create("pp_bench", 2*MAX_PKT_BURST + PKTPOOL_CACHE + 100, PKTPOOL_CACHE, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+                                 rte_lcore_to_socket_id(tester.cpu_left_sender));
+  if ( !pool )
+    rte_exit(EXIT_FAILURE, "Error: Cannot create packet pool for the benchmarks.\n");
+
+  // frame builders
+  for ( i=0; i<6; i++ ) {
+    results[num_results].name = builders[i];
+    results[num_results++].ns = benchBuilder(&tester, pool, i);
+  }
+
+  // the frames of the loop benchmarks are built in advance, because net_null and the receivers free them back to the pool,
+  // thus the pool must not be used for allocation after the first one is sent
+  struct rte_mbuf *fg, *bg;			// Test Frames
+  struct rte_mbuf *lat4, *lat6, *pdv4, *pdv6;	// Latency and PDV Frames
+  fg = mkTestFrame4(tester.ipv4_frame_size, pool, "Bench", (ether_addr *)tester.mac_left_dut, (ether_addr *)tester.mac_left_tester,
+                       &tester.ipv4_left_real, &tester.ipv4_right_real);
+  bg = mkTestFrame6(tester.ipv6_frame_size, pool, "Bench", (ether_addr *)tester.mac_left_dut, (ether_addr *)tester.mac_left_tester,
+                       &tester.ipv6_left_real, &tester.ipv6_right_real);
+  lat4 = mkLatencyFrame4(tester.ipv4_frame_size, pool, "Bench", (ether_addr *)tester.mac_left_dut, (ether_addr *)tester.mac_left_tester,
+                         &tester.ipv4_left_real, &tester.ipv4_right_real, 0);
+  lat6 = mkLatencyFrame6(tester.ipv6_frame_size, pool, "Bench", (ether_addr *)tester.mac_left_dut, (ether_addr *)tester.mac_left_tester,
+                         &tester.ipv6_left_real, &tester.ipv6_right_real, 0);
+  pdv4 = mkPdvFrame4(tester.ipv4_frame_size, pool, "Bench", (ether_addr *)tester.mac_left_dut, (ether_addr *)tester.mac_left_tester,
+                     &tester.ipv4_left_real, &tester.ipv4_right_real);
+  pdv6 = mkPdvFrame6(tester.ipv6_frame_size, pool, "Bench", (ether_addr *)tester.mac_left_dut, (ether_addr *)tester.mac_left_tester,
+                     &tester.ipv6_left_real, &tester.ipv6_right_real);
+
+  // sending cycle on a net_null port
+  memset(&cfg_port, 0, sizeof(cfg_port));
+  if ( rte_vdev_init("net_null0", NULL) || rte_eth_dev_get_port_by_name("net_null0", &null_port) ||
+       rte_eth_dev_configure(null_port, 1, 1, &cfg_port) < 0 ||
+       rte_eth_tx_queue_setup(null_port, 0, PORT_TX_QUEUE_SIZE, rte_eth_dev_socket_id(null_port), NULL) < 0 ||
+       rte_eth_rx_queue_setup(null_port, 0, PORT_RX_QUEUE_SIZE, rte_eth_dev_socket_id(null_port), NULL, pool) < 0 ||
+       rte_eth_dev_start(null_port) < 0 )
+    rte_exit(EXIT_FAILURE, "Error: Cannot set up the net_null port.\n");
+  // all frames are scheduled within the second before the start, the long duration only keeps finishSending() from
+  // declaring the test invalid; 90% of the frames are foreground frames as with the default n and m
+  senderCommonParameters scp(tester.ipv6_frame_size, tester.ipv4_frame_size, BENCH_FRAMES, 3600, 10, 9, tester.hz, rte_rdtsc()-tester.hz);
+  scp.frames_to_send = BENCH_FRAMES;
+  senderParameters spars(&scp, 4, pool, null_port, "Bench", (ether_addr *)tester.mac_left_dut, (ether_addr *)tester.mac_left_tester,
+                         &tester.ipv4_left_real, &tester.ipv4_right_real, &tester.ipv6_left_real, &tester.ipv6_right_real,
+                         &tester.ipv6_left_real, &tester.ipv6_right_real, 1);
+  senderFrames frames;
+  frames.num_sizes = frames.num_flows = frames.copies = 1;
+  frames.fg = new struct rte_mbuf *[1] { fg };
+  frames.bg = new struct rte_mbuf *[1] { bg };
+  spars.frames = &frames;
+  sendBenchParameters sb;
+  sb.p = &spars;
+  if ( rte_eal_remote_launch(sendBench, &sb, tester.cpu_left_sender) )
+    rte_exit(EXIT_FAILURE, "Error: could not start the sending cycle.\n");
+  rte_eal_wait_lcore(tester.cpu_left_sender);
+  results[num_results].name = "sendCycle";
+  results[num_results++].ns = 1e9*sb.elapsed/tester.hz/BENCH_FRAMES;
+
+  // receivers: half of the frames are IPv4, half of them are IPv6, the Latency and PDV Frames have ID 0
+  fp.port = LEFTPORT;
+  for ( i=0; i<MAX_PKT_BURST; i++ )
+    fp.frames[i] = i%2 ? fg : bg;
+  fp.finish_tsc = rte_rdtsc()+tester.hz*BENCH_SECONDS;
+  receiverParameters rpars(fp.finish_tsc, RIGHTPORT, "Bench");
+  results[num_results].name = "receive";
+  results[num_results++].ns = benchReceiver(&tester, &fp, receive, &rpars);
+
+  uint64_t receive_ts[1];	// for the single Latency Frame ID
+  fp.frames[0] = lat4;
+  fp.frames[1] = lat6;
+  fp.finish_tsc = rte_rdtsc()+tester.hz*BENCH_SECONDS;
+  receiverParametersLatency rpars_lat(fp.finish_tsc, RIGHTPORT, "Bench", 1, receive_ts);
+  results[num_results].name = "receiveLatency";
+  results[num_results++].ns = benchReceiver(&tester, &fp, receiveLatency, &rpars_lat);
+
+  uint64_t *pdv_receive_ts;	// allocated by receivePdv()
+  for ( i=0; i<MAX_PKT_BURST; i++ )
+    fp.frames[i] = i%2 ? pdv4 : pdv6;
+  fp.finish_tsc = rte_rdtsc()+tester.hz*BENCH_SECONDS;
+  receiverParametersPdv rpars_pdv(fp.finish_tsc, RIGHTPORT, "Bench", 1, 0, &pdv_receive_ts);
+  results[num_results].name = "receivePdv";
+  results[num_results++].ns = benchReceiver(&tester, &fp, receivePdv, &rpars_pdv);
+  rte_free(pdv_receive_ts);
+
+  // evaluators on synthetic timestamps: constant rate, random delays between 1 and 1.5 million TSC cycles, 0.1% loss
+  uint64_t *send_ts = new uint64_t[BENCH_TIMESTAMPS];
+  uint64_t *recv_ts = new uint64_t[BENCH_TIMESTAMPS];
+  std::mt19937_64 gen(0);
+  std::uniform_int_distribution<uint64_t> uni_dis(1000000, 1500000);
+  for ( i=0; i<BENCH_TIMESTAMPS; i++ ) {
+    send_ts[i] = 1000000 + i*1000;
+    recv_ts[i] = i % 1000 ? send_ts[i]+uni_dis(gen) : 0;
+  }
+  start_tsc = rte_rdtsc();
+  evaluateLatency(50000, send_ts, recv_ts, tester.hz, 2000, "Bench");
+  results[num_results].name = "evaluateLatency";
+  results[num_results++].ns = 1e9*(rte_rdtsc()-start_tsc)/tester.hz/50000;
+  start_tsc = rte_rdtsc();
+  evaluatePdv(BENCH_TIMESTAMPS, send_ts, recv_ts, tester.hz, 0, 2000, "Bench");
+  results[num_results].name = "evaluatePdv";
+  results[num_results++].ns = 1e9*(rte_rdtsc()-start_tsc)/tester.hz/BENCH_TIMESTAMPS;
+  delete [] send_ts;
+  delete [] recv_ts;
+
+  return compareBaseline(results, num_results, tester.ipv6_frame_size, argc > 2 && !strcmp(argv[2], "save")) ? 1 : 0;
+}
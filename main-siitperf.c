@@ -0,0 +1,146 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// siitperf: a single binary for all types of measurements, which can be chosen for each trial at runtime
+// Usage: siitperf <mode> <IPv6 frame size> <frame rate> <duration> <global timeout> <n> <m> [<mode specific parameters>]
+//        siitperf (without parameters: the trials are read from the standard input, one per line, in the same format)
+// Modes: tp: throughput or frame loss rate, lat: latency (<delay> <number of timestamps>), pdv: PDV,
+//        fto: throughput with frame timeout (<frame timeout>), b2b: back-to-back frames (<train length>),
+//        soak: long-duration soak test (<summary interval>), recovery: system recovery test (<overload time>)
+// All trials of a session are executed after a single initialization of the EAL and the ports.
+
+#include "defines.h"
+#include "includes.h"
+#include "throughput.h"
+#include "latency.h"
+#include "pdv.h"
+#include "b2b.h"
+#include "soak.h"
+#include "recovery.h"
+
+#define MAX_TRIAL_ARGS 12	/* maximum number of the words of a trial */
+
+// performs a trial of type T in the session: the parameters of the trial are checked, then the measurement is done
+template <class T>
+int runTrial(Throughput *session, int argc, const char **argv, int restart) {
+  T trial;
+
+  trial.adopt(*session);
+  if ( trial.readCmdLine(argc, argv) < 0 )
+    return -1;
+  if ( trial.prepareTrial(LEFTPORT, RIGHTPORT, restart) < 0 )
+    return -2;
+  // the session keeps the new sender pools (and the pool of the reference DUT), they are freed before the next trial
+  session->pkt_pool_left_sender = trial.pkt_pool_left_sender;
+  session->pkt_pool_right_sender = trial.pkt_pool_right_sender;
+  session->pkt_pool_ref_dut = trial.pkt_pool_ref_dut;
+  session->imp_queue_size = trial.imp_queue_size;
+  trial.measure(LEFTPORT,RIGHTPORT);
+  return 0;
+}
+
+// performs a trial given by its words: the first one is the mode, the others are the parameters of siitperf-tp, -lat or -pdv
+// return: 0: success, -1: invalid trial, -2: fatal error
+int trial(Throughput *session, int words, const char **word, int restart) {
+  const char *argv[MAX_TRIAL_ARGS+2];	// command line for readCmdLine()
+  int argc, i;
+
+  if ( words < 1 ) {
+    std::cerr << "Input Error: Empty trial." << std::endl;
+    return -1;
+  }
+  argv[0] = session->program;
+  for ( i=1; i<words; i++ )
+    argv[i] = word[i];
+  argc = words;
+  if ( !strcmp(word[0], "tp") && argc == 7 )
+    return runTrial<Throughput>(session, argc, argv, restart);
+  if ( !strcmp(word[0], "lat") && argc == 9 )
+    return runTrial<Latency>(session, argc, argv, restart);
+  if ( !strcmp(word[0], "pdv") && argc == 7 ) {
+    argv[argc++] = "0"; // frame timeout 0 means PDV measurement
+    return runTrial<Pdv>(session, argc, argv, restart);
+  }
+  if ( !strcmp(word[0], "fto") && argc == 8 ) {
+    if ( !strcmp(argv[7], "0") ) {
+      std::cerr << "Input Error: Frame timeout must be positive for throughput with frame timeout." << std::endl;
+      return -1;
+    }
+    return runTrial<Pdv>(session, argc, argv, restart);
+  }
+  if ( !strcmp(word[0], "b2b") && argc == 8 )
+    return runTrial<BackToBack>(session, argc, argv, restart);
+  if ( !strcmp(word[0], "soak") && argc == 8 )
+    return runTrial<Soak>(session, argc, argv, restart);
+  if ( !strcmp(word[0], "recovery") && argc == 8 )
+    return runTrial<Recovery>(session, argc, argv, restart);
+  std::cerr << "Input Error: Unknown mode '" << word[0] << "' or wrong number of parameters." << std::endl;
+  return -1;
+}
+
+int main(int argc, const char **argv) {
+  class Throughput session;
+  char line[LINELEN+1];			// a line of the standard input
+  const char *word[MAX_TRIAL_ARGS+1];	// words of the line
+  int words;				// number of the words
+  int trials=0;				// number of the trials performed, the ports are restarted before all but the first one
+  int result;				// result of the last trial
+
+  session.program = "siitperf";
+  if ( session.readConfigFile(CONFIGFILE) < 0 )
+    return -1;
+  if ( argc > 1 && argc-1 > MAX_TRIAL_ARGS ) {
+    std::cerr << "Input Error: Too many command line arguments." << std::endl;
+    return -1;
+  }
+  // the frame size, the frame rate and the duration are needed for the initialization, they will be set by each trial
+  session.ipv6_frame_size = MAX_FRAME_SIZE;
+  session.ipv4_frame_size = MAX_FRAME_SIZE-20;
+  session.frame_rate = 1;
+  session.duration = 1;
+  session.global_timeout = 0;
+  if ( session.init(argv[0],LEFTPORT,RIGHTPORT) < 0 )
+     return -1;
+
+  if ( argc > 1 ) // a single trial given in the command line
+    return trial(&session, argc-1, argv+1, 0) ? -1 : 0;
+
+  // a session: trials are read from the standard input
+  std::cout << "Info: Ready for trials." << std::endl;
+  while ( fgets(line, LINELEN+1, stdin) ) {
+    if ( !nonComment(line) )
+      continue;
+    words = 0;
+    for ( char *w = strtok(line, " \t\r\n"); w && words <= MAX_TRIAL_ARGS; w = strtok(NULL, " \t\r\n") )
+      word[words++] = w;
+    if ( words > MAX_TRIAL_ARGS ) {
+      std::cerr << "Input Error: Too many parameters of the trial." << std::endl;
+      result = -1;
+    } else
+      result = trial(&session, words, word, trials > 0);
+    if ( result == -2 )
+      return -1;
+    if ( result == 0 )
+      trials++;
+    std::cout << "Info: Trial " << (result ? "rejected." : "finished.") << std::endl;
+    fflush(stdout);
+  }
+  return 0;
+}
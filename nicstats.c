@@ -0,0 +1,84 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "defines.h"
+#include "includes.h"
+#include "nicstats.h"
+
+// allocates the arrays for the extended statistics, if the port supports them
+portStats::portStats(uint16_t port_, const char *port_side_) {
+  port = port_;
+  port_side = port_side_;
+  names = 0;
+  xbefore = 0;
+  num_xstats = rte_eth_xstats_get(port, 0, 0); // returns the number of extended statistics
+  if ( num_xstats <= 0 ) {
+    num_xstats = 0;
+    return;
+  }
+  names = new rte_eth_xstat_name[num_xstats];
+  xbefore = new rte_eth_xstat[num_xstats];
+  if ( rte_eth_xstats_get_names(port, names, num_xstats) != num_xstats ) {
+    std::cout << "Warning: Cannot get the names of the extended statistics of the " << port_side << " port." << std::endl;
+    num_xstats = 0;
+  }
+}
+
+portStats::~portStats() {
+  delete [] names;
+  delete [] xbefore;
+}
+
+void portStats::start() {
+  if ( rte_eth_stats_get(port, &before) )
+    memset(&before, 0, sizeof(before));
+  if ( num_xstats && rte_eth_xstats_get(port, xbefore, num_xstats) != num_xstats )
+    num_xstats = 0;
+}
+
+// the basic statistics are always reported, the extended ones only if they changed during the test
+// frames dropped by the port: imissed (RX queue was full), rx_nombuf (no mbuf for the received frame), ierrors and oerrors
+uint64_t portStats::finish() {
+  rte_eth_stats after;	// basic statistics at the end of the test
+  uint64_t dropped;	// number of frames dropped by the Tester's port
+  int i;		// cycle variable
+
+  if ( rte_eth_stats_get(port, &after) ) {
+    std::cout << "Warning: Cannot get the statistics of the " << port_side << " port." << std::endl;
+    return 0;
+  }
+  printf("Info: %s port ipackets: %lu, opackets: %lu, ibytes: %lu, obytes: %lu\n", port_side, after.ipackets-before.ipackets,
+         after.opackets-before.opackets, after.ibytes-before.ibytes, after.obytes-before.obytes);
+  printf("Info: %s port imissed: %lu, rx_nombuf: %lu, ierrors: %lu, oerrors: %lu\n", port_side, after.imissed-before.imissed,
+         after.rx_nombuf-before.rx_nombuf, after.ierrors-before.ierrors, after.oerrors-before.oerrors);
+  if ( num_xstats ) {
+    rte_eth_xstat *xafter = new rte_eth_xstat[num_xstats];	// extended statistics at the end of the test
+    if ( rte_eth_xstats_get(port, xafter, num_xstats) == num_xstats ) {
+      for ( i=0; i<num_xstats; i++ )
+        if ( xafter[i].value != xbefore[i].value )
+          printf("Info: %s port xstat %s: %lu\n", port_side, names[xafter[i].id].name, xafter[i].value-xbefore[i].value);
+    }
+    delete [] xafter;
+  }
+  dropped = (after.imissed-before.imissed) + (after.rx_nombuf-before.rx_nombuf) + (after.ierrors-before.ierrors) + (after.oerrors-before.oerrors);
+  if ( dropped )
+    printf("Warning: %s port of the Tester dropped %lu frames, the results are tester-limited!\n", port_side, dropped);
+  return dropped;
+}
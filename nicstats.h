@@ -0,0 +1,41 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef NICSTATS_H_INCLUDED
+#define NICSTATS_H_INCLUDED
+
+// statistics of a network port of the Tester: they are taken before and after each test, and the differences are reported,
+// because frames dropped by the Tester's own NICs (e.g. imissed, rx_nombuf) would be otherwise seen as frame loss of the DUT
+class portStats {
+public:
+  uint16_t port;		// port ID
+  const char *port_side;	// "Left" or "Right"
+  rte_eth_stats before;		// basic statistics at the beginning of the test
+  int num_xstats;		// number of extended statistics supported by the port (0, if they are not available)
+  rte_eth_xstat_name *names;	// names of the extended statistics
+  rte_eth_xstat *xbefore;	// extended statistics at the beginning of the test
+
+  portStats(uint16_t port_, const char *port_side_);
+  ~portStats();
+  void start();			// takes the statistics at the beginning of the test
+  uint64_t finish();		// takes the statistics at the end of the test, reports the differences and returns the number of frames dropped by the port
+};
+
+#endif
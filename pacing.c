@@ -0,0 +1,36 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "defines.h"
+#include "includes.h"
+#include "pacing.h"
+
+// only the non-empty buckets of the histogram are printed, their upper bounds are exchanged into nanoseconds
+void reportPacing(const pacingStats *ps, uint64_t hz, const char *side) {
+  int i;	// cycle variable
+
+  printf("Info: %s sender's maximum frame lateness: %lf us, catch-up frames: %lu, longest catch-up burst: %lu frames\n", side,
+         1e6*ps->max_lateness/hz, ps->late_frames, ps->longest_catchup);
+  printf("Info: %s sender's frame lateness histogram (upper bound in ns: frames):", side);
+  for ( i=0; i<LATENESS_BUCKETS; i++ )
+    if ( ps->bucket[i] )
+      printf(" %.0lf: %lu", i ? 1e9*ldexp(1.0,i)/hz : 0.0, ps->bucket[i]);
+  printf("\n");
+}
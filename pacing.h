@@ -0,0 +1,55 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PACING_H_INCLUDED
+#define PACING_H_INCLUDED
+
+#define LATENESS_BUCKETS 65	/* bucket 0: on time, bucket i: lateness in [2^(i-1), 2^i) TSC cycles */
+
+// statistics of how late the frames were started compared to their scheduled time, collected by a sender
+// recording is cheap enough to be done for every single frame: a bit scan and a few increments
+struct pacingStats {
+  uint64_t bucket[LATENESS_BUCKETS];	// log-bucketed histogram of the lateness values
+  uint64_t max_lateness;		// the highest lateness value (in TSC)
+  uint64_t late_frames;			// number of catch-up frames: started later than their scheduled time plus one inter-frame time
+  uint64_t catchup;			// length of the current run of consecutive catch-up frames
+  uint64_t longest_catchup;		// length of the longest run of consecutive catch-up frames
+
+  pacingStats() { memset(this, 0, sizeof(*this)); }
+
+  // records the lateness of a frame; frame_tsc is the inter-frame time
+  inline void record(uint64_t lateness, uint64_t frame_tsc) {
+    bucket[lateness ? 64-__builtin_clzll(lateness) : 0]++;
+    if ( unlikely( lateness > max_lateness ) )
+      max_lateness = lateness;
+    if ( unlikely( lateness >= frame_tsc ) ) {
+      // a catch-up frame: it is sent back-to-back with the previous one
+      late_frames++;
+      if ( ++catchup > longest_catchup )
+        longest_catchup = catchup;
+    } else
+      catchup = 0;
+  }
+};
+
+// prints the pacing statistics of a sender
+void reportPacing(const pacingStats *ps, uint64_t hz, const char *side);
+
+#endif
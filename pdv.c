@@ -22,6 +22,12 @@
 #include "includes.h"
 #include "throughput.h"
 #include "pdv.h"
+#include "frame.h"
+#include "timeline.h"
+#include "live.h"
+#include "pacing.h"
+#include "instrument.h"
+#include "sender.h"
 
 // the understanding of this code requires the knowledge of throughput.c
 // only a few functions are redefined or added here
@@ -41,71 +47,22 @@ int Pdv::senderPoolSize(int num_dest_nets) {
   return Throughput::senderPoolSize(num_dest_nets)*N; // all frames exit is N copies
 }
 
-// creates a special IPv4 Test Frame for PDV measurement using several helper functions
+uint64_t Pdv::timestampMemory() {
+  return (uint64_t) (forward+reverse)*2*duration*frame_rate*sizeof(uint64_t);
+}
+
+// creates a special IPv4 Test Frame for PDV measurement from its template (see frame.c)
 struct rte_mbuf *mkPdvFrame4(uint16_t length, rte_mempool *pkt_pool, const char *side,
                               const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
                               const uint32_t *src_ip, const uint32_t *dst_ip) {
-  struct rte_mbuf *pkt_mbuf=rte_pktmbuf_alloc(pkt_pool); // message buffer for the PDV Frame
-  if ( !pkt_mbuf )
-    rte_exit(EXIT_FAILURE, "Error: %s sender can't allocate a new mbuf for the PDV Frame! \n", side);
-  length -=  ETHER_CRC_LEN; // exclude CRC from the frame length
-  pkt_mbuf->pkt_len = pkt_mbuf->data_len = length; // set the length in both places
-  uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbuf, uint8_t *); // Access the Test Frame in the message buffer
-  ether_hdr *eth_hdr = reinterpret_cast<struct ether_hdr *>(pkt); // Ethernet header
-  ipv4_hdr *ip_hdr = reinterpret_cast<ipv4_hdr *>(pkt+sizeof(ether_hdr)); // IPv4 header
-  udp_hdr *udp_hd = reinterpret_cast<udp_hdr *>(pkt+sizeof(ether_hdr)+sizeof(ipv4_hdr)); // UDP header
-  uint8_t *udp_data = reinterpret_cast<uint8_t*>(pkt+sizeof(ether_hdr)+sizeof(ipv4_hdr)+sizeof(udp_hdr)); // UDP data
-
-  mkEthHeader(eth_hdr, dst_mac, src_mac, 0x0800);       // contains an IPv4 packet
-  int ip_length = length - sizeof(ether_hdr);
-  mkIpv4Header(ip_hdr, ip_length, src_ip, dst_ip);      // Does not set IPv4 header checksum
-  int udp_length = ip_length - sizeof(ipv4_hdr);        // No IP Options are used
-  mkUdpHeader(udp_hd, udp_length);
-  int data_legth = udp_length - sizeof(udp_hdr);
-  mkDataPdv(udp_data, data_legth);
-  udp_hd->dgram_cksum = rte_ipv4_udptcp_cksum( ip_hdr, udp_hd ); // UDP checksum is calculated and set
-  ip_hdr->hdr_checksum = rte_ipv4_cksum(ip_hdr);
-  return pkt_mbuf;
+  return mkFrame(PDV_FRAME, 4, length, pkt_pool, side, dst_mac, src_mac, src_ip, dst_ip, 0);
 }
 
-// creates a special IPv6 Test Frame for PDV measurement using several helper functions
+// creates a special IPv6 Test Frame for PDV measurement from its template (see frame.c)
 struct rte_mbuf *mkPdvFrame6(uint16_t length, rte_mempool *pkt_pool, const char *side,
                               const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
                               const struct in6_addr *src_ip, const struct in6_addr *dst_ip) {
-  struct rte_mbuf *pkt_mbuf=rte_pktmbuf_alloc(pkt_pool); // message buffer for the PDV Frame
-  if ( !pkt_mbuf )
-    rte_exit(EXIT_FAILURE, "Error: %s sender can't allocate a new mbuf for the PDV Frame! \n", side);
-  length -=  ETHER_CRC_LEN; // exclude CRC from the frame length
-  pkt_mbuf->pkt_len = pkt_mbuf->data_len = length; // set the length in both places
-  uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbuf, uint8_t *); // Access the Test Frame in the message buffer
-  ether_hdr *eth_hdr = reinterpret_cast<struct ether_hdr *>(pkt); // Ethernet header
-  ipv6_hdr *ip_hdr = reinterpret_cast<ipv6_hdr *>(pkt+sizeof(ether_hdr)); // IPv6 header
-  udp_hdr *udp_hd = reinterpret_cast<udp_hdr *>(pkt+sizeof(ether_hdr)+sizeof(ipv6_hdr)); // UDP header
-  uint8_t *udp_data = reinterpret_cast<uint8_t*>(pkt+sizeof(ether_hdr)+sizeof(ipv6_hdr)+sizeof(udp_hdr)); // UDP data
-
-  mkEthHeader(eth_hdr, dst_mac, src_mac, 0x86DD); // contains an IPv6 packet
-  int ip_length = length - sizeof(ether_hdr);
-  mkIpv6Header(ip_hdr, ip_length, src_ip, dst_ip);
-  int udp_length = ip_length - sizeof(ipv6_hdr); // No IP Options are used
-  mkUdpHeader(udp_hd, udp_length);
-  int data_legth = udp_length - sizeof(udp_hdr);
-  mkDataPdv(udp_data, data_legth);
-  udp_hd->dgram_cksum = rte_ipv6_udptcp_cksum( ip_hdr, udp_hd ); // UDP checksum is calculated and set
-  return pkt_mbuf;
-}
-
-void mkDataPdv(uint8_t *data, uint16_t length) {
-  unsigned i;
-  uint8_t identify[8]= { 'I', 'D', 'E', 'N', 'T', 'I', 'F', 'Y' };      // Identificion of the Latency Frames
-  uint64_t *id=(uint64_t *) identify;
-  *(uint64_t *)data = *id;
-  data += 8;
-  length -= 8;
-  *(uint64_t *)data = 0; // place for the 64-bit serial number
-  data += 8;
-  length -=8;
-  for ( i=0; i<length; i++ )
-    data[i] = i % 256;
+  return mkFrame(PDV_FRAME, 6, length, pkt_pool, side, dst_mac, src_mac, src_ip, dst_ip, 0);
 }
 
 // sends Test Frames for PDV measurements
@@ -113,208 +70,22 @@ int sendPdv(void *par) {
   // collecting input parameters:
   class senderParametersPdv *p = (class senderParametersPdv *)par;
   class senderCommonParameters *cp = (class senderCommonParameters *) p->cp;
-  // parameters directly correspond to the data members of class Throughput
-  uint16_t ipv6_frame_size = cp->ipv6_frame_size;
-  uint16_t ipv4_frame_size = cp->ipv4_frame_size;
-  uint32_t frame_rate = cp->frame_rate;
-  uint16_t duration = cp->duration;
-  uint32_t n = cp->n;
-  uint32_t m = cp->m;
-  uint64_t hz = cp->hz;
-  uint64_t start_tsc = cp->start_tsc;
-
-  // parameters which are different for the Left sender and the Right sender
-  int ip_version = p->ip_version;
-  rte_mempool *pkt_pool = p->pkt_pool;
-  uint8_t eth_id = p->eth_id;
-  const char *side = p->side;
-  struct ether_addr *dst_mac = p->dst_mac;
-  struct ether_addr *src_mac = p->src_mac;
-  uint16_t num_dest_nets = p->num_dest_nets;
-  uint32_t *src_ipv4 = p->src_ipv4;
-  uint32_t *dst_ipv4 = p->dst_ipv4;
-  struct in6_addr *src_ipv6 = p->src_ipv6;
-  struct in6_addr *dst_ipv6 = p->dst_ipv6;
-  struct in6_addr *src_bg= p->src_bg;
-  struct in6_addr *dst_bg = p->dst_bg;
-  uint64_t **send_ts = p->send_ts;
-
-  uint64_t frames_to_send = duration * frame_rate;      // Each active sender sends this number of packets
-  uint64_t sent_frames=0; // counts the number of sent frames
-  double elapsed_seconds; // for checking the elapsed seconds during sending
+  uint64_t frames_to_send = cp->duration * cp->frame_rate;      // Each active sender sends this number of packets
 
   // prepare a NUMA local, cache line aligned array for send timestamps
   uint64_t *snd_ts = (uint64_t *) rte_malloc(0, 8*frames_to_send, 128);
   if ( !snd_ts )
       rte_exit(EXIT_FAILURE, "Error: Receiver can't allocate memory for timestamps!\n");
-  *send_ts = snd_ts; // return the address of the array to the caller function
-
-  if ( num_dest_nets== 1 ) {
-    // optimized code for single flow: always the same foreground or background frame is sent, but it is updated regarding counter and UDP checksum
-    // N size arrays are used to resolve the write after send problem
-    int i; // cycle variable for the above mentioned purpose: takes {0..N-1} values
-    struct rte_mbuf *fg_pkt_mbuf[N], *bg_pkt_mbuf[N]; // pointers of message buffers for fg. and bg. PDV Frames
-    uint8_t *fg_pkt[N], *bg_pkt[N]; // pointers to the frames (in the message buffers)
-    uint8_t *fg_udp_chksum[N], *bg_udp_chksum[N], *fg_counter[N], *bg_counter[N]; 	// pointers to the given fields
-    uint16_t fg_udp_chksum_start, bg_udp_chksum_start; 	// starting values (uncomplemented checksums taken from the original frames)
-    uint32_t chksum; // temporary variable for shecksum calculation
-
-    // create PDV Test Frames 
-    for ( i=0; i<N; i++ ) {
-      // create foreground PDV Frame (IPv4 or IPv6)
-      if ( ip_version == 4 ) {
-        fg_pkt_mbuf[i] = mkPdvFrame4(ipv4_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv4, dst_ipv4);
-        fg_pkt[i] = rte_pktmbuf_mtod(fg_pkt_mbuf[i], uint8_t *); // Access the PDV Frame in the message buffer
-        fg_udp_chksum[i] = fg_pkt[i] + 40;
-        fg_counter[i] = fg_pkt[i] + 50;
-      } else { // IPv6
-        fg_pkt_mbuf[i] = mkPdvFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv6, dst_ipv6);
-        fg_pkt[i] = rte_pktmbuf_mtod(fg_pkt_mbuf[i], uint8_t *); // Access the PDV Frame in the message buffer
-        fg_udp_chksum[i] = fg_pkt[i] + 60;
-        fg_counter[i] = fg_pkt[i] + 70;
-      }
-      fg_udp_chksum_start = ~*(uint16_t *)fg_udp_chksum[i]; // save the uncomplemented checksum value (same for all values of "i")
-      // create backround PDV Frame (always IPv6)
-      bg_pkt_mbuf[i] = mkPdvFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_bg, dst_bg);
-      bg_pkt[i] = rte_pktmbuf_mtod(bg_pkt_mbuf[i], uint8_t *); // Access the PDV Frame in the message buffer
-      bg_udp_chksum[i] = fg_pkt[i] + 60;
-      bg_counter[i] = bg_pkt[i] + 70;
-      bg_udp_chksum_start = ~*(uint16_t *)bg_udp_chksum[i]; // save the uncomplemented checksum value (same for all values of "i")
-    }
-
-    // naive sender version: it is simple and fast
-    i=0; // increase maunally after each sending
-    for ( sent_frames = 0; sent_frames < frames_to_send; sent_frames++ ) {	// Main cycle for the number of frames to send
-      if ( sent_frames % n  < m ) {
-        // foreground frame is to be sent
-        *(uint64_t *)fg_counter[i] = sent_frames;			// set the counter in the frame 
-        chksum = fg_udp_chksum_start + rte_raw_cksum(&sent_frames,8); 	// add the checksum of the counter to the initial checksum value
-        chksum = ((chksum & 0xffff0000) >> 16) + (chksum & 0xffff);	// calculate 16-bit one's complement sum
-        chksum = (~chksum) & 0xffff;					// make one's complement
-        if (chksum == 0)						// checksum should not be 0 (0 means, no checksum is used)
-           chksum = 0xffff;
-        *(uint16_t *)fg_udp_chksum[i] = (uint16_t) chksum;		// set checksum in the frame
-        while ( rte_rdtsc() < start_tsc+sent_frames*hz/frame_rate ); 	// Beware: an "empty" loop, as well as in the next line
-        while ( !rte_eth_tx_burst(eth_id, 0, &fg_pkt_mbuf[i], 1) ); 	// send foreground frame
-        snd_ts[sent_frames] = rte_rdtsc();				// store timestamp
-      } else {
-        // background frame is to be sent
-        *(uint64_t *)bg_counter[i] = sent_frames;			// set the counter in the frame 
-        chksum = bg_udp_chksum_start + rte_raw_cksum(&sent_frames,8);   // add the checksum of the counter to the initial checksum value
-        chksum = ((chksum & 0xffff0000) >> 16) + (chksum & 0xffff);     // calculate 16-bit one's complement sum
-        chksum = (~chksum) & 0xffff;                                    // make one's complement
-        if (chksum == 0)                                                // checksum should not be 0 (0 means, no checksum is used)
-           chksum = 0xffff;
-        *(uint16_t *)bg_udp_chksum[i] = (uint16_t) chksum;              // set checksum in the frame
-        while ( rte_rdtsc() < start_tsc+sent_frames*hz/frame_rate ); 	// Beware: an "empty" loop, as well as in the next line
-        while ( !rte_eth_tx_burst(eth_id, 0, &bg_pkt_mbuf[i], 1) ); 	// send background frame
-        snd_ts[sent_frames] = rte_rdtsc();				// store timestamp
-      }
-      i = (i+1) % N;
-    } // this is the end of the sending cycle
-  } // end of optimized code for single flow
-  else {
-    // optimized code for multiple flows: foreground and background frames are generated for each flow and pointers are stored in arrays
-    // before sending, the frames are updated regarding counter and UDP checksum
-    // N size arrays are used to resolve the write after send problem
-    int j; // cycle variable for the above mentioned purpose: takes {0..N-1} values
-    // num_dest_nets <= 256
-    struct rte_mbuf *fg_pkt_mbuf[256][N], *bg_pkt_mbuf[256][N]; // pointers of message buffers for fg. and bg. PDV Frames
-    uint8_t *fg_pkt[256][N], *bg_pkt[256][N]; // pointers to the frames (in the message buffers)
-    uint8_t *fg_udp_chksum[256][N], *bg_udp_chksum[256][N], *fg_counter[256][N], *bg_counter[256][N];   // pointers to the given fields
-    uint16_t fg_udp_chksum_start[256], bg_udp_chksum_start[256];  // starting values (uncomplemented checksums taken from the original frames)
-    uint32_t chksum; // temporary variable for shecksum calculation
-    uint32_t curr_dst_ipv4;     // IPv4 destination address, which will be changed
-    in6_addr curr_dst_ipv6;     // foreground IPv6 destination address, which will be changed
-    in6_addr curr_dst_bg;       // backround IPv6 destination address, which will be changed
-    int i;                      // cycle variable for grenerating different destination network addresses
-    if ( ip_version == 4 )
-      curr_dst_ipv4 = *dst_ipv4;
-    else // IPv6
-      curr_dst_ipv6 = *dst_ipv6;
-    curr_dst_bg = *dst_bg;
-
-    // create PDV Test Frames
-    for ( j=0; j<N; j++ ) {
-      // create foreground PDV Frame (IPv4 or IPv6)
-      for ( i=0; i<num_dest_nets; i++ ) {
-        if ( ip_version == 4 ) {
-          ((uint8_t *)&curr_dst_ipv4)[2] = (uint8_t) i; // bits 16 to 23 of the IPv4 address are rewritten, like in 198.18.x.2
-          fg_pkt_mbuf[i][j] = mkPdvFrame4(ipv4_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv4, &curr_dst_ipv4);
-          fg_pkt[i][j] = rte_pktmbuf_mtod(fg_pkt_mbuf[i][j], uint8_t *); // Access the PDV Frame in the message buffer
-          fg_udp_chksum[i][j] = fg_pkt[i][j] + 40;
-          fg_counter[i][j] = fg_pkt[i][j] + 50;
-        }
-        else { // IPv6
-          ((uint8_t *)&curr_dst_ipv6)[7] = (uint8_t) i; // bits 56 to 63 of the IPv6 address are rewritten, like in 2001:2:0:00xx::1
-          fg_pkt_mbuf[i][j] = mkPdvFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv6, &curr_dst_ipv6);
-          fg_pkt[i][j] = rte_pktmbuf_mtod(fg_pkt_mbuf[i][j], uint8_t *); // Access the PDV Frame in the message buffer
-          fg_udp_chksum[i][j] = fg_pkt[i][j] + 60;
-          fg_counter[i][j] = fg_pkt[i][j] + 70;
-        }
-        fg_udp_chksum_start[i] = ~*(uint16_t *)fg_udp_chksum[i][j]; // save the uncomplemented checksum value (same for all values of "j")
-        // create backround Test Frame (always IPv6)
-        ((uint8_t *)&curr_dst_bg)[7] = (uint8_t) i; // see comment above
-        bg_pkt_mbuf[i][j] = mkPdvFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_bg, &curr_dst_bg);
-        bg_pkt[i][j] = rte_pktmbuf_mtod(bg_pkt_mbuf[i][j], uint8_t *); // Access the PDV Frame in the message buffer
-        bg_udp_chksum[i][j] = bg_pkt[i][j] + 60;
-        bg_counter[i][j] = bg_pkt[i][j] + 70;
-        bg_udp_chksum_start[i] = ~*(uint16_t *)bg_udp_chksum[i][j]; // save the uncomplemented checksum value (same for all values of "j")
-      }
-    }
-
-    // random number infrastructure is taken from: https://en.cppreference.com/w/cpp/numeric/random/uniform_int_distribution
-    // MT64 is used because of https://medium.com/@odarbelaeze/how-competitive-are-c-standard-random-number-generators-f3de98d973f0
-    // thread_local is used on the basis of https://stackoverflow.com/questions/40655814/is-mersenne-twister-thread-safe-for-cpp
-    thread_local std::random_device rd;  //Will be used to obtain a seed for the random number engine
-    thread_local std::mt19937_64 gen(rd()); //Standard 64-bit mersenne_twister_engine seeded with rd()
-    std::uniform_int_distribution<int> uni_dis(0, num_dest_nets-1);     // uniform distribution in [0, num_dest_nets-1]
-
-    // naive sender version: it is simple and fast
-    j=0; // increase maunally after each sending
-    for ( sent_frames = 0; sent_frames < frames_to_send; sent_frames++ ){ 	// Main cycle for the number of frames to send
-      int index = uni_dis(gen); // index of the pre-generated frame 
-      if ( sent_frames % n  < m ) {
-        *(uint64_t *)fg_counter[index][j] = sent_frames;                        // set the counter in the frame
-        chksum = fg_udp_chksum_start[index] + rte_raw_cksum(&sent_frames,8);   	// add the checksum of the counter to the initial checksum value
-        chksum = ((chksum & 0xffff0000) >> 16) + (chksum & 0xffff);     	// calculate 16-bit one's complement sum
-        chksum = (~chksum) & 0xffff;                                    	// make one's complement
-        if (chksum == 0)                                                	// checksum should not be 0 (0 means, no checksum is used)
-           chksum = 0xffff;
-        *(uint16_t *)fg_udp_chksum[index][j] = (uint16_t) chksum;               // set checksum in the frame
-        while ( rte_rdtsc() < start_tsc+sent_frames*hz/frame_rate );    	// Beware: an "empty" loop, as well as in the next line
-        while ( !rte_eth_tx_burst(eth_id, 0, &fg_pkt_mbuf[index][j], 1) );      // send foreground frame
-        snd_ts[sent_frames] = rte_rdtsc();                              	// store timestamp
-      } else {
-        *(uint64_t *)bg_counter[index][j] = sent_frames;                        // set the counter in the frame
-        chksum = bg_udp_chksum_start[index] + rte_raw_cksum(&sent_frames,8);   	// add the checksum of the counter to the initial checksum value
-        chksum = ((chksum & 0xffff0000) >> 16) + (chksum & 0xffff);     	// calculate 16-bit one's complement sum
-        chksum = (~chksum) & 0xffff;                                    	// make one's complement
-        if (chksum == 0)                                                	// checksum should not be 0 (0 means, no checksum is used)
-           chksum = 0xffff;
-        *(uint16_t *)bg_udp_chksum[index][j] = (uint16_t) chksum;               // set checksum in the frame
-        while ( rte_rdtsc() < start_tsc+sent_frames*hz/frame_rate );    	// Beware: an "empty" loop, as well as in the next line
-        while ( !rte_eth_tx_burst(eth_id, 0, &bg_pkt_mbuf[index][j], 1) );      // send foreground frame
-        snd_ts[sent_frames] = rte_rdtsc();                              	// store timestamp
-      }
-      j = (j+1) % N;
-    } // this is the end of the sending cycle
+  *p->send_ts = snd_ts; // return the address of the array to the caller function
 
-  } // end of optimized code for multiple flows
+  // fg. and bg. PDV Frames for each flow in N copies were pre-generated, they are updated regarding counter and UDP checksum before sending
+  pdvStamp stamper(p->frames, p->ip_version, snd_ts);
 
-  // Now, we check the time
-  elapsed_seconds = (double)(rte_rdtsc()-start_tsc)/hz;
-  printf("Info: %s sender's sending took %3.10lf seconds.\n", side, elapsed_seconds);
-  if ( elapsed_seconds > duration*TOLERANCE )
-    rte_exit(EXIT_FAILURE, "%s sending exceeded the %3.10lf seconds limit, the test is invalid.\n", side, duration*TOLERANCE);
-  printf("%s frames sent: %lu\n", side, sent_frames);
+  sendFrames(p, p->frames, &stamper);
   return 0;
 }
 
-// Offsets from the start of the Ethernet Frame:
-// EtherType: 6+6=12
-// IPv6 Next header: 14+6=20, UDP Data for IPv6: 14+40+8=62
-// IPv4 Protolcol: 14+9=23, UDP Data for IPv4: 14+20+8=42
+// the offsets of the fields are taken from the frame layouts (see frame.h)
 int receivePdv(void *par) {
   // collecting input parameters:
   class receiverParametersPdv *p = (class receiverParametersPdv *)par;
@@ -328,10 +99,12 @@ int receivePdv(void *par) {
   // further local variables
   int frames, i;
   struct rte_mbuf *pkt_mbufs[MAX_PKT_BURST]; // pointers for the mbufs of received frames
+  INSTR( lcoreInstruments ins; ) // data-plane instrumentation (if compiled in)
   uint16_t ipv4=htons(0x0800); // EtherType for IPv4 in Network Byte Order
   uint16_t ipv6=htons(0x86DD); // EtherType for IPv6 in Network Byte Order
   uint8_t identify[8]= { 'I', 'D', 'E', 'N', 'T', 'I', 'F', 'Y' };      // Identificion of the Test Frames
   uint64_t *id=(uint64_t *) identify;
+  uint64_t all_frames=0; // number of all frames received, the ones not matching the test signature are counted as foreign traffic
   uint64_t received=0;  // number of received frames
 
   // prepare a NUMA local, cache line aligned array for reveive timestamps, and fill it with all 0-s
@@ -341,26 +114,29 @@ int receivePdv(void *par) {
   *receive_ts = rec_ts; // return the address of the array to the caller function
 
   while ( rte_rdtsc() < finish_receiving ){
+    INSTR( ins.t0 = rte_rdtsc() );
     frames = rte_eth_rx_burst(eth_id, 0, pkt_mbufs, MAX_PKT_BURST);
+    INSTR( ins.burst[frames]++ );
+    all_frames += frames;
     for (i=0; i < frames; i++){
       uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbufs[i], uint8_t *); // Access the PDV Frame in the message buffer
       // check EtherType at offset 12: IPv6, IPv4, or anything else
-      if ( *(uint16_t *)&pkt[12]==ipv6 ) { /* IPv6 */
+      if ( *(uint16_t *)&pkt[layout6.ether_type]==ipv6 ) { /* IPv6 */
         /* check if IPv6 Next Header is UDP, and the first 8 bytes of UDP data is 'IDENTIFY' */
-        if ( likely( pkt[20]==17 && *(uint64_t *)&pkt[62]==*id ) ) {
+        if ( likely( pkt[layout6.proto]==17 && *(uint64_t *)&pkt[layout6.data]==*id ) ) {
           // PDV frame
           uint64_t timestamp = rte_rdtsc(); // get a timestamp ASAP
-          uint64_t counter = *(uint64_t *)&pkt[70]; 
+          uint64_t counter = *(uint64_t *)&pkt[layout6.id]; 
           if ( unlikely ( counter >= num_frames ) )
             rte_exit(EXIT_FAILURE, "Error: PDV Frame with invalid frame ID was received!\n"); // to avoid segmentation fault
           rec_ts[counter] = timestamp;
           received++; // also count it 
         }
-      } else if ( *(uint16_t *)&pkt[12]==ipv4 ) { /* IPv4 */
-        if ( likely( pkt[23]==17 && *(uint64_t *)&pkt[42]==*id ) ) {
+      } else if ( *(uint16_t *)&pkt[layout4.ether_type]==ipv4 ) { /* IPv4 */
+        if ( likely( pkt[layout4.proto]==17 && *(uint64_t *)&pkt[layout4.data]==*id ) ) {
           // Latency Frame
           uint64_t timestamp = rte_rdtsc(); // get a timestamp ASAP
-          uint64_t counter = *(uint64_t *)&pkt[50];
+          uint64_t counter = *(uint64_t *)&pkt[layout4.id];
           if ( unlikely ( counter >= num_frames ) )
             rte_exit(EXIT_FAILURE, "Error: PDV Frame with invalid frame ID was received!\n"); // to avoid segmentation fault
           rec_ts[counter] = timestamp;
@@ -369,7 +145,10 @@ int receivePdv(void *par) {
       }
       rte_pktmbuf_free(pkt_mbufs[i]);
     }
+    INSTR( if ( frames ) ins.busy_cycles += rte_rdtsc()-ins.t0 );
   }
+  INSTR( reportReceiverInstruments(&ins, side) );
+  printf("Info: %s foreign frames received: %lu\n", side, all_frames-received);
   if ( frame_timeout == 0 )
     printf("%s frames received: %lu\n", side, received); //  printed if normal PDV, but not printed if special throughput measurement is done
   return received;
@@ -378,9 +157,16 @@ int receivePdv(void *par) {
 
 void Pdv::measure(uint16_t leftport, uint16_t rightport) {
   uint64_t *left_send_ts, *right_send_ts, *left_receive_ts, *right_receive_ts; // pointers for timestamp arrays
+  senderParametersPdv *left_spars=0, *right_spars=0; // parameters of the active senders, they must exist until the senders finish
+
+  startPortStats(); // before anything is sent
 
   // set common parameters for senders
   senderCommonParameters scp(ipv6_frame_size,ipv4_frame_size,frame_rate,duration,n,m,hz,start_tsc);
+  scp.max_lateness_tsc = hz*max_lateness/1000000;
+  scp.arrival_dist = arrival_dist;
+  scp.arrival_burst = arrival_burst;
+  scp.arrival_peak = arrival_peak;
 
   if ( forward ) {      // Left to right direction is active
 
@@ -391,19 +177,8 @@ void Pdv::measure(uint16_t leftport, uint16_t rightport) {
                &ipv6_left_real,&ipv6_right_real,&ipv6_left_virtual,&ipv6_right_virtual);
 
     // then, initialize the parameter class instance
-    senderParametersPdv spars(&scp,ip_left_version,pkt_pool_left_sender,leftport,"Forward",(ether_addr *)mac_left_dut,(ether_addr *)mac_left_tester,
-                              ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_left_real,&ipv6_right_real,num_right_nets,&left_send_ts);
-
-    // start left sender
-    if ( rte_eal_remote_launch(sendPdv, &spars, cpu_left_sender) )
-      std::cout << "Error: could not start Left Sender." << std::endl;
-
-    // set parameters for the right receiver
-    receiverParametersPdv rpars(finish_receiving,rightport,"Forward",duration*frame_rate,frame_timeout,&right_receive_ts);
-
-    // start right receiver
-    if ( rte_eal_remote_launch(receivePdv, &rpars, cpu_right_receiver) )
-      std::cout << "Error: could not start Right Receiver." << std::endl;
+    left_spars = new senderParametersPdv(&scp,ip_left_version,pkt_pool_left_sender,leftport,"Forward",(ether_addr *)mac_left_dut,(ether_addr *)mac_left_tester,
+                                         ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_left_real,&ipv6_right_real,num_right_nets,&left_send_ts);
   }
 
   if ( reverse ) {      // Right to Left direction is active
@@ -415,11 +190,32 @@ void Pdv::measure(uint16_t leftport, uint16_t rightport) {
                &ipv6_right_real,&ipv6_left_real,&ipv6_right_virtual,&ipv6_left_virtual);
 
     // then, initialize the parameter class instance
-    senderParametersPdv spars(&scp,ip_right_version,pkt_pool_right_sender,rightport,"Reverse",(ether_addr *)mac_right_dut,(ether_addr *)mac_right_tester,
-                              ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_right_real,&ipv6_left_real,num_left_nets,&right_send_ts);
+    right_spars = new senderParametersPdv(&scp,ip_right_version,pkt_pool_right_sender,rightport,"Reverse",(ether_addr *)mac_right_dut,(ether_addr *)mac_right_tester,
+                                          ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_right_real,&ipv6_left_real,num_left_nets,&right_send_ts);
+  }
+
+  // the PDV Frames are pre-generated in parallel, and the senders start START_DELAY after it
+  pregenerateFrames(this, left_spars, right_spars, pdvStamp::copies, mkPdvFrame4, mkPdvFrame6);
+  setStartTime();
+  scp.start_tsc = start_tsc;
+  startRefDut();
+
+  if ( forward ) {
+    // start left sender
+    if ( rte_eal_remote_launch(sendPdv, left_spars, cpu_left_sender) )
+      std::cout << "Error: could not start Left Sender." << std::endl;
+
+    // set parameters for the right receiver
+    receiverParametersPdv rpars(finish_receiving,rightport,"Forward",duration*frame_rate,frame_timeout,&right_receive_ts);
+
+    // start right receiver
+    if ( rte_eal_remote_launch(receivePdv, &rpars, cpu_right_receiver) )
+      std::cout << "Error: could not start Right Receiver." << std::endl;
+  }
 
+  if ( reverse ) {
     // start right sender
-    if (rte_eal_remote_launch(sendPdv, &spars, cpu_right_sender) )
+    if (rte_eal_remote_launch(sendPdv, right_spars, cpu_right_sender) )
       std::cout << "Error: could not start Right Sender." << std::endl;
 
     // set parameters for the left receiver
@@ -442,14 +238,24 @@ void Pdv::measure(uint16_t leftport, uint16_t rightport) {
     rte_eal_wait_lcore(cpu_right_sender);
     rte_eal_wait_lcore(cpu_left_receiver);
   }
+  deleteSenderParameters(left_spars);
+  deleteSenderParameters(right_spars);
+  finishRefDut();
+  finishPortStats();
 
   // Process the timestamps
   int penalty=1000*duration+global_timeout; // latency to be reported for lost timestamps, expressed in milliseconds
 
-  if ( forward )
+  if ( forward ) {
     evaluatePdv(duration*frame_rate, left_send_ts, right_receive_ts, hz, frame_timeout, penalty, "Forward"); 
-  if ( reverse )
+    rte_free(left_send_ts);
+    rte_free(right_receive_ts);
+  }
+  if ( reverse ) {
     evaluatePdv(duration*frame_rate, right_send_ts, left_receive_ts, hz, frame_timeout, penalty, "Reverse"); 
+    rte_free(right_send_ts);
+    rte_free(left_receive_ts);
+  }
 
   std::cout << "Info: Test finished." << std::endl;
 }
@@ -478,12 +284,21 @@ void evaluatePdv(uint64_t num_timestamps, uint64_t *send_ts, uint64_t *receive_t
   int64_t *latency = new int64_t[num_timestamps]; // negative delay may occur, see the paper for details
   uint64_t num_corrected=0; 	// number of negative delay values corrected to 0
   uint64_t frames_lost=0;	// the number of physically lost frames
+  ipdvStats ipdv(hz);		// IPDV and jitter are computed from the delays before their correction
+  int64_t last_delay=0;		// delay of the last received frame
+  bool last_received=false;	// if the previous frame was received
 
   if ( !latency )
     rte_exit(EXIT_FAILURE, "Error: Tester can't allocate memory for latency values!\n");
   for ( i=0; i<num_timestamps; i++ ) {
     if ( receive_ts[i] ) {
       latency[i] = receive_ts[i]-send_ts[i]; 	// packet delay in TSC
+      if ( last_received )
+        ipdv.record(latency[i]-last_delay);
+      if ( i != frames_lost ) // not the first received frame
+        ipdv.update(latency[i]-last_delay);
+      last_delay = latency[i];
+      last_received = true;
       if ( unlikely ( latency[i] < 0 ) ) {
         latency[i] = 0;	// correct negative delay to 0
         num_corrected++;
@@ -492,6 +307,7 @@ void evaluatePdv(uint64_t num_timestamps, uint64_t *send_ts, uint64_t *receive_t
     else {
       frames_lost++; // frame physically lost
       latency[i] = penalty_tsc; // penalty of the lost timestamp
+      last_received = false;
     }
   }
   if ( num_corrected )
@@ -524,5 +340,58 @@ void evaluatePdv(uint64_t num_timestamps, uint64_t *send_ts, uint64_t *receive_t
     printf("Info: %s Dmin: %lf\n", side, 1000.0*Dmin/hz);
     printf("Info: %s Dmax: %lf\n", side, 1000.0*Dmax/hz);
     printf("%s PDV: %lf\n", side, 1000.0*PDV/hz);
+    ipdv.report(hz, side);
+  }
+}
+
+ipdvStats::ipdvStats(uint64_t hz) {
+  histogram = new uint64_t[2*IPDV_HIST_SIZE+1];
+  memset(histogram, 0, (2*IPDV_HIST_SIZE+1)*sizeof(uint64_t));
+  res_tsc = std::max(hz*IPDV_HIST_RES/1000000000, (uint64_t) 1);
+  pairs = 0;
+  min = max = 0;
+  sum_abs = jitter = max_jitter = 0;
+}
+
+// the percentiles are rounded toward 0 to the resolution (and printed in milliseconds), the minimum and the maximum are exact; in the histogram, the
+// buckets are merged into ranges doubling in size, and only the non-empty ones are printed by their bound farther from 0 (in ns)
+void ipdvStats::report(uint64_t hz, const char *side) {
+  double perc0_1=0, median=0, perc99_9=0;
+  uint64_t cumulated=0, range=0;
+  int i, bits=0;
+
+  if ( !pairs ) {
+    printf("Info: %s IPDV: no pairs of consecutive frames were received\n", side);
+    return;
+  }
+  for ( i=0; i<2*IPDV_HIST_SIZE+1; i++ ) {
+    if ( !histogram[i] )
+      continue;
+    double value = (i-IPDV_HIST_SIZE)*IPDV_HIST_RES/1e6;
+    if ( cumulated < ceil(0.001*pairs) && cumulated+histogram[i] >= ceil(0.001*pairs) )
+      perc0_1 = value;
+    if ( cumulated < (pairs+1)/2 && cumulated+histogram[i] >= (pairs+1)/2 )
+      median = value;
+    if ( cumulated < ceil(0.999*pairs) && cumulated+histogram[i] >= ceil(0.999*pairs) )
+      perc99_9 = value;
+    cumulated += histogram[i];
+  }
+  printf("Info: %s IPDV (ms): min: %.6lf, 0.1th perc: %.4lf, median: %.4lf, 99.9th perc: %.4lf, max: %.6lf, mean of absolute values: %.6lf, pairs: %lu\n",
+         side, 1000.0*min/hz, perc0_1, median, perc99_9, 1000.0*max/hz, 1000.0*sum_abs/pairs/hz, pairs);
+  printf("Info: %s IPDV histogram (bound in ns: pairs):", side);
+  for ( i=0; i<2*IPDV_HIST_SIZE+1; i++ ) {
+    int distance = std::abs(i-IPDV_HIST_SIZE);	// distance of the bucket from the one of 0
+    int b = distance ? 32-__builtin_clz(distance) : 0;	// the range of the bucket
+    if ( b != bits ) {
+      if ( range )
+        printf(" %d: %lu", (i-1 < IPDV_HIST_SIZE ? -1 : 1)*(bits ? (1 << bits)-1 : 0)*IPDV_HIST_RES, range);
+      range = 0;
+      bits = b;
+    }
+    range += histogram[i];
   }
+  if ( range )
+    printf(" %d: %lu", (bits ? (1 << bits)-1 : 0)*IPDV_HIST_RES, range);
+  printf("\n");
+  printf("Info: %s jitter (RFC 3550, ms): final: %.6lf, max: %.6lf\n", side, 1000.0*jitter/hz, 1000.0*max_jitter/hz);
 }
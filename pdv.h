@@ -18,29 +18,28 @@
  *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#ifndef LATENCY_H_INCLUDED
-#define LATENCY_H_INCLUDED
+#ifndef PDV_H_INCLUDED
+#define PDV_H_INCLUDED
 
 // the main class for PDV measurements, adds some features to class Throughput
 class Pdv : public Throughput {
 public:
   uint16_t frame_timeout;       // if 0, normal PDV measurement is done; if >0, then frames with higher delay then frame_timeout are considered as lost 
 
-  Pdv() : Throughput() { }; // default constructor
+  Pdv() : Throughput() { program = "pdv"; }; // default constructor
   int readCmdLine(int argc, const char *argv[]);	// reads further one argument: frame_timeout
   virtual int senderPoolSize(int numDestNets);
+  virtual uint64_t timestampMemory();	// send and receive timestamps of all frames
 
   // perform pdv measurement
   void measure(uint16_t leftport, uint16_t rightport);
 };
 
-// functions to create PDV Frames (and their parts)
+// functions to create PDV Frames
 struct rte_mbuf *mkPdvFrame4(uint16_t length, rte_mempool *pkt_pool, const char *side,
                                 const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
                                 const uint32_t *src_ip, const uint32_t *dst_ip);
 
-void mkDataPdv(uint8_t *data, uint16_t length);
-
 struct rte_mbuf *mkPdvFrame6(uint16_t length, rte_mempool *pkt_pool, const char *side,
                                 const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
                                 const struct in6_addr *src_ip, const struct in6_addr *dst_ip);
@@ -63,6 +62,40 @@ class receiverParametersPdv : public receiverParameters {
                             uint64_t num_frames_, uint16_t frame_timeout_, uint64_t **receive_ts_);
 };
 
+// send and receive PDV Frames
+int sendPdv(void *par);
+int receivePdv(void *par);
+
+// IPDV (RFC 5481) and interarrival jitter (RFC 3550) statistics, collected in a single pass over the frames in the order of their
+// counters: the IPDV of a frame is its delay minus the delay of the previous frame (if both were received), the jitter is smoothed
+// by 1/16 at every received frame using the delay difference from the previous received frame
+struct ipdvStats {
+  uint64_t *histogram;		// 2*IPDV_HIST_SIZE+1 buckets of IPDV_HIST_RES ns, histogram[IPDV_HIST_SIZE] is the one of 0
+  uint64_t res_tsc;		// resolution of the histogram in TSC
+  uint64_t pairs;		// number of IPDV values
+  int64_t min, max;		// the lowest and the highest IPDV value (in TSC)
+  double sum_abs;		// sum of the absolute values of the IPDV values (in TSC)
+  double jitter, max_jitter;	// the current and the highest value of the jitter (in TSC)
+
+  ipdvStats(uint64_t hz);
+  ~ipdvStats() { delete [] histogram; }
+  inline void record(int64_t ipdv) {
+    int64_t bucket = ipdv/(int64_t)res_tsc;
+    histogram[IPDV_HIST_SIZE+std::max(std::min(bucket, (int64_t)IPDV_HIST_SIZE), -(int64_t)IPDV_HIST_SIZE)]++;
+    if ( !pairs++ || ipdv < min )
+      min = ipdv;
+    if ( pairs == 1 || ipdv > max )
+      max = ipdv;
+    sum_abs += std::abs(ipdv);
+  }
+  inline void update(int64_t difference) {
+    jitter += (std::abs(difference)-jitter)/16;
+    if ( jitter > max_jitter )
+      max_jitter = jitter;
+  }
+  void report(uint64_t hz, const char *side);
+};
+
 void evaluatePdv(uint64_t num_timestamps, uint64_t *send_ts, uint64_t *receive_ts, uint64_t hz, uint16_t frame_timeout, int penalty, const char *side);
 
 #endif
@@ -0,0 +1,275 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "defines.h"
+#include "includes.h"
+#include "throughput.h"
+#include "pdv.h"
+#include "frame.h"
+#include "timeline.h"
+#include "live.h"
+#include "pacing.h"
+#include "instrument.h"
+#include "sender.h"
+#include "recovery.h"
+
+// the understanding of this code requires the knowledge of throughput.c and pdv.c
+// only a few functions are redefined or added here
+
+// after reading the parameters for throughput measurement, further one parameter is read, and the rate profile is set
+int Recovery::readCmdLine(int argc, const char *argv[]) {
+  if ( Throughput::readCmdLine(argc-1,argv) < 0 )
+    return -1;
+  if ( sscanf(argv[7], "%u", &overload) != 1 || overload < 1 || overload >= duration ) {
+    std::cerr << "Input Error: Overload time must be at least 1 and less than the duration." << std::endl;
+    return -1;
+  }
+  throughput = frame_rate;
+  if ( (uint64_t) throughput*RECOVERY_OVERLOAD/100 > 14880952 ) {
+    std::cerr << "Input Error: The frame rate of the overload phase (" << RECOVERY_OVERLOAD << "% of the frame rate) must not exceed 14880952." << std::endl;
+    return -1;
+  }
+  phase[0].start_rate = phase[0].end_rate = (uint64_t) throughput*RECOVERY_OVERLOAD/100;
+  phase[0].end_ms = 1000*overload;
+  phase[1].start_rate = phase[1].end_rate = std::max((uint64_t) throughput*RECOVERY_REDUCED/100, (uint64_t) 1);
+  phase[1].end_ms = 1000*duration;
+  if ( setRateProfile(phase, 2) < 0 )
+    return -1;
+  frame_rate = phase[0].start_rate; // the highest frame rate, it is used for the checks
+  // the overload phase must overload the DUT and not the Tester, thus its rate is checked again as a hard limit; the calibration
+  // data of siitperf-pdv is used, as its frames are numbered in the same way (siitperf-recovery is not calibrated)
+  if ( checkCalibration("pdv", 1) < 0 )
+    return -1;
+  std::cout << "Info: System recovery test: overload at " << phase[0].start_rate << " fps for " << overload << " seconds, then "
+            << phase[1].start_rate << " fps for " << duration-overload << " seconds." << std::endl;
+  return 0;
+}
+
+int Recovery::senderPoolSize(int num_dest_nets) {
+  return Throughput::senderPoolSize(num_dest_nets)*seqStamp::copies; // the numbered PDV Frames of each flow exist in so many copies
+}
+
+uint64_t Recovery::timestampMemory() {
+  return (uint64_t) (forward+reverse)*1000*(duration-overload)*sizeof(uint32_t);
+}
+
+// sends Test Frames for system recovery tests
+int sendRecovery(void *par) {
+  // collecting input parameters:
+  class senderParameters *p = (class senderParameters *)par;
+
+  // fg. and bg. PDV Frames for each flow in N copies were pre-generated, they are updated regarding counter and UDP checksum before sending
+  seqStamp stamper(p->frames, p->ip_version);
+
+  sendFrames(p, p->frames, &stamper);
+  return 0;
+}
+
+// the offsets of the fields are taken from the frame layouts (see frame.h)
+// the frames of the recovery phase are counted in 1ms long intervals of their scheduled sending time, which is computed from
+// their counter: frame i of the recovery phase is scheduled i/reduced_rate seconds after the reduction of the frame rate
+int receiveRecovery(void *par) {
+  // collecting input parameters:
+  class receiverParametersRecovery *p = (class receiverParametersRecovery *)par;
+  uint64_t finish_receiving = p->finish_receiving;
+  uint8_t eth_id = p->eth_id;
+  const char *side = p->side;
+  uint64_t frames_to_send = p->frames_to_send;
+  uint64_t reduction_frame = p->reduction_frame;
+  uint32_t reduced_rate = p->reduced_rate;
+  uint32_t recovery_ms = p->recovery_ms;
+
+  // further local variables
+  int frames, i;
+  struct rte_mbuf *pkt_mbufs[MAX_PKT_BURST]; // pointers for the mbufs of received frames
+  INSTR( lcoreInstruments ins; ) // data-plane instrumentation (if compiled in)
+  uint16_t ipv4=htons(0x0800); // EtherType for IPv4 in Network Byte Order
+  uint16_t ipv6=htons(0x86DD); // EtherType for IPv6 in Network Byte Order
+  uint8_t identify[8]= { 'I', 'D', 'E', 'N', 'T', 'I', 'F', 'Y' };      // Identificion of the Test Frames
+  uint64_t *id=(uint64_t *) identify;
+  uint64_t all_frames=0; // number of all frames received, the ones not matching the test signature are counted as foreign traffic
+  uint64_t received=0;  // number of received frames
+  uint64_t overload_received=0;  // number of frames of the overload phase received
+
+  // prepare a NUMA local, cache line aligned array for the counters of the 1ms intervals, and fill it with all 0-s
+  uint32_t *ms_received = (uint32_t *) rte_zmalloc(0, sizeof(uint32_t)*recovery_ms, 128);
+  if ( !ms_received )
+      rte_exit(EXIT_FAILURE, "Error: Receiver can't allocate memory for the counters of the recovery phase!\n");
+
+  while ( rte_rdtsc() < finish_receiving ){
+    INSTR( ins.t0 = rte_rdtsc() );
+    frames = rte_eth_rx_burst(eth_id, 0, pkt_mbufs, MAX_PKT_BURST);
+    INSTR( ins.burst[frames]++ );
+    all_frames += frames;
+    for (i=0; i < frames; i++){
+      uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbufs[i], uint8_t *); // Access the PDV Frame in the message buffer
+      const frameLayout *l; // layout of the frame
+      // check EtherType at offset 12: IPv6, IPv4, or anything else
+      if ( *(uint16_t *)&pkt[layout6.ether_type]==ipv6 )
+        l = &layout6;
+      else if ( *(uint16_t *)&pkt[layout4.ether_type]==ipv4 )
+        l = &layout4;
+      else
+        l = NULL;
+      /* check if the transport protocol is UDP, and the first 8 bytes of UDP data is 'IDENTIFY' */
+      if ( likely( l && pkt[l->proto]==17 && *(uint64_t *)&pkt[l->data]==*id ) ) {
+        // PDV frame
+        uint64_t counter = *(uint64_t *)&pkt[l->id];
+        if ( unlikely ( counter >= frames_to_send ) )
+          rte_exit(EXIT_FAILURE, "Error: PDV Frame with invalid frame ID was received!\n"); // to avoid segmentation fault
+        if ( counter < reduction_frame )
+          overload_received++;
+        else
+          ms_received[(counter-reduction_frame)*1000/reduced_rate]++;
+        received++; // also count it
+      }
+      rte_pktmbuf_free(pkt_mbufs[i]);
+    }
+    INSTR( if ( frames ) ins.busy_cycles += rte_rdtsc()-ins.t0 );
+  }
+  INSTR( reportReceiverInstruments(&ins, side) );
+  printf("Info: %s foreign frames received: %lu\n", side, all_frames-received);
+  printf("%s frames received: %lu\n", side, received);
+  printf("Info: %s overload phase: frames sent: %lu, received: %lu, lost: %lu\n", side, reduction_frame, overload_received,
+         reduction_frame > overload_received ? reduction_frame-overload_received : 0);
+
+  // interval j contains the frames i of the recovery phase, for which j <= i*1000/reduced_rate < j+1
+  uint64_t recovery_frames = frames_to_send-reduction_frame, lost=0, second_lost=0;
+  uint32_t last_lossy=0;	// the end of the last interval with frame loss (in milliseconds), 0: no loss
+  for ( uint32_t j=0; j<recovery_ms; j++ ) {
+    uint64_t first = ((uint64_t) j*reduced_rate+999)/1000, next = std::min(((uint64_t) (j+1)*reduced_rate+999)/1000, recovery_frames);
+    if ( next > first && ms_received[j] < next-first ) {
+      second_lost += next-first-ms_received[j];
+      last_lossy = j+1;
+    }
+    if ( (j+1) % 1000 == 0 || j+1 == recovery_ms ) {
+      if ( second_lost )
+        printf("Info: %s recovery phase second %u: frames lost: %lu\n", side, j/1000, second_lost); // only the seconds with loss
+      lost += second_lost;
+      second_lost = 0;
+    }
+  }
+  printf("Info: %s recovery phase: frames sent: %lu, lost: %lu\n", side, recovery_frames, lost);
+  if ( last_lossy == recovery_ms )
+    printf("%s recovery time: not recovered within %u ms\n", side, recovery_ms);
+  else
+    printf("%s recovery time: %u ms\n", side, last_lossy);
+  rte_free(ms_received);
+  return received;
+}
+
+void Recovery::measure(uint16_t leftport, uint16_t rightport) {
+  senderParameters *left_spars=0, *right_spars=0; // parameters of the active senders, they must exist until the senders finish
+
+  startPortStats(); // before anything is sent
+
+  // set common parameters for senders
+  senderCommonParameters scp(ipv6_frame_size,ipv4_frame_size,frame_rate,duration,n,m,hz,start_tsc);
+  scp.max_lateness_tsc = hz*max_lateness/1000000;
+  scp.profile = &rate_profile;
+  scp.frames_to_send = phase[1].end_frame;
+
+  if ( forward ) {      // Left to right direction is active
+
+    // set individual parameters for the left sender
+
+    // first, collect the appropriate values dependig on the IP versions
+    ipQuad ipq(ip_left_version,ip_right_version,&ipv4_left_real,&ipv4_right_real,&ipv4_left_virtual,&ipv4_right_virtual,
+               &ipv6_left_real,&ipv6_right_real,&ipv6_left_virtual,&ipv6_right_virtual);
+
+    // then, initialize the parameter class instance
+    left_spars = new senderParameters(&scp,ip_left_version,pkt_pool_left_sender,leftport,"Forward",(ether_addr *)mac_left_dut,(ether_addr *)mac_left_tester,
+                                      ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_left_real,&ipv6_right_real,num_right_nets);
+  }
+
+  if ( reverse ) {      // Right to Left direction is active
+
+    // set individual parameters for the right sender
+
+    // first, collect the appropriate values dependig on the IP versions
+    ipQuad ipq(ip_right_version,ip_left_version,&ipv4_right_real,&ipv4_left_real,&ipv4_right_virtual,&ipv4_left_virtual,
+               &ipv6_right_real,&ipv6_left_real,&ipv6_right_virtual,&ipv6_left_virtual);
+
+    // then, initialize the parameter class instance
+    right_spars = new senderParameters(&scp,ip_right_version,pkt_pool_right_sender,rightport,"Reverse",(ether_addr *)mac_right_dut,(ether_addr *)mac_right_tester,
+                                       ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_right_real,&ipv6_left_real,num_left_nets);
+  }
+
+  // the PDV Frames are pre-generated in parallel, and the senders start START_DELAY after it
+  pregenerateFrames(this, left_spars, right_spars, seqStamp::copies, mkPdvFrame4, mkPdvFrame6);
+  setStartTime();
+  scp.start_tsc = start_tsc;
+  startRefDut();
+
+  if ( forward ) {
+    // start left sender
+    if ( rte_eal_remote_launch(sendRecovery, left_spars, cpu_left_sender) )
+      std::cout << "Error: could not start Left Sender." << std::endl;
+
+    // set parameters for the right receiver
+    receiverParametersRecovery rpars(finish_receiving,rightport,"Forward",phase[0].end_frame,phase[1].start_rate,1000*(duration-overload));
+    rpars.frames_to_send = scp.frames_to_send;
+
+    // start right receiver
+    if ( rte_eal_remote_launch(receiveRecovery, &rpars, cpu_right_receiver) )
+      std::cout << "Error: could not start Right Receiver." << std::endl;
+  }
+
+  if ( reverse ) {
+    // start right sender
+    if (rte_eal_remote_launch(sendRecovery, right_spars, cpu_right_sender) )
+      std::cout << "Error: could not start Right Sender." << std::endl;
+
+    // set parameters for the left receiver
+    receiverParametersRecovery rpars(finish_receiving,leftport,"Reverse",phase[0].end_frame,phase[1].start_rate,1000*(duration-overload));
+    rpars.frames_to_send = scp.frames_to_send;
+
+    // start left receiver
+    if ( rte_eal_remote_launch(receiveRecovery, &rpars, cpu_left_receiver) )
+      std::cout << "Error: could not start Left Receiver." << std::endl;
+
+  }
+
+  std::cout << "Info: Testing started." << std::endl;
+
+  // wait until active senders and receivers finish
+  if ( forward ) {
+    rte_eal_wait_lcore(cpu_left_sender);
+    rte_eal_wait_lcore(cpu_right_receiver);
+  }
+  if ( reverse ) {
+    rte_eal_wait_lcore(cpu_right_sender);
+    rte_eal_wait_lcore(cpu_left_receiver);
+  }
+  deleteSenderParameters(left_spars);
+  deleteSenderParameters(right_spars);
+  finishRefDut();
+  finishPortStats();
+
+  std::cout << "Info: Test finished." << std::endl;
+}
+
+receiverParametersRecovery::receiverParametersRecovery(uint64_t finish_receiving_, uint8_t eth_id_, const char *side_, uint64_t reduction_frame_,
+                                                       uint32_t reduced_rate_, uint32_t recovery_ms_) :
+  receiverParameters(finish_receiving_,eth_id_,side_) {
+  reduction_frame = reduction_frame_;
+  reduced_rate = reduced_rate_;
+  recovery_ms = recovery_ms_;
+}
@@ -0,0 +1,61 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RECOVERY_H_INCLUDED
+#define RECOVERY_H_INCLUDED
+
+// the main class for RFC 2544 / RFC 8219 system recovery tests, adds some features to class Throughput:
+// the DUT is overloaded at RECOVERY_OVERLOAD percent of its throughput (the frame rate of the command line) for the given
+// time, then the frame rate is reduced to RECOVERY_REDUCED percent for the rest of the duration; the rates are switched by a
+// two segment rate profile, thus exactly at the scheduled TSC value; the frames are numbered PDV Frames, and the receivers
+// count them in 1ms long intervals of their scheduled sending time after the reduction: the recovery time is the end of the
+// last interval with frame loss
+class Recovery : public Throughput {
+public:
+  uint32_t overload;		// length of the overload phase (in seconds)
+  uint32_t throughput;		// the throughput of the DUT (the frame rate of the command line)
+  profileSegment phase[2];	// the overload and the recovery phases
+
+  Recovery() : Throughput() { program = "recovery"; }; // default constructor
+  ~Recovery() { if ( rate_profile.segments == phase ) delete [] rate_profile.steps; };
+  int readCmdLine(int argc, const char *argv[]);	// reads further one argument: overload
+  virtual int senderPoolSize(int numDestNets);
+  virtual uint64_t timestampMemory();	// the counters of the 1ms intervals of the recovery phase
+
+  // perform system recovery test
+  void measure(uint16_t leftport, uint16_t rightport);
+};
+
+class receiverParametersRecovery : public receiverParameters {
+  public:
+  uint64_t reduction_frame;	// the first frame of the recovery phase
+  uint32_t reduced_rate;	// frame rate of the recovery phase
+  uint32_t recovery_ms;		// length of the recovery phase (in milliseconds)
+  receiverParametersRecovery(uint64_t finish_receiving_, uint8_t eth_id_, const char *side_, uint64_t reduction_frame_,
+                             uint32_t reduced_rate_, uint32_t recovery_ms_);
+};
+
+// sends numbered PDV Frames according to the rate profile
+int sendRecovery(void *par);
+
+// receives PDV Frames, and evaluates the frame loss of the phases
+int receiveRecovery(void *par);
+
+#endif
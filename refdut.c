@@ -0,0 +1,536 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "defines.h"
+#include "includes.h"
+#include "refdut.h"
+
+eamTable::eamTable() {
+  memset(by6, 0, sizeof(by6));
+  memset(by4, 0, sizeof(by4));
+  entries = 0;
+}
+
+// adds a mapping; if either address is already mapped, the earlier mapping is kept
+// return: 0 on success, -1 if the table is full
+int eamTable::add(const struct in6_addr *ipv6, uint32_t ipv4, int v6_real) {
+  uint32_t i;
+  const uint32_t *w = reinterpret_cast<const uint32_t *>(ipv6);
+
+  if ( entries >= EAM_TABLE_SIZE/2 ) // the load factor is kept below 0.5
+    return -1;
+  if ( lookup6(ipv6->s6_addr) || lookup4(ipv4) )
+    return 0;
+  for ( i=hash(w[0]^w[1]^w[2]^w[3]); by6[i].used; i=(i+1)&(EAM_TABLE_SIZE-1) );
+  by6[i].ipv6 = *ipv6;
+  by6[i].ipv4 = ipv4;
+  by6[i].v6_real = v6_real;
+  by6[i].used = 1;
+  for ( i=hash(ipv4); by4[i].used; i=(i+1)&(EAM_TABLE_SIZE-1) );
+  by4[i].ipv4 = ipv4;
+  by4[i].ipv6 = *ipv6;
+  by4[i].v6_real = v6_real;
+  by4[i].used = 1;
+  entries++;
+  return 0;
+}
+
+// adds the mapping of an IPv6 and IPv4 address pair of siitperf.conf together with the mappings of the further destination networks,
+// which are produced by the senders by rewriting byte 7 of the IPv6 address and byte 2 of the IPv4 address (see send())
+// an unspecified address (:: or 0.0.0.0) means that the pair is not used
+// return: 0 on success, -1 if the table is full
+int eamTable::addNets(const struct in6_addr *ipv6, uint32_t ipv4, uint16_t num_nets, int v6_real) {
+  static const struct in6_addr unspecified = IN6ADDR_ANY_INIT;
+  struct in6_addr curr_ipv6 = *ipv6;
+  uint32_t curr_ipv4 = ipv4;
+  int i;
+
+  if ( ipv4 == 0 || memcmp(ipv6, &unspecified, sizeof(unspecified)) == 0 )
+    return 0;
+  if ( add(ipv6, ipv4, v6_real) )
+    return -1;
+  if ( num_nets > 1 )
+    for ( i=0; i<num_nets; i++ ) {
+      curr_ipv6.s6_addr[7] = (uint8_t) i;
+      ((uint8_t *)&curr_ipv4)[2] = (uint8_t) i;
+      if ( add(&curr_ipv6, curr_ipv4, v6_real) )
+        return -1;
+    }
+  return 0;
+}
+
+// sets the values of the data fields
+refDutParameters::refDutParameters(uint16_t left_port_, uint16_t right_port_, rte_mempool *pkt_pool_, eamTable *eam_,
+                                   struct ether_addr *mac_left_dut_, struct ether_addr *mac_right_dut_,
+                                   struct ether_addr *mac_left_tester_, struct ether_addr *mac_right_tester_, uint64_t finish_tsc_) {
+  left_port = left_port_;
+  right_port = right_port_;
+  pkt_pool = pkt_pool_;
+  eam = eam_;
+  mac_left_dut = mac_left_dut_;
+  mac_right_dut = mac_right_dut_;
+  mac_left_tester = mac_left_tester_;
+  mac_right_tester = mac_right_tester_;
+  finish_tsc = finish_tsc_;
+  memset(&forward, 0, sizeof(forward));
+  memset(&reverse, 0, sizeof(reverse));
+  memset(&imp_cfg, 0, sizeof(imp_cfg));
+  forward_imp = reverse_imp = 0;
+}
+
+// the queue is allocated on the NUMA node of the reference DUT
+impairment::impairment(const impairmentConfig *cfg_, uint32_t queue_size_, uint64_t hz, int socket) : ppm(0, 999999) {
+  cfg = cfg_;
+  queue_size = queue_size_;
+  queue = (slot *) rte_malloc_socket("impairment queue", queue_size*sizeof(slot), RTE_CACHE_LINE_SIZE, socket);
+  if ( !queue )
+    rte_exit(EXIT_FAILURE, "Error: Tester can't allocate memory for the impairment queue!\n");
+  head = tail = 0;
+  last_release = 0;
+  held = 0;
+  loss_left = 0;
+  gen.seed(std::random_device()());
+  tsc_per_us = hz/1000000;
+  histogram = new uint64_t[IMP_HIST_SIZE];
+  memset(histogram, 0, IMP_HIST_SIZE*sizeof(uint64_t));
+  lost = duplicated = reordered = queue_full = 0;
+}
+
+// the frames still in the queue are freed
+impairment::~impairment() {
+  for ( ; tail != head; tail++ )
+    rte_pktmbuf_free(queue[tail & (queue_size-1)].mbuf);
+  if ( held )
+    rte_pktmbuf_free(held);
+  rte_free(queue);
+  delete [] histogram;
+}
+
+// applies loss, reordering and duplication to a frame, and then enqueues it (or its copies)
+void impairment::add(struct rte_mbuf *m, uint64_t now, rte_mempool *pkt_pool) {
+  if ( loss_left || ( cfg->loss_ppm && ppm(gen) < cfg->loss_ppm ) ) {
+    loss_left = loss_left ? loss_left-1 : cfg->loss_burst-1;
+    lost++;
+    rte_pktmbuf_free(m);
+    return;
+  }
+  if ( cfg->dup_ppm && ppm(gen) < cfg->dup_ppm ) {
+    struct rte_mbuf *copy = rte_pktmbuf_alloc(pkt_pool);
+    if ( copy ) {
+      copy->pkt_len = copy->data_len = m->data_len;
+      rte_memcpy(rte_pktmbuf_mtod(copy, uint8_t *), rte_pktmbuf_mtod(m, uint8_t *), m->data_len);
+      enqueue(copy, now);
+      duplicated++;
+    }
+  }
+  if ( held ) {
+    enqueue(m, now);
+    enqueue(held, now); // the held frame is sent after the current one
+    held = 0;
+    reordered++;
+  } else if ( cfg->reorder_ppm && ppm(gen) < cfg->reorder_ppm ) {
+    held = m;
+  } else {
+    enqueue(m, now);
+  }
+}
+
+// calculates the release time of the frame and stores it in the queue
+void impairment::enqueue(struct rte_mbuf *m, uint64_t now) {
+  uint64_t jitter=0, release, bucket;
+
+  if ( unlikely( head-tail == queue_size ) ) {
+    queue_full++;
+    rte_pktmbuf_free(m);
+    return;
+  }
+  if ( cfg->jitter_tsc )
+    switch ( cfg->jitter_dist ) {
+      case 'U':
+        jitter = std::uniform_int_distribution<uint64_t>(0, cfg->jitter_tsc)(gen);
+        break;
+      case 'E':
+        jitter = std::exponential_distribution<double>(1.0/cfg->jitter_tsc)(gen);
+        break;
+      default: // 'N'
+        double j = std::normal_distribution<double>(cfg->jitter_tsc, cfg->jitter_tsc/3.0)(gen);
+        jitter = j > 0 ? j : 0;
+    }
+  release = now + cfg->delay_tsc + jitter;
+  if ( release < last_release )
+    release = last_release; // FIFO: a frame may not overtake the previous one
+  last_release = release;
+  bucket = (release-now)/tsc_per_us;
+  histogram[bucket < IMP_HIST_SIZE ? bucket : IMP_HIST_SIZE-1]++;
+  queue[head & (queue_size-1)].mbuf = m;
+  queue[head & (queue_size-1)].release_tsc = release;
+  head++;
+}
+
+// sends the frames, the release time of which has come (the ones not accepted by the ring are retried later)
+void impairment::release(uint16_t port, uint64_t now, refDutCounters *c) {
+  struct rte_mbuf *out[MAX_PKT_BURST];
+  int to_send=0;
+
+  while ( to_send < MAX_PKT_BURST && tail+to_send != head && queue[(tail+to_send) & (queue_size-1)].release_tsc <= now ) {
+    out[to_send] = queue[(tail+to_send) & (queue_size-1)].mbuf;
+    to_send++;
+  }
+  if ( to_send ) {
+    int sent = rte_eth_tx_burst(port, 0, out, to_send);
+    tail += sent;
+    c->sent += sent;
+  }
+}
+
+// reports the counters and the distribution of the applied delays (in milliseconds)
+void impairment::report(const char *side) {
+  uint64_t total=0, cumulated=0;
+  double min=-1, median=-1, perc99_9=-1, max=0;
+  int i;
+
+  for ( i=0; i<IMP_HIST_SIZE; i++ )
+    total += histogram[i];
+  for ( i=0; i<IMP_HIST_SIZE; i++ ) {
+    if ( !histogram[i] )
+      continue;
+    cumulated += histogram[i];
+    if ( min < 0 )
+      min = i/1000.0;
+    if ( median < 0 && cumulated >= (total+1)/2 )
+      median = i/1000.0;
+    if ( perc99_9 < 0 && cumulated >= ceil(0.999*total) )
+      perc99_9 = i/1000.0;
+    max = i/1000.0;
+  }
+  printf("Info: Impairment %s lost: %lu, duplicated: %lu, reordered: %lu, queue full: %lu, left in queue: %u\n",
+         side, lost, duplicated, reordered, queue_full, head-tail+(held ? 1 : 0));
+  if ( total )
+    printf("Info: Impairment %s delay (ms): min: %.3lf, median: %.3lf, 99.9th perc: %.3lf, max: %.3lf\n", side, min, median, perc99_9, max);
+}
+
+// The two ports of a connection share two rings: what one of them sends, the other one receives, like over a cable.
+// All four rings are created first, and then the ports of the Tester, so that they get the lowest port IDs.
+int createRefDutPorts(unsigned socket, uint16_t *tester_left, uint16_t *tester_right, uint16_t *dut_left, uint16_t *dut_right) {
+  rte_ring *left_t2d, *left_d2t, *right_t2d, *right_d2t; // t2d: from the Tester to the DUT, d2t: from the DUT to the Tester
+  int port;
+
+  left_t2d = rte_ring_create("ref_left_t2d", REF_DUT_RING_SIZE, socket, RING_F_SP_ENQ|RING_F_SC_DEQ);
+  left_d2t = rte_ring_create("ref_left_d2t", REF_DUT_RING_SIZE, socket, RING_F_SP_ENQ|RING_F_SC_DEQ);
+  right_t2d = rte_ring_create("ref_right_t2d", REF_DUT_RING_SIZE, socket, RING_F_SP_ENQ|RING_F_SC_DEQ);
+  right_d2t = rte_ring_create("ref_right_d2t", REF_DUT_RING_SIZE, socket, RING_F_SP_ENQ|RING_F_SC_DEQ);
+  if ( !left_t2d || !left_d2t || !right_t2d || !right_d2t )
+    return -1;
+
+  if ( (port = rte_eth_from_rings("ref_tester_left", &left_d2t, 1, &left_t2d, 1, socket)) < 0 )
+    return -1;
+  *tester_left = port;
+  if ( (port = rte_eth_from_rings("ref_tester_right", &right_d2t, 1, &right_t2d, 1, socket)) < 0 )
+    return -1;
+  *tester_right = port;
+  if ( (port = rte_eth_from_rings("ref_dut_left", &left_t2d, 1, &left_d2t, 1, socket)) < 0 )
+    return -1;
+  *dut_left = port;
+  if ( (port = rte_eth_from_rings("ref_dut_right", &right_t2d, 1, &right_d2t, 1, socket)) < 0 )
+    return -1;
+  *dut_right = port;
+  return 0;
+}
+
+// the rings may contain frames sent by the Tester but not read by the reference DUT, and frames sent by the reference DUT
+// but not read by the Tester (e.g. the ones arriving after the end of receiving), which belong to the pools of the trial
+void drainRefDutRings() {
+  const char *name[4] = { "ref_left_t2d", "ref_left_d2t", "ref_right_t2d", "ref_right_d2t" };
+  struct rte_mbuf *pkt_mbufs[MAX_PKT_BURST];
+  rte_ring *ring;
+  unsigned i, j, frames;
+
+  for ( i=0; i<4; i++ ) {
+    if ( !(ring = rte_ring_lookup(name[i])) )
+      continue;
+    while ( (frames = rte_ring_dequeue_burst(ring, (void **)pkt_mbufs, MAX_PKT_BURST, NULL)) )
+      for ( j=0; j<frames; j++ )
+        rte_pktmbuf_free(pkt_mbufs[j]);
+  }
+}
+
+// what the Left port sends, the Right port receives, and vice versa
+int createLoopbackPorts(unsigned socket, uint16_t *left, uint16_t *right) {
+  rte_ring *l2r, *r2l;
+  int port;
+
+  l2r = rte_ring_create("loopback_l2r", REF_DUT_RING_SIZE, socket, RING_F_SP_ENQ|RING_F_SC_DEQ);
+  r2l = rte_ring_create("loopback_r2l", REF_DUT_RING_SIZE, socket, RING_F_SP_ENQ|RING_F_SC_DEQ);
+  if ( !l2r || !r2l )
+    return -1;
+  if ( (port = rte_eth_from_rings("loopback_left", &r2l, 1, &l2r, 1, socket)) < 0 )
+    return -1;
+  *left = port;
+  if ( (port = rte_eth_from_rings("loopback_right", &l2r, 1, &r2l, 1, socket)) < 0 )
+    return -1;
+  *right = port;
+  return 0;
+}
+
+// adjusts an Internet checksum after some 16-bit words of the covered data were replaced (RFC 1624, eqn. 3)
+// as the ones' complement sum is byte order independent, the words are used in network byte order
+static inline uint16_t csumAdjust(uint16_t cksum, const uint16_t *old_words, int num_old, const uint16_t *new_words, int num_new) {
+  uint32_t sum = (uint16_t) ~cksum;
+  int i;
+
+  for ( i=0; i<num_old; i++ )
+    sum += (uint16_t) ~old_words[i];
+  for ( i=0; i<num_new; i++ )
+    sum += new_words[i];
+  while ( sum >> 16 )
+    sum = (sum & 0xffff) + (sum >> 16);
+  return (uint16_t) ~sum;
+}
+
+// offset of the checksum field in the UDP or TCP header (0, if the protocol is not supported)
+static inline int l4CksumOffset(uint8_t proto) {
+  return proto == 17 ? 6 : proto == 6 ? 16 : 0;
+}
+
+// translates an IPv6 frame to IPv4 (RFC 7915 Section 5.1)
+// src_ipv4 and dst_ipv4 are the mapped addresses, the Hop Limit is checked by the caller
+static struct rte_mbuf *translate6to4(struct rte_mbuf *in, rte_mempool *pkt_pool, const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
+                                      const uint32_t *src_ipv4, const uint32_t *dst_ipv4, refDutCounters *c) {
+  uint8_t *in_pkt = rte_pktmbuf_mtod(in, uint8_t *);
+  ipv6_hdr *ip6 = reinterpret_cast<ipv6_hdr *>(in_pkt+sizeof(ether_hdr));
+  uint16_t payload_len = ntohs(ip6->payload_len);
+  int cksum_offset = l4CksumOffset(ip6->proto);
+
+  if ( unlikely( !cksum_offset || in->data_len < sizeof(ether_hdr)+sizeof(ipv6_hdr)+payload_len ) ) {
+    c->unsupported++;
+    return 0;
+  }
+  struct rte_mbuf *out = rte_pktmbuf_alloc(pkt_pool);
+  if ( unlikely( !out ) ) {
+    c->no_mbuf++;
+    return 0;
+  }
+  out->pkt_len = out->data_len = sizeof(ether_hdr)+sizeof(ipv4_hdr)+payload_len;
+  uint8_t *out_pkt = rte_pktmbuf_mtod(out, uint8_t *);
+  ipv4_hdr *ip4 = reinterpret_cast<ipv4_hdr *>(out_pkt+sizeof(ether_hdr));
+  uint8_t *l4 = out_pkt+sizeof(ether_hdr)+sizeof(ipv4_hdr);
+
+  rte_memcpy(&reinterpret_cast<ether_hdr *>(out_pkt)->d_addr, dst_mac, sizeof(struct ether_addr));
+  rte_memcpy(&reinterpret_cast<ether_hdr *>(out_pkt)->s_addr, src_mac, sizeof(struct ether_addr));
+  reinterpret_cast<ether_hdr *>(out_pkt)->ether_type = htons(0x0800);
+  ip4->version_ihl = 0x45;
+  ip4->type_of_service = (ntohl(ip6->vtc_flow) >> 20) & 0xff; // Traffic Class
+  ip4->total_length = htons(sizeof(ipv4_hdr)+payload_len);
+  ip4->packet_id = 0; // no fragment identification algorithm is implemented
+  ip4->fragment_offset = sizeof(ipv4_hdr)+payload_len > 1260 ? htons(0x4000) : 0; // DF is set above 1260 bytes
+  ip4->time_to_live = ip6->hop_limits-1;
+  ip4->next_proto_id = ip6->proto;
+  ip4->src_addr = *src_ipv4;
+  ip4->dst_addr = *dst_ipv4;
+  ip4->hdr_checksum = 0;
+  ip4->hdr_checksum = rte_ipv4_cksum(ip4);
+  rte_memcpy(l4, in_pkt+sizeof(ether_hdr)+sizeof(ipv6_hdr), payload_len);
+  // only the addresses of the pseudo header have changed
+  uint32_t ipv4_addrs[2] = { *src_ipv4, *dst_ipv4 };
+  uint16_t *l4_cksum = reinterpret_cast<uint16_t *>(l4+cksum_offset);
+  *l4_cksum = csumAdjust(*l4_cksum, reinterpret_cast<const uint16_t *>(ip6->src_addr), 16,
+                         reinterpret_cast<const uint16_t *>(ipv4_addrs), 4);
+  if ( ip4->next_proto_id == 17 && *l4_cksum == 0 )
+    *l4_cksum = 0xffff; // 0 means no checksum in UDP
+  c->translated++;
+  return out;
+}
+
+// translates an IPv4 frame to IPv6 (RFC 7915 Section 4.1)
+// IPv4 options are ignored, fragments are not supported, TTL is checked by the caller
+static struct rte_mbuf *translate4to6(struct rte_mbuf *in, rte_mempool *pkt_pool, const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
+                                      const struct in6_addr *src_ipv6, const struct in6_addr *dst_ipv6, refDutCounters *c) {
+  uint8_t *in_pkt = rte_pktmbuf_mtod(in, uint8_t *);
+  ipv4_hdr *ip4 = reinterpret_cast<ipv4_hdr *>(in_pkt+sizeof(ether_hdr));
+  int ihl = (ip4->version_ihl & 0x0f)*4;
+  int payload_len = ntohs(ip4->total_length)-ihl;
+  int cksum_offset = l4CksumOffset(ip4->next_proto_id);
+
+  if ( unlikely( !cksum_offset || ihl < (int)sizeof(ipv4_hdr) || payload_len < 0 || (ip4->fragment_offset & htons(0x3fff)) ||
+                 in->data_len < sizeof(ether_hdr)+ihl+payload_len ) ) {
+    c->unsupported++;
+    return 0;
+  }
+  struct rte_mbuf *out = rte_pktmbuf_alloc(pkt_pool);
+  if ( unlikely( !out ) ) {
+    c->no_mbuf++;
+    return 0;
+  }
+  out->pkt_len = out->data_len = sizeof(ether_hdr)+sizeof(ipv6_hdr)+payload_len;
+  uint8_t *out_pkt = rte_pktmbuf_mtod(out, uint8_t *);
+  ipv6_hdr *ip6 = reinterpret_cast<ipv6_hdr *>(out_pkt+sizeof(ether_hdr));
+  uint8_t *l4 = out_pkt+sizeof(ether_hdr)+sizeof(ipv6_hdr);
+
+  rte_memcpy(&reinterpret_cast<ether_hdr *>(out_pkt)->d_addr, dst_mac, sizeof(struct ether_addr));
+  rte_memcpy(&reinterpret_cast<ether_hdr *>(out_pkt)->s_addr, src_mac, sizeof(struct ether_addr));
+  reinterpret_cast<ether_hdr *>(out_pkt)->ether_type = htons(0x86DD);
+  ip6->vtc_flow = htonl(0x60000000 | ip4->type_of_service << 20); // Version: 6, Traffic Class: TOS, Flow Label: 0
+  ip6->payload_len = htons(payload_len);
+  ip6->proto = ip4->next_proto_id;
+  ip6->hop_limits = ip4->time_to_live-1;
+  rte_mov16(ip6->src_addr, src_ipv6->s6_addr);
+  rte_mov16(ip6->dst_addr, dst_ipv6->s6_addr);
+  rte_memcpy(l4, in_pkt+sizeof(ether_hdr)+ihl, payload_len);
+  uint16_t *l4_cksum = reinterpret_cast<uint16_t *>(l4+cksum_offset);
+  if ( ip6->proto == 17 && *l4_cksum == 0 ) {
+    *l4_cksum = rte_ipv6_udptcp_cksum(ip6, l4); // the UDP checksum is mandatory in IPv6
+  } else {
+    // only the addresses of the pseudo header have changed
+    uint32_t ipv4_addrs[2] = { ip4->src_addr, ip4->dst_addr };
+    *l4_cksum = csumAdjust(*l4_cksum, reinterpret_cast<const uint16_t *>(ipv4_addrs), 4,
+                           reinterpret_cast<const uint16_t *>(ip6->src_addr), 16);
+    if ( ip6->proto == 17 && *l4_cksum == 0 )
+      *l4_cksum = 0xffff;
+  }
+  c->translated++;
+  return out;
+}
+
+// forwards a frame without translation: it is copied, MAC addresses are rewritten, and TTL or Hop Limit is decremented
+static struct rte_mbuf *forwardNative(struct rte_mbuf *in, rte_mempool *pkt_pool, const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
+                                      int ip_version, refDutCounters *c) {
+  struct rte_mbuf *out = rte_pktmbuf_alloc(pkt_pool);
+  if ( unlikely( !out ) ) {
+    c->no_mbuf++;
+    return 0;
+  }
+  out->pkt_len = out->data_len = in->data_len;
+  uint8_t *out_pkt = rte_pktmbuf_mtod(out, uint8_t *);
+  rte_memcpy(out_pkt, rte_pktmbuf_mtod(in, uint8_t *), in->data_len);
+  rte_memcpy(&reinterpret_cast<ether_hdr *>(out_pkt)->d_addr, dst_mac, sizeof(struct ether_addr));
+  rte_memcpy(&reinterpret_cast<ether_hdr *>(out_pkt)->s_addr, src_mac, sizeof(struct ether_addr));
+  if ( ip_version == 6 ) {
+    reinterpret_cast<ipv6_hdr *>(out_pkt+sizeof(ether_hdr))->hop_limits--;
+  } else {
+    ipv4_hdr *ip4 = reinterpret_cast<ipv4_hdr *>(out_pkt+sizeof(ether_hdr));
+    ip4->time_to_live--;
+    ip4->hdr_checksum = 0;
+    ip4->hdr_checksum = rte_ipv4_cksum(ip4);
+  }
+  c->forwarded++;
+  return out;
+}
+
+// processes a received frame: it is translated, if its source address is a real address of the Tester and its destination address
+// is a virtual one (both of them have a mapping), otherwise forwarded (e.g. the background traffic between the real IPv6 addresses)
+// return: the new frame to be sent, or NULL, if the received frame is dropped
+static inline struct rte_mbuf *processFrame(struct rte_mbuf *in, rte_mempool *pkt_pool, eamTable *eam,
+                                            const struct ether_addr *dst_mac, const struct ether_addr *src_mac, refDutCounters *c) {
+  uint8_t *pkt = rte_pktmbuf_mtod(in, uint8_t *);
+  uint16_t ether_type = reinterpret_cast<ether_hdr *>(pkt)->ether_type;
+
+  if ( unlikely( in->nb_segs > 1 ) ) {
+    c->unsupported++;
+    return 0;
+  }
+  if ( ether_type == htons(0x86DD) && in->data_len >= sizeof(ether_hdr)+sizeof(ipv6_hdr) ) {
+    ipv6_hdr *ip6 = reinterpret_cast<ipv6_hdr *>(pkt+sizeof(ether_hdr));
+    if ( unlikely( ip6->hop_limits <= 1 ) ) {
+      c->expired++;
+      return 0;
+    }
+    const eamTable::entry6 *src = eam->lookup6(ip6->src_addr);
+    const eamTable::entry6 *dst = eam->lookup6(ip6->dst_addr);
+    if ( src && dst && src->v6_real && !dst->v6_real )
+      return translate6to4(in, pkt_pool, dst_mac, src_mac, &src->ipv4, &dst->ipv4, c);
+    return forwardNative(in, pkt_pool, dst_mac, src_mac, 6, c);
+  }
+  if ( ether_type == htons(0x0800) && in->data_len >= sizeof(ether_hdr)+sizeof(ipv4_hdr) ) {
+    ipv4_hdr *ip4 = reinterpret_cast<ipv4_hdr *>(pkt+sizeof(ether_hdr));
+    if ( unlikely( ip4->time_to_live <= 1 ) ) {
+      c->expired++;
+      return 0;
+    }
+    const eamTable::entry4 *src = eam->lookup4(ip4->src_addr);
+    const eamTable::entry4 *dst = eam->lookup4(ip4->dst_addr);
+    if ( src && dst && !src->v6_real && dst->v6_real )
+      return translate4to6(in, pkt_pool, dst_mac, src_mac, &src->ipv6, &dst->ipv6, c);
+    return forwardNative(in, pkt_pool, dst_mac, src_mac, 4, c);
+  }
+  c->unsupported++; // neither IPv6 nor IPv4
+  return 0;
+}
+
+// receives a burst of frames on one port and sends the processed frames on the other one
+// The received mbufs belong to the pools of the Tester's senders, which keep sending them, thus they may not be modified.
+// If there is an impairment stage, then the processed frames are passed to it instead.
+static inline void forwardBurst(uint16_t rx_port, uint16_t tx_port, rte_mempool *pkt_pool, eamTable *eam,
+                                const struct ether_addr *dst_mac, const struct ether_addr *src_mac, refDutCounters *c,
+                                impairment *imp, uint64_t now) {
+  struct rte_mbuf *in[MAX_PKT_BURST], *out[MAX_PKT_BURST];
+  int frames, to_send=0, sent, i;
+
+  frames = rte_eth_rx_burst(rx_port, 0, in, MAX_PKT_BURST);
+  if ( !frames )
+    return;
+  c->received += frames;
+  for ( i=0; i<frames; i++ ) {
+    if ( (out[to_send] = processFrame(in[i], pkt_pool, eam, dst_mac, src_mac, c)) )
+      to_send++;
+    rte_pktmbuf_free(in[i]);
+  }
+  if ( imp ) {
+    for ( i=0; i<to_send; i++ )
+      imp->add(out[i], now, pkt_pool);
+    return;
+  }
+  sent = rte_eth_tx_burst(tx_port, 0, out, to_send);
+  c->sent += sent;
+  if ( unlikely( sent < to_send ) ) {
+    c->tx_full += to_send-sent;
+    for ( i=sent; i<to_send; i++ )
+      rte_pktmbuf_free(out[i]);
+  }
+}
+
+// prints the counters of the reference DUT for one direction
+static void reportRefDut(const refDutCounters *c, const char *side) {
+  printf("Info: Reference DUT %s received: %lu, translated: %lu, forwarded: %lu, sent: %lu\n", side, c->received, c->translated, c->forwarded, c->sent);
+  printf("Info: Reference DUT %s dropped: unsupported: %lu, expired: %lu, no mbuf: %lu, TX ring full: %lu\n",
+         side, c->unsupported, c->expired, c->no_mbuf, c->tx_full);
+}
+
+// translates and forwards frames in both directions until finish_tsc
+// (the inactive direction costs only an empty rte_eth_rx_burst() call)
+int refDut(void *par) {
+  class refDutParameters *p = (class refDutParameters *)par;
+  uint64_t now;		// current TSC value
+
+  while ( (now=rte_rdtsc()) < p->finish_tsc ) {
+    forwardBurst(p->left_port, p->right_port, p->pkt_pool, p->eam, p->mac_right_tester, p->mac_right_dut, &p->forward, p->forward_imp, now);
+    forwardBurst(p->right_port, p->left_port, p->pkt_pool, p->eam, p->mac_left_tester, p->mac_left_dut, &p->reverse, p->reverse_imp, now);
+    if ( p->forward_imp ) {
+      p->forward_imp->release(p->right_port, now, &p->forward);
+      p->reverse_imp->release(p->left_port, now, &p->reverse);
+    }
+  }
+  reportRefDut(&p->forward, "Forward");
+  reportRefDut(&p->reverse, "Reverse");
+  if ( p->forward_imp ) {
+    p->forward_imp->report("Forward");
+    p->reverse_imp->report("Reverse");
+  }
+  return 0;
+}
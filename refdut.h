@@ -0,0 +1,144 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef REFDUT_H_INCLUDED
+#define REFDUT_H_INCLUDED
+
+// Built-in reference DUT: a stateless IPv4/IPv6 translator (SIIT, RFC 7915) using explicit address mappings (RFC 7757).
+// It is connected to the Tester by net_ring virtual ports, thus siitperf can be tested on a single host without NICs,
+// and its results give a software baseline, which can be compared across different versions of the Tester.
+
+// explicit address mapping table: exact IPv6 address <-> IPv4 address pairs in two open addressing hash tables;
+// v6_real tells which address of a pair belongs to a port of the Tester: 1: the IPv6 address (the IPv4 address is its allusion),
+// 0: the IPv4 address
+class eamTable {
+public:
+  struct entry6 { struct in6_addr ipv6; uint32_t ipv4; int v6_real; int used; };	// slot of the IPv6 -> IPv4 table
+  struct entry4 { uint32_t ipv4; struct in6_addr ipv6; int v6_real; int used; };	// slot of the IPv4 -> IPv6 table
+  entry6 by6[EAM_TABLE_SIZE];	// for the translation of IPv6 addresses
+  entry4 by4[EAM_TABLE_SIZE];	// for the translation of IPv4 addresses
+  int entries;			// number of mappings stored
+
+  int add(const struct in6_addr *ipv6, uint32_t ipv4, int v6_real);
+  int addNets(const struct in6_addr *ipv6, uint32_t ipv4, uint16_t num_nets, int v6_real);
+
+  // returns the mapping of the given IPv6 address, or NULL if there is no such mapping
+  inline const entry6 *lookup6(const uint8_t *ipv6) {
+    const uint32_t *w = reinterpret_cast<const uint32_t *>(ipv6);
+    for ( uint32_t i=hash(w[0]^w[1]^w[2]^w[3]); by6[i].used; i=(i+1)&(EAM_TABLE_SIZE-1) )
+      if ( memcmp(&by6[i].ipv6, ipv6, 16) == 0 )
+        return &by6[i];
+    return 0;
+  }
+
+  // returns the mapping of the given IPv4 address, or NULL if there is no such mapping
+  inline const entry4 *lookup4(uint32_t ipv4) {
+    for ( uint32_t i=hash(ipv4); by4[i].used; i=(i+1)&(EAM_TABLE_SIZE-1) )
+      if ( by4[i].ipv4 == ipv4 )
+        return &by4[i];
+    return 0;
+  }
+
+  static inline uint32_t hash(uint32_t x) {
+    x = (x ^ (x >> 16)) * 0x45d9f3b;
+    return (x ^ (x >> 16)) & (EAM_TABLE_SIZE-1);
+  }
+
+  eamTable();
+};
+
+// counters of the reference DUT for one direction
+struct refDutCounters {
+  uint64_t received;	// frames received from the Tester
+  uint64_t translated;	// frames translated from IPv6 to IPv4 or from IPv4 to IPv6
+  uint64_t forwarded;	// frames forwarded without translation (e.g. the background traffic)
+  uint64_t unsupported;	// dropped: not UDP or TCP, IPv4 fragment, IPv6 extension header, multi-segment mbuf, etc.
+  uint64_t expired;	// dropped: TTL or Hop Limit would become 0
+  uint64_t no_mbuf;	// dropped: no mbuf for the outgoing frame
+  uint64_t tx_full;	// dropped: the ring towards the Tester was full
+  uint64_t sent;	// frames sent to the Tester
+};
+
+// configuration of the impairment stage of the reference DUT (all zero: no impairment)
+struct impairmentConfig {
+  uint64_t delay_tsc;	// fixed delay
+  uint64_t jitter_tsc;	// parameter of the jitter distribution (the jitter is added to the fixed delay)
+  char jitter_dist;	// 'U': uniform in [0, jitter], 'E': exponential with mean jitter, 'N': normal with mean jitter and deviation jitter/3 (cut at 0)
+  uint32_t loss_ppm;	// probability of a loss event (per million frames)
+  uint16_t loss_burst;	// number of consecutive frames lost in a loss event
+  uint32_t dup_ppm;	// probability of duplicating a frame (per million frames)
+  uint32_t reorder_ppm;	// probability of holding back a frame and sending it after the next one (per million frames)
+};
+
+// impairment stage of the reference DUT for one direction: the processed frames are dropped, duplicated or reordered,
+// and then delayed in a FIFO queue (the jitter does not reorder the frames, because their release times are kept monotonic)
+// the applied delays are collected in a histogram of 1 microsecond resolution, which gives the ground truth for the latency and PDV results
+class impairment {
+public:
+  struct slot { struct rte_mbuf *mbuf; uint64_t release_tsc; };
+  const impairmentConfig *cfg;
+  slot *queue;			// the frames are stored at head and released from tail
+  uint32_t queue_size, head, tail;	// queue_size MUST be a power of 2
+  uint64_t last_release;	// release time of the last enqueued frame
+  struct rte_mbuf *held;	// frame held back for reordering (if not NULL)
+  uint16_t loss_left;		// remaining frames of the current loss event
+  std::mt19937_64 gen;		// random number generator for all decisions
+  std::uniform_int_distribution<uint32_t> ppm;	// uniform distribution in [0, 999999]
+  uint64_t tsc_per_us;		// for the histogram
+  uint64_t *histogram;		// histogram of the applied delays, longer ones are counted in the last bucket
+  uint64_t lost, duplicated, reordered, queue_full;	// counters
+
+  impairment(const impairmentConfig *cfg_, uint32_t queue_size_, uint64_t hz, int socket);
+  ~impairment();
+  void add(struct rte_mbuf *m, uint64_t now, rte_mempool *pkt_pool);
+  void enqueue(struct rte_mbuf *m, uint64_t now);
+  void release(uint16_t port, uint64_t now, refDutCounters *c);
+  void report(const char *side);
+};
+
+// to store the parameters of the reference DUT
+class refDutParameters {
+public:
+  uint16_t left_port, right_port;	// DUT's own (net_ring) ports
+  rte_mempool *pkt_pool;		// for the outgoing frames
+  eamTable *eam;			// address mappings
+  struct ether_addr *mac_left_dut, *mac_right_dut, *mac_left_tester, *mac_right_tester;
+  uint64_t finish_tsc;			// the reference DUT stops at this time
+  refDutCounters forward, reverse;	// counters for the left to right and for the right to left directions
+  impairmentConfig imp_cfg;		// impairment settings (set after construction)
+  impairment *forward_imp, *reverse_imp;	// impairment stages (NULL, if no impairment is used)
+  refDutParameters(uint16_t left_port_, uint16_t right_port_, rte_mempool *pkt_pool_, eamTable *eam_,
+                   struct ether_addr *mac_left_dut_, struct ether_addr *mac_right_dut_,
+                   struct ether_addr *mac_left_tester_, struct ether_addr *mac_right_tester_, uint64_t finish_tsc_);
+};
+
+// creates the net_ring ports of the Tester and of the reference DUT (the ports of the Tester are created first)
+int createRefDutPorts(unsigned socket, uint16_t *tester_left, uint16_t *tester_right, uint16_t *dut_left, uint16_t *dut_right);
+
+// frees the frames left in the rings of the net_ring ports of the reference DUT (before the packet pools of a trial are freed)
+void drainRefDutRings();
+
+// creates two net_ring ports connected back to back (for the calibration of the Tester)
+int createLoopbackPorts(unsigned socket, uint16_t *left, uint16_t *right);
+
+// translates and forwards frames between its two ports until finish_tsc
+int refDut(void *par);
+
+#endif
@@ -0,0 +1,42 @@
+#!/bin/bash
+# RFC 2544 back-to-back frames test in a single siitperf session: a binary search finds the longest train of frames sent at
+# the maximum frame rate, which the DUT forwards without loss. Every trial sends one train per second for $trains seconds.
+# The trials are sent to "./build/siitperf" through a coprocess started by session.sh.
+#Parameters
+rate=14880952 # frame rate within the trains: the maximum frame rate of the media for the given frame size
+fs=84 # IPv6 frame size; IPv4 frame size is always 20 bytes less
+trains=50 # number of trains (one per second), RFC 2544 requires at least 50
+to=2000 # timeout in milliseconds
+n=2 # foreground traffic, if ( frame_counter % n < m )
+m=2 # E.g. n=m=2 is all foreground traffic; n=2,m=0 is all background traffic; n=10,m=9 is 90% fg and 10% bg
+e=1 # measurement error: the difference betwen the values of the higher and the lower bound of the binary search, when finishing
+log="back-to-back.log"
+
+############################
+
+date +'Date&Time: %Y-%m-%d %H:%M:%S.%N' > $log
+. "$(dirname "$0")/session.sh"
+
+# binary search for the train length in the [l, h] interval: the whole second is the longest possible train
+l=0
+h=$rate
+while [ $((h-l)) -gt $e ]; do
+	len=$(((h+l)/2))
+	trial b2b $fs $rate $trains $to $n $m $len
+	passed=1
+	for side in Forward Reverse; do
+		sent=$(grep "^$side frames sent:" temp.out | awk '{print $4}')
+		rec=$(grep "^$side frames received:" temp.out | awk '{print $4}')
+		if [ -n "$sent" ] && [ "$rec" != "$sent" ]; then
+			passed=0
+		fi
+	done
+	if [ $passed -eq 1 ]; then
+		l=$len
+	else
+		h=$len
+	fi
+done
+echo "Back-to-back frames: $l (burst of $(awk -v l=$l -v r=$rate 'BEGIN { printf "%.6f", l/r }') seconds)" | tee -a $log
+
+endSession
@@ -0,0 +1,88 @@
+#!/bin/bash
+# Calibration of the Tester: finds the highest loss-free, on-schedule frame rate of siitperf-tp, siitperf-lat and siitperf-pdv
+# for each frame size and direction without a DUT, and stores them in "siitperf.cal". Later tests give a warning, if their
+# frame rate is close to the calibrated maximum rate (see CALIBRATION_MARGIN in defines.h).
+# Requirements: the Left and Right ports are connected by a loopback cable, or "Ring-Loopback 1" is set in "siitperf.conf",
+# which must contain the same lcores as the later tests. The "Forward" and "Reverse" lines are set by this script in a copy.
+# The capacity of the consolidated lcores of siitperf-tp is calibrated as "tp-c1" and "tp-c2" (the "Core-Consol" line is set, too),
+# it is used as a hard limit of the frame rate by the later tests with core consolidation.
+#Parameters
+programs="tp lat pdv" # programs to be calibrated, tp-c1 and tp-c2 may be added
+sizes="84 1518" # IPv6 frame sizes; IPv4 frame size is always 20 bytes less
+dirs="b f r" # valid values: b,f,r; b: bidirectional, f: forward (Left to Right), r: reverse (Right to Left)
+max=14880952 # maximum frame rate
+xpts=10 # duration (in seconds) of an experiment instance
+to=2000 # timeout in milliseconds
+n=2 # foreground traffic, if ( frame_counter % n < m )
+m=2 # E.g. n=m=2 is all foreground traffic; n=2,m=0 is all background traffic; n=10,m=9 is 90% fg and 10% bg
+delay=2 # delay before the insertion of the first identifying tag (siitperf-lat)
+tags=1000 # number of identifying tags (siitperf-lat)
+e=1000 # measurement error: the difference betwen the values of the higher and the lower bound of the binary search, when finishing
+calfile="siitperf.cal" # it MUST be the same as CALIBRATIONFILE in defines.h
+
+############################
+
+cp -a siitperf.conf siitperf.conf.orig
+trap 'mv siitperf.conf.orig siitperf.conf' EXIT
+touch $calfile
+date +'Date&Time: %Y-%m-%d %H:%M:%S.%N' > calibration.log
+
+for prog in $programs; do
+	case $prog in
+		tp|tp-c*) args="" ;;
+		lat) args="$delay $tags" ;;
+		pdv) args="0" ;; # proper PDV measurement
+	esac
+	for fs in $sizes; do
+		for dir in $dirs; do
+			# set the direction in the configuration file
+			fwd=$([ "$dir" != "r" ] && echo 1 || echo 0)
+			rev=$([ "$dir" != "f" ] && echo 1 || echo 0)
+			sed -e "s/^Forward .*/Forward $fwd/" -e "s/^Reverse .*/Reverse $rev/" -e "/^Core-Consol /d" siitperf.conf.orig > siitperf.conf
+			if [ "$prog" != "${prog%-c*}" ]; then
+				echo "Core-Consol ${prog#*-c}" >> siitperf.conf
+			fi
+			# the earlier result must not limit the search (it is a hard limit with core consolidation)
+			grep -v "^$prog $fs $dir " $calfile > temp.cal
+			mv temp.cal $calfile
+			# Execute a binary search in the [l, h] interval
+			l=0
+			h=$max
+			while [ $((h-l)) -gt $e ]; do
+				r=$(((h+l)/2))
+				echo "Command line is: ./build/siitperf-${prog%-c*} $fs $r $xpts $to $n $m $args" | tee -a calibration.log
+				./build/siitperf-${prog%-c*} $fs $r $xpts $to $n $m $args > temp.out 2>&1
+				status=$?
+				cat temp.out >> calibration.log
+				if [ -n "$(grep 'Error:' temp.out)" ]; then
+					echo "Error occurred, calibration must stop."
+					exit -1
+				fi
+				# the test passes, if it was valid (sent on schedule), all frames were received and the ports of the Tester did not drop any
+				passed=1
+				if [ $status -ne 0 ] || [ -n "$(grep 'invalid\|tester-limited' temp.out)" ]; then
+					passed=0
+				fi
+				for side in $([ $fwd -eq 1 ] && echo Forward) $([ $rev -eq 1 ] && echo Reverse); do
+					rec=$(grep "^$side frames received:" temp.out | awk '{print $4}')
+					if [ "$rec" != "$((xpts*r))" ]; then
+						passed=0
+					fi
+				done
+				if [ $passed -eq 1 ]; then
+					l=$r
+					echo TEST PASSED | tee -a calibration.log
+				else
+					h=$r
+					echo TEST FAILED | tee -a calibration.log
+				fi
+			done
+			echo "Maximum rate of siitperf-$prog, frame size $fs, direction $dir: $l fps" | tee -a calibration.log
+			# the earlier result for the same program, frame size and direction is replaced
+			grep -v "^$prog $fs $dir " $calfile > temp.cal
+			echo "$prog $fs $dir $l # $(date +%F)" >> temp.cal
+			mv temp.cal $calfile
+		done
+	done
+done
+rm -f temp.out
@@ -0,0 +1,51 @@
+#!/bin/bash
+# RFC 8219 measurement campaign in a single siitperf session: throughput is determined by a binary search,
+# then latency and PDV are measured at the resulting rate, without re-initializing the EAL and the ports.
+# The trials are sent to "./build/siitperf" through a coprocess started by session.sh.
+#Parameters
+max=1600000 # maximum frame rate
+fs=84 # IPv6 frame size; IPv4 frame size is always 20 bytes less
+xpts=60 # duration (in seconds) of an experiment instance
+to=2000 # timeout in milliseconds
+n=2 # foreground traffic, if ( frame_counter % n < m )
+m=2 # E.g. n=m=2 is all foreground traffic; n=2,m=0 is all background traffic; n=10,m=9 is 90% fg and 10% bg
+e=1 # measurement error: the difference betwen the values of the higher and the lower bound of the binary search, when finishing
+delay=60 # delay before the insertion of the first identifying tag (latency)
+tags=50000 # number of identifying tags (latency)
+lat_xpts=120 # duration (in seconds) of the latency measurement
+log="campaign.log"
+
+############################
+
+date +'Date&Time: %Y-%m-%d %H:%M:%S.%N' > $log
+. "$(dirname "$0")/session.sh"
+
+# throughput: binary search in the [l, h] interval
+l=0
+h=$max
+while [ $((h-l)) -gt $e ]; do
+	r=$(((h+l)/2))
+	trial tp $fs $r $xpts $to $n $m
+	passed=1
+	for side in Forward Reverse; do
+		sent=$(grep "^$side frames sent:" temp.out | awk '{print $4}')
+		rec=$(grep "^$side frames received:" temp.out | awk '{print $4}')
+		if [ -n "$sent" ] && [ "$rec" != "$sent" ]; then
+			passed=0
+		fi
+	done
+	if [ $passed -eq 1 ]; then
+		l=$r
+	else
+		h=$r
+	fi
+done
+echo "Throughput: $l fps" | tee -a $log
+
+# latency and PDV at the throughput rate
+trial lat $fs $l $lat_xpts $to $n $m $delay $tags
+grep "TL\|WCL" temp.out
+trial pdv $fs $l $xpts $to $n $m
+grep "PDV" temp.out
+
+endSession
@@ -0,0 +1,86 @@
+#!/bin/bash
+# Accuracy benchmark: the reference DUT applies known impairments, and the results of the Tester are checked against them.
+# Requirements: "siitperf.conf" contains "CPU-Ref-DUT" and no "Imp-" lines (they are appended by this script to a copy),
+# the DUT MAC addresses may be anything, as the Tester and the reference DUT are connected by net_ring ports.
+#Parameters
+r=1000000 # frame rate
+fs=84 # IPv6 frame size; IPv4 frame size is always 20 bytes less
+xpts=10 # duration (in seconds) of an experiment instance
+to=2000 # timeout in milliseconds
+n=2 # foreground traffic, if ( frame_counter % n < m )
+m=2 # E.g. n=m=2 is all foreground traffic; n=2,m=0 is all background traffic; n=10,m=9 is 90% fg and 10% bg
+delay=2 # delay before the insertion of the first identifying tag (latency)
+tags=10000 # number of identifying tags (latency)
+tol=0.02 # tolerance (in milliseconds) for TL, WCL and PDV, it should cover the latency of the rings and the granularity of the histogram
+imp_delay=1000 # fixed delay (in microseconds) for the latency and PDV experiments
+imp_jitter=200 # jitter (in microseconds) for the latency and PDV experiments
+
+############################
+
+failed=0
+cp -a siitperf.conf siitperf.conf.orig
+trap 'mv siitperf.conf.orig siitperf.conf' EXIT
+
+# runs a command with the given impairment lines appended to siitperf.conf
+run() {
+	impairments=$1
+	shift
+	cp -a siitperf.conf.orig siitperf.conf
+	echo -e "$impairments" >> siitperf.conf
+	echo "Command line is: $*"
+	$* > temp.out 2>&1
+	cat temp.out >> accuracy.log
+	if [ -n "$(grep 'Error:' temp.out)" ]; then
+		echo "Error occurred, testing must stop."
+		exit -1
+	fi
+}
+
+# checks if |$2-$3| <= $4
+check() {
+	if awk -v a=$2 -v b=$3 -v t=$4 'BEGIN { d=a-b; if ( d<0 ) d=-d; exit !(d<=t) }'; then
+		echo "PASS: $1: measured: $2, expected: $3"
+	else
+		echo "FAIL: $1: measured: $2, expected: $3, tolerance: $4"
+		failed=1
+	fi
+}
+
+# prints field $2 (e.g. "median:") of the impairment delay line of side $1
+truth() {
+	grep "Impairment $1 delay" temp.out | sed 's/,//g' | awk -v k=$2 '{ for ( i=1; i<NF; i++ ) if ( $i==k ) print $(i+1) }'
+}
+
+date +'Date&Time: %Y-%m-%d %H:%M:%S.%N' > accuracy.log
+
+# 1. frame loss: every frame dropped or duplicated by the reference DUT must be seen by the Tester
+run "Imp-Loss 1000\nImp-Burst 5\nImp-Dup 500\nImp-Reorder 1000" ./build/siitperf-tp $fs $r $xpts $to $n $m
+for side in Forward Reverse; do
+	sent=$(grep "^$side frames sent" temp.out | awk '{print $4}')
+	received=$(grep "^$side frames received" temp.out | awk '{print $4}')
+	dut_received=$(grep "Reference DUT $side received" temp.out | sed 's/,//g' | awk '{print $6}')
+	dut_sent=$(grep "Reference DUT $side received" temp.out | sed 's/,//g' | awk '{print $NF}')
+	check "$side frames received by the DUT" $dut_received $sent 0
+	check "$side frame loss" $((sent-received)) $((dut_received-dut_sent)) 0
+done
+
+# 2. latency: TL and WCL must match the median and the 99.9th percentile of the applied delays
+run "Imp-Delay $imp_delay\nImp-Jitter $imp_jitter\nImp-Dist U" ./build/siitperf-lat $fs $r $xpts $to $n $m $delay $tags
+for side in Forward Reverse; do
+	check "$side TL" $(grep "$side TL" temp.out | awk '{print $3}') $(truth $side median:) $tol
+	check "$side WCL" $(grep "$side WCL" temp.out | awk '{print $3}') $(truth $side perc:) $tol
+done
+
+# 3. PDV: it must match the 99.9th percentile minus the minimum of the applied delays
+run "Imp-Delay $imp_delay\nImp-Jitter $imp_jitter\nImp-Dist N" ./build/siitperf-pdv $fs $r $xpts $to $n $m 0
+for side in Forward Reverse; do
+	expected=$(awk -v a=$(truth $side perc:) -v b=$(truth $side min:) 'BEGIN { print a-b }')
+	check "$side PDV" $(grep "$side PDV" temp.out | awk '{print $3}') $expected $tol
+done
+
+rm temp.out
+if [ $failed -ne 0 ]; then
+	echo "Accuracy benchmark FAILED, see accuracy.log for details."
+	exit 1
+fi
+echo "Accuracy benchmark passed."
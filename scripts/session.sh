@@ -0,0 +1,37 @@
+#!/bin/bash
+# Common part of the scripts driving a siitperf session (campaign.sh and back-to-back.sh), it is sourced by them.
+# It starts "./build/siitperf" as a coprocess, and waits for its initialization. The trials are sent to it by trial(),
+# and each of them ends with an "Info: Trial" line. The output is logged to $log, which must be set before sourcing.
+
+coproc SIITPERF { ./build/siitperf 2>&1; }
+
+# sends a trial to siitperf, and collects its output in temp.out until the end of the trial
+trial() {
+	echo "Trial: $*" | tee -a $log
+	echo "$*" >&${SIITPERF[1]}
+	> temp.out
+	while read -r line <&${SIITPERF[0]}; do
+		echo "$line" >> temp.out
+		case "$line" in
+			"Info: Trial "*) break ;;
+		esac
+	done
+	cat temp.out >> $log
+	if [ -n "$(grep 'Error:' temp.out)" ] || [ -z "$(grep 'Info: Trial finished' temp.out)" ]; then
+		echo "Error occurred, testing must stop."
+		exit -1
+	fi
+}
+
+# closes the session, and waits for the exit of siitperf
+endSession() {
+	exec {SIITPERF[1]}>&-
+	wait
+	rm -f temp.out
+}
+
+# wait for the initialization
+while read -r line <&${SIITPERF[0]}; do
+	echo "$line" >> $log
+	[ "$line" == "Info: Ready for trials." ] && break
+done
@@ -0,0 +1,378 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "defines.h"
+#include "includes.h"
+#include "throughput.h"
+#include "frame.h"
+#include "timeline.h"
+#include "live.h"
+#include "pacing.h"
+#include "instrument.h"
+#include "sender.h"
+
+// sets the destination addresses of the given flow
+// if there are more flows, then bits 16 to 23 of the IPv4 address (like in 198.18.x.2) and bits 56 to 63 of the IPv6 addresses
+// (like in 2001:2:0:00xx::1) are rewritten, otherwise the addresses are used as they are
+void flowAddresses(senderParameters *p, int flow, uint32_t *dst_ipv4, struct in6_addr *dst_ipv6, struct in6_addr *dst_bg) {
+  int rewrite = p->num_dest_nets > 1;
+  if ( p->ip_version == 4 ) {
+    *dst_ipv4 = *p->dst_ipv4;
+    if ( rewrite )
+      ((uint8_t *)dst_ipv4)[layout4.flow-layout4.dst_addr] = (uint8_t) flow;
+  } else { // IPv6
+    *dst_ipv6 = *p->dst_ipv6;
+    if ( rewrite )
+      ((uint8_t *)dst_ipv6)[layout6.flow-layout6.dst_addr] = (uint8_t) flow;
+  }
+  *dst_bg = *p->dst_bg;
+  if ( rewrite )
+    ((uint8_t *)dst_bg)[layout6.flow-layout6.dst_addr] = (uint8_t) flow;
+}
+
+// replaces a 16-bit word of a frame, and adjusts the IPv4 header and UDP checksums at the given offsets (0: there is no such checksum)
+// RFC 1624, eqn. 3 is used, as the ones' complement sum is byte order independent, the words are used as they are in the frame
+void patchWord(uint8_t *pkt, int offset, uint16_t new_word, int ip_chksum, int udp_chksum) {
+  uint16_t old_word = *(uint16_t *)(pkt+offset);
+  int chksum_offset[2] = { ip_chksum, udp_chksum };
+  int i;
+
+  *(uint16_t *)(pkt+offset) = new_word;
+  for ( i=0; i<2; i++ ) {
+    if ( !chksum_offset[i] )
+      continue;
+    uint32_t sum = (uint16_t) ~*(uint16_t *)(pkt+chksum_offset[i]) + (uint16_t) ~old_word + new_word;
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (~sum) & 0xffff;
+    if ( sum == 0 && i == 1 )	// UDP checksum should not be 0 (0 means, no checksum is used)
+      sum = 0xffff;
+    *(uint16_t *)(pkt+chksum_offset[i]) = (uint16_t) sum;
+  }
+}
+
+// rewrites the flow byte of the destination address of a frame made for flow 0 (see flowAddresses()), and adjusts its checksums
+void patchFlow(uint8_t *pkt, int ip_version, int flow) {
+  const frameLayout &l = layout(ip_version);
+  int offset = l.flow & ~1;	// the 16-bit word containing the flow byte
+  uint16_t word = *(uint16_t *)(pkt+offset);
+  ((uint8_t *)&word)[l.flow & 1] = (uint8_t) flow;
+  patchWord(pkt, offset, word, l.ip_chksum, l.udp_chksum);
+}
+
+// copies a frame into a new mbuf
+struct rte_mbuf *copyFrame(const uint8_t *frame, uint16_t length, rte_mempool *pkt_pool, const char *side) {
+  struct rte_mbuf *pkt_mbuf=rte_pktmbuf_alloc(pkt_pool); // message buffer for the frame
+  if ( !pkt_mbuf )
+    rte_exit(EXIT_FAILURE, "Error: %s sender can't allocate a new mbuf for the Test Frame! \n", side);
+  pkt_mbuf->pkt_len = pkt_mbuf->data_len = length; // set the length in both places
+  rte_memcpy(rte_pktmbuf_mtod(pkt_mbuf, uint8_t *), frame, length);
+  return pkt_mbuf;
+}
+
+// returns the number of size classes of the senders (1, if there is no frame size mix)
+static int numSizes(senderCommonParameters *cp) {
+  return cp->mix ? cp->mix->num_sizes : 1;
+}
+
+// returns the frame size of the given size class and IP version
+static uint16_t frameSize(senderCommonParameters *cp, int size, int ip_version) {
+  if ( !cp->mix )
+    return ip_version == 4 ? cp->ipv4_frame_size : cp->ipv6_frame_size;
+  return ip_version == 4 ? cp->mix->ipv6_size[size]-20 : cp->mix->ipv6_size[size];
+}
+
+// makes the templates of the frames of a sender: the frames of flow 0 of each size class are built by the builder functions, the frames
+// of the other flows are their copies with a rewritten destination address and incrementally adjusted checksums
+static frameTemplates *mkTemplates(senderParameters *p, frameBuilder4 mk4, frameBuilder6 mk6) {
+  senderCommonParameters *cp = p->cp;
+  uint32_t dst_ipv4;		// IPv4 destination address of flow 0
+  in6_addr dst_ipv6;		// foreground IPv6 destination address of flow 0
+  in6_addr dst_bg;		// background IPv6 destination address of flow 0
+  struct rte_mbuf *fg_master, *bg_master;	// the frames of flow 0
+  int i, s;			// cycle variables for the flows and the size classes
+
+  flowAddresses(p, 0, &dst_ipv4, &dst_ipv6, &dst_bg);
+  frameTemplates *t = new frameTemplates;
+  for ( s=0; s<numSizes(cp); s++ ) {
+    if ( p->ip_version == 4 )
+      fg_master = mk4(frameSize(cp, s, 4), p->pkt_pool, p->side, p->dst_mac, p->src_mac, p->src_ipv4, &dst_ipv4);
+    else  // IPv6
+      fg_master = mk6(frameSize(cp, s, 6), p->pkt_pool, p->side, p->dst_mac, p->src_mac, p->src_ipv6, &dst_ipv6);
+    bg_master = mk6(frameSize(cp, s, 6), p->pkt_pool, p->side, p->dst_mac, p->src_mac, p->src_bg, &dst_bg); // always IPv6
+
+    t->fg_len[s] = fg_master->data_len;
+    t->bg_len[s] = bg_master->data_len;
+    t->fg[s] = new uint8_t[p->num_dest_nets*t->fg_len[s]];
+    t->bg[s] = new uint8_t[p->num_dest_nets*t->bg_len[s]];
+    for ( i=0; i<p->num_dest_nets; i++ ) {
+      rte_memcpy(t->fg[s]+i*t->fg_len[s], rte_pktmbuf_mtod(fg_master, uint8_t *), t->fg_len[s]);
+      rte_memcpy(t->bg[s]+i*t->bg_len[s], rte_pktmbuf_mtod(bg_master, uint8_t *), t->bg_len[s]);
+      if ( i ) {
+        patchFlow(t->fg[s]+i*t->fg_len[s], p->ip_version, i);
+        patchFlow(t->bg[s]+i*t->bg_len[s], 6, i);
+      }
+    }
+    rte_pktmbuf_free(fg_master); // they have never been sent
+    rte_pktmbuf_free(bg_master);
+  }
+  return t;
+}
+
+// makes the arrival ring of a sender for a random arrival process: the inter-frame gaps are random with the mean of 1/frame_rate,
+// and they are scaled so that a cycle of the ring is exactly 2^ARRIVAL_RING_BITS/frame_rate long, thus the mean rate is exact
+// exponential gaps ('E'): Poisson arrivals
+// Markov on/off ('O'): during the on periods, the frames are sent at arrival_peak times the mean rate, an on period ends after
+// each frame with 1/arrival_burst probability, and the length of the off periods is exponential with such a mean that the mean
+// rate is kept
+static void mkArrivals(senderParameters *p) {
+  senderCommonParameters *cp = p->cp;
+  const int size = 1 << ARRIVAL_RING_BITS;	// size of the arrival ring
+  double mean_gap = 1.0/cp->frame_rate;		// mean inter-frame time in seconds
+  double peak_gap = mean_gap/cp->arrival_peak;	// inter-frame time of the on periods
+  double off_mean = cp->arrival_burst*(mean_gap-peak_gap);	// mean length of the off periods
+  std::mt19937_64 gen(std::random_device{}());
+  std::exponential_distribution<double> exp_gap(1.0/mean_gap), exp_off(1.0/off_mean);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  double *time = new double[size+1];	// unscaled arrival times, time[size] is the length of the cycle
+  uint64_t cycle_tsc = (cp->hz << ARRIVAL_RING_BITS)/cp->frame_rate;
+  uint64_t last = cp->frames_to_send-1;	// the last frame
+  int i;
+
+  time[0] = 0;
+  for ( i=0; i<size; i++ ) {
+    double gap;
+    if ( cp->arrival_dist == 'E' )
+      gap = exp_gap(gen);
+    else { // 'O'
+      gap = peak_gap;
+      if ( uni(gen) < 1.0/cp->arrival_burst )
+        gap += exp_off(gen);
+    }
+    time[i+1] = time[i]+gap;
+  }
+  p->arrivals = new uint64_t[size];
+  for ( i=0; i<size; i++ )
+    p->arrivals[i] = (uint64_t) (time[i]/time[size]*cycle_tsc);
+  delete [] time;
+  p->arrivals_end_tsc = (last >> ARRIVAL_RING_BITS)*cycle_tsc+p->arrivals[last & (size-1)];
+}
+
+// lcore function: creates the frames of all flows of a sender in p->frames (from templates, if available)
+// and its arrival ring, if a random arrival process is used
+int pregenerate(void *par) {
+  pregenParameters *g = (pregenParameters *)par;
+  senderParameters *p = g->p;
+  int copies = g->copies;
+  int i, j, s;			// cycle variables for the flows, the copies and the size classes
+
+  if ( !g->templates )
+    g->templates = mkTemplates(p, g->mk4, g->mk6);
+  frameTemplates *t = g->templates;
+  senderFrames *f = new senderFrames;
+  f->num_sizes = numSizes(p->cp);
+  f->num_flows = p->num_dest_nets; // num_dest_nets <= 256
+  f->copies = copies;
+  f->fg = new struct rte_mbuf *[f->num_sizes*f->num_flows*copies];
+  f->bg = new struct rte_mbuf *[f->num_sizes*f->num_flows*copies];
+  for ( s=0; s<f->num_sizes; s++ )
+    for ( i=0; i<f->num_flows; i++ )
+      for ( j=0; j<copies; j++ ) {
+        int index = (s*f->num_flows+i)*copies+j;
+        f->fg[index] = copyFrame(t->fg[s]+i*t->fg_len[s], t->fg_len[s], p->pkt_pool, p->side);
+        f->bg[index] = copyFrame(t->bg[s]+i*t->bg_len[s], t->bg_len[s], p->pkt_pool, p->side);
+      }
+  p->frames = f;
+  if ( p->cp->arrival_dist != 'P' && !p->cp->train_length && !p->cp->profile )
+    mkArrivals(p);
+  return 0;
+}
+
+// deletes the parameters of a sender (if any) together with its pre-generated frames (the mbufs are freed by the NIC after sending)
+void deleteSenderParameters(senderParameters *p) {
+  if ( !p )
+    return;
+  delete p->frames;
+  delete [] p->arrivals;
+  delete p;
+}
+
+static frameTemplates *template_cache[TEMPLATE_CACHE_SIZE];	// templates of the earlier trials of the session
+static int template_cache_next;				// the next one to be replaced
+
+// fills in the key of the templates of a sender
+static void mkTemplateKey(templateKey *key, senderParameters *p, frameBuilder4 mk4) {
+  memset(key, 0, sizeof(*key)); // also the padding, as the keys are compared by memcmp()
+  key->mk4 = mk4;
+  key->num_sizes = numSizes(p->cp);
+  for ( int s=0; s<key->num_sizes; s++ ) {
+    key->ipv4_frame_size[s] = frameSize(p->cp, s, 4);
+    key->ipv6_frame_size[s] = frameSize(p->cp, s, 6);
+  }
+  key->ip_version = p->ip_version;
+  key->num_flows = p->num_dest_nets;
+  key->dst_mac = *p->dst_mac;
+  key->src_mac = *p->src_mac;
+  if ( p->ip_version == 4 ) {
+    key->src_ipv4 = *p->src_ipv4;
+    key->dst_ipv4 = *p->dst_ipv4;
+  } else {
+    key->src_ipv6 = *p->src_ipv6;
+    key->dst_ipv6 = *p->dst_ipv6;
+  }
+  key->src_bg = *p->src_bg;
+  key->dst_bg = *p->dst_bg;
+}
+
+// pre-generates the frames of the active senders in parallel on their lcores
+// the templates are taken from the cache, if an earlier trial of the session used the same ones, otherwise the new ones are cached
+void pregenerateFrames(Throughput *t, senderParameters *left, senderParameters *right, int copies, frameBuilder4 mk4, frameBuilder6 mk6) {
+  senderParameters *p[2] = { left, right };
+  int cpu[2] = { t->cpu_left_sender, t->cpu_right_sender };
+  pregenParameters g[2];
+  templateKey key[2];
+  int cached[2];		// the templates were taken from the cache
+  int i, j;
+
+  for ( i=0; i<2; i++ ) {
+    if ( !p[i] )
+      continue; // the direction is not active
+    g[i].p = p[i];
+    g[i].copies = copies;
+    g[i].mk4 = mk4;
+    g[i].mk6 = mk6;
+    g[i].templates = 0;
+    mkTemplateKey(&key[i], p[i], mk4);
+    for ( j=0; j<TEMPLATE_CACHE_SIZE; j++ )
+      if ( template_cache[j] && !memcmp(&template_cache[j]->key, &key[i], sizeof(templateKey)) )
+        g[i].templates = template_cache[j];
+    cached[i] = g[i].templates != 0;
+    if ( i && p[0] && cpu[1] == cpu[0] )
+      rte_eal_wait_lcore(cpu[0]); // the senders share an lcore (core consolidation)
+    if ( rte_eal_remote_launch(pregenerate, &g[i], cpu[i]) )
+      rte_exit(EXIT_FAILURE, "Error: could not start the pre-generation of the frames of the %s sender.\n", p[i]->side);
+  }
+  for ( i=0; i<2; i++ ) {
+    if ( !p[i] )
+      continue;
+    rte_eal_wait_lcore(cpu[i]);
+    if ( cached[i] )
+      continue;
+    g[i].templates->key = key[i];
+    if ( template_cache[template_cache_next] ) {
+      for ( j=0; j<template_cache[template_cache_next]->key.num_sizes; j++ ) {
+        delete [] template_cache[template_cache_next]->fg[j];
+        delete [] template_cache[template_cache_next]->bg[j];
+      }
+      delete template_cache[template_cache_next];
+    }
+    template_cache[template_cache_next] = g[i].templates;
+    template_cache_next = (template_cache_next+1) % TEMPLATE_CACHE_SIZE;
+  }
+}
+
+// computes the shifts of the scheduled times of the frames of the sequence of the mix: the frame at position i is scheduled after
+// the wire time of the frames before it, the average wire time of a frame being the inter-frame time
+mixedSizes::mixedSizes(senderCommonParameters *cp) {
+  uint64_t cycle_bytes = 0;	// wire length of all frames of the sequence
+  uint64_t bytes = 0;		// wire length of the frames before position i
+  int i;
+
+  mix = cp->mix;
+  for ( i=0; i<mix->seq_len; i++ )
+    cycle_bytes += mix->ipv6_size[mix->seq[i]]+20;
+  for ( i=0; i<mix->seq_len; i++ ) {
+    shift_tsc[i] = (int64_t) ((double) bytes*mix->seq_len*cp->hz/cp->frame_rate/cycle_bytes) - (int64_t) (i*cp->hz/cp->frame_rate);
+    bytes += mix->ipv6_size[mix->seq[i]]+20;
+  }
+  pos = 0;
+  current = 0;
+}
+
+// waits until the last collected frame may be enqueued, and enqueues the collected frames
+void hwPacing::sendBurst(uint64_t *tx_retries) {
+  uint64_t last = deadline[queued-1];
+  uint64_t enqueue = last > start_tsc+ahead_tsc ? last-ahead_tsc : start_tsc; // the burst may be enqueued at this time
+  uint64_t now = rte_rdtsc();
+  int done = 0;	// the number of enqueued frames
+
+  if ( enqueue > now ) {
+    if ( enqueue-now > sleep_tsc ) {
+      struct timespec ts = { 0, (long) (1000000000.0*(enqueue-now-sleep_tsc/2)/hz) }; // the sleep may take longer
+      nanosleep(&ts, NULL);
+    }
+    while ( rte_rdtsc() < enqueue )
+      rte_pause();
+  }
+  INSTR( spin_cycles += rte_rdtsc()-now );
+  while ( done < queued ) {
+    now = rte_rdtsc();
+    int n = rte_eth_tx_burst(eth_id, 0, burst+done, queued-done);
+    if ( !n )
+      (*tx_retries)++;
+    for ( n += done; done < n; done++ ) {
+      lateness = now > deadline[done] ? now-deadline[done] : 0;
+      stats.record(lateness, frame_tsc);
+    }
+  }
+  queued = 0;
+}
+
+// waits until the NIC has sent all frames (at most for one second), and reports the average frame rate achieved by it
+// Beware: only the frame counter of the port is read, thus it is an average rate check, which cannot detect frames sent in bursts
+void hwPacing::finish(uint64_t sent_frames) {
+  struct rte_eth_stats port_stats;
+  uint64_t now, give_up = rte_rdtsc()+hz;
+
+  do {
+    rte_delay_us_block(10); // the statistics registers of the NIC are not read too often
+    rte_eth_stats_get(eth_id, &port_stats);
+    now = rte_rdtsc();
+  } while ( port_stats.opackets-opackets_start < sent_frames && now < give_up );
+  if ( port_stats.opackets-opackets_start < sent_frames )
+    printf("Warning: %s NIC sent only %lu frames of %lu in time.\n", side, port_stats.opackets-opackets_start, sent_frames);
+  else if ( sent_frames )
+    printf("Info: %s hardware pacing: average frame rate of the NIC: %.3lf fps, expected: %u fps (the spacing of the individual frames is not checked).\n",
+           side, (double) sent_frames*hz/(now-start_tsc), frame_rate);
+}
+
+// checks the sending time and the pacing, and reports the results of sending
+void finishSending(senderParameters *p, uint64_t sent_frames, const pacingStats *pacing, uint64_t tx_retries, uint64_t spin_cycles) {
+  senderCommonParameters *cp = p->cp;
+  const char *side = p->side;
+  uint64_t elapsed_tsc = rte_rdtsc()-cp->start_tsc;
+  double elapsed_seconds = (double)elapsed_tsc/cp->hz; // for checking the elapsed seconds during sending
+  double limit = cp->duration*TOLERANCE; // the last frame of a random arrival process may be scheduled a bit later
+  if ( p->arrivals )
+    limit = std::max(limit, ((double)p->arrivals_end_tsc/cp->hz+1.0/cp->frame_rate)*TOLERANCE);
+
+  INSTR( lcoreInstruments ins; )
+  INSTR( ins.tx_retries = tx_retries );
+  INSTR( ins.spin_cycles = spin_cycles );
+  INSTR( reportSenderInstruments(&ins, sent_frames, elapsed_tsc, cp->hz, cp->frame_rate, side) );
+  printf("Info: %s sender's sending took %3.10lf seconds.\n", side, elapsed_seconds);
+  if ( elapsed_seconds > limit )
+    rte_exit(EXIT_FAILURE, "%s sending exceeded the %3.10lf seconds limit, the test is invalid.\n", side, limit);
+  // and the pacing
+  reportPacing(pacing, cp->hz, side);
+  if ( cp->max_lateness_tsc && pacing->max_lateness > cp->max_lateness_tsc )
+    rte_exit(EXIT_FAILURE, "%s frame lateness exceeded the %lf microseconds limit, the test is invalid.\n", side, 1e6*cp->max_lateness_tsc/cp->hz);
+  printf("%s frames sent: %lu\n", side, sent_frames);
+}
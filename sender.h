@@ -0,0 +1,633 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SENDER_H_INCLUDED
+#define SENDER_H_INCLUDED
+
+// The generic sender: send(), sendLatency() and sendPdv() share a single sending cycle, which is a template parameterized by
+// five policy classes: flow selector, size selector, foreground/background scheduler, frame stamper and pacing strategy.
+// The right instantiation is chosen once, when the sender is launched, thus the sending cycle contains no dead branches and no modulo.
+// Beware: frame.h, pacing.h, timeline.h, live.h and instrument.h must be included before this file.
+
+// the pre-generated foreground and background frames of a sender: "copies" copies for each flow of each size class,
+// stored as [(size*num_flows+flow)*copies+copy]
+struct senderFrames {
+  uint16_t num_sizes;		// number of size classes (1, if there is no frame size mix)
+  uint16_t num_flows;		// number of flows (destination networks)
+  uint16_t copies;		// number of copies of each frame
+  struct rte_mbuf **fg, **bg;	// foreground and background frames
+  ~senderFrames() { delete [] fg; delete [] bg; } // the mbufs are freed by the NIC after sending
+};
+
+// functions creating a Test Frame of a given type (e.g. mkTestFrame4() and mkPdvFrame4())
+typedef struct rte_mbuf *(*frameBuilder4)(uint16_t length, rte_mempool *pkt_pool, const char *side,
+                                          const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
+                                          const uint32_t *src_ip, const uint32_t *dst_ip);
+typedef struct rte_mbuf *(*frameBuilder6)(uint16_t length, rte_mempool *pkt_pool, const char *side,
+                                          const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
+                                          const struct in6_addr *src_ip, const struct in6_addr *dst_ip);
+
+// the parameters, which determine the frames of a sender (used for finding them in the template cache)
+struct templateKey {
+  frameBuilder4 mk4;			// type of the frames
+  uint16_t num_sizes;			// number of size classes
+  uint16_t ipv4_frame_size[MAX_SIZE_CLASSES], ipv6_frame_size[MAX_SIZE_CLASSES];
+  int ip_version;			// foreground IP version
+  uint16_t num_flows;			// number of flows (destination networks)
+  struct ether_addr dst_mac, src_mac;
+  uint32_t src_ipv4, dst_ipv4;
+  struct in6_addr src_ipv6, dst_ipv6, src_bg, dst_bg;
+};
+
+// the templates of the frames of a sender: one foreground and one background frame per flow and size class,
+// kept between the trials of a session
+struct frameTemplates {
+  templateKey key;
+  uint16_t fg_len[MAX_SIZE_CLASSES], bg_len[MAX_SIZE_CLASSES];	// length of the frames of each size class (without the FCS)
+  uint8_t *fg[MAX_SIZE_CLASSES], *bg[MAX_SIZE_CLASSES];	// the frames of size class s and flow i start at fg[s]+i*fg_len[s] and bg[s]+i*bg_len[s]
+};
+
+// parameters of the pre-generation of the frames of a sender
+class pregenParameters {
+public:
+  senderParameters *p;		// the frames are made for this sender
+  int copies;			// number of copies of each frame
+  frameBuilder4 mk4;		// builders of the master frames
+  frameBuilder6 mk6;
+  frameTemplates *templates;	// cached templates, if NULL, then they are made and returned here
+};
+
+// sets the destination addresses of the given flow
+void flowAddresses(senderParameters *p, int flow, uint32_t *dst_ipv4, struct in6_addr *dst_ipv6, struct in6_addr *dst_bg);
+
+// rewrites the flow byte of the destination address of a frame made for flow 0 (see flowAddresses()), and adjusts its checksums
+void patchFlow(uint8_t *pkt, int ip_version, int flow);
+
+// replaces a 16-bit word of a frame, and adjusts the IPv4 header and UDP checksums at the given offsets (0: there is no such checksum)
+void patchWord(uint8_t *pkt, int offset, uint16_t new_word, int ip_chksum, int udp_chksum);
+
+// copies a frame into a new mbuf
+struct rte_mbuf *copyFrame(const uint8_t *frame, uint16_t length, rte_mempool *pkt_pool, const char *side);
+
+// lcore function: creates the frames of all flows of a sender in p->frames (from templates, if available)
+int pregenerate(void *par);
+
+// deletes the parameters of a sender (if any) together with its pre-generated frames
+void deleteSenderParameters(senderParameters *p);
+
+// pre-generates the frames of the active senders in parallel on their lcores
+void pregenerateFrames(Throughput *t, senderParameters *left, senderParameters *right, int copies, frameBuilder4 mk4, frameBuilder6 mk6);
+
+// checks and reports the results of sending
+void finishSending(senderParameters *p, uint64_t sent_frames, const pacingStats *pacing, uint64_t tx_retries, uint64_t spin_cycles);
+
+// Flow selectors: they give the index of the flow (destination network) of the next frame
+
+// always the same flow
+class singleFlow {
+public:
+  singleFlow(uint16_t num_flows) {}
+  inline int next() { return 0; }
+};
+
+// uniformly distributed random flows
+// random number infrastructure is taken from: https://en.cppreference.com/w/cpp/numeric/random/uniform_int_distribution
+// MT64 is used because of https://medium.com/@odarbelaeze/how-competitive-are-c-standard-random-number-generators-f3de98d973f0
+class randomFlow {
+  std::mt19937_64 gen;				// Standard 64-bit mersenne_twister_engine
+  std::uniform_int_distribution<int> uni_dis;	// uniform distribution in [0, num_flows-1]
+public:
+  randomFlow(uint16_t num_flows) : gen(std::random_device()()), uni_dis(0, num_flows-1) {}
+  inline int next() { return uni_dis(gen); }
+};
+
+// Size selectors: they give the size class of the next frame, and the shift of its scheduled time compared to evenly spaced frames
+
+// all frames have the same size
+class singleSize {
+public:
+  singleSize(senderCommonParameters *cp) {}
+  inline int next() { return 0; }
+  inline int64_t shift() { return 0; }
+};
+
+// frame size mix: the size classes follow the sequence of the mix, and the pacing is computed in bits: each frame is given a time slot
+// proportional to its length on the wire (the frame plus 20 bytes of preamble, SFD and inter-frame gap), thus the offered load is
+// correct, and the average frame rate is still frame_rate (the slots are computed using the IPv6 frame sizes of the classes)
+class mixedSizes {
+  const sizeMix *mix;
+  int pos;				// position in the sequence: sent_frames % mix->seq_len
+  int64_t current;			// shift of the current frame
+  int64_t shift_tsc[MAX_SIZE_SEQ];	// shift of the frames at each position of the sequence
+public:
+  mixedSizes(senderCommonParameters *cp);
+  inline int next() {
+    int size = mix->seq[pos];
+    current = shift_tsc[pos];
+    if ( ++pos == mix->seq_len )
+      pos = 0;
+    return size;
+  }
+  inline int64_t shift() { return current; }
+};
+
+// Foreground/background schedulers: they tell if the next frame is a foreground frame, that is, if ( sent_frames % n < m )
+
+// n=m: all foreground traffic
+class foregroundOnly {
+public:
+  foregroundOnly(uint32_t n, uint32_t m) {}
+  inline bool next() { return true; }
+};
+
+// m=0: all background traffic
+class backgroundOnly {
+public:
+  backgroundOnly(uint32_t n, uint32_t m) {}
+  inline bool next() { return false; }
+};
+
+// mixed traffic: sent_frames % n is maintained by a counter, which is reset to 0 when it reaches n
+class mixedTraffic {
+  uint32_t n, m;	// modulo and threshold
+  uint32_t pos;		// sent_frames % n
+public:
+  mixedTraffic(uint32_t n_, uint32_t m_) : n(n_), m(m_), pos(0) {}
+  inline bool next() {
+    bool fg = pos < m;
+    if ( ++pos == n )
+      pos = 0;
+    return fg;
+  }
+};
+
+// Frame stampers: stamp() may modify or replace the frame before it is sent, sent() is called after it was sent,
+// "copies" is the number of copies needed of each frame
+
+// Test Frames are sent as they are
+class noStamp {
+public:
+  static const int copies = 1;
+  inline struct rte_mbuf *stamp(uint64_t sent_frames, struct rte_mbuf *frame, bool fg, int flow) { return frame; }
+  inline void sent(uint64_t sent_frames) {}
+};
+
+// Latency Frames replace the Test Frames at "num_timestamps" evenly distributed positions after "delay" seconds,
+// and their sending time is recorded
+class latencyStamp {
+  struct rte_mbuf **latency_frames;	// pre-generated Latency Frames
+  uint64_t *send_ts;			// sending timestamps of the Latency Frames
+  uint16_t num_timestamps;		// number of Latency Frames
+  uint64_t start_latency_frame;		// the ordinal number of the very first Latency Frame
+  uint64_t frames_during_latency_test;	// number of frames sent, while Latency Frames are sent
+  int latency_timestamp_no;		// counter for the Latency Frames from 0 to num_timestamps-1
+  uint64_t send_next_latency_frame;	// at what frame count to send the next Latency Frame
+public:
+  static const int copies = 1;
+  latencyStamp(struct rte_mbuf **latency_frames_, uint64_t *send_ts_, uint16_t num_timestamps_, uint64_t start_latency_frame_,
+               uint64_t frames_during_latency_test_) {
+    latency_frames = latency_frames_;
+    send_ts = send_ts_;
+    num_timestamps = num_timestamps_;
+    start_latency_frame = send_next_latency_frame = start_latency_frame_;
+    frames_during_latency_test = frames_during_latency_test_;
+    latency_timestamp_no = 0;
+  }
+  inline struct rte_mbuf *stamp(uint64_t sent_frames, struct rte_mbuf *frame, bool fg, int flow) {
+    return unlikely( sent_frames == send_next_latency_frame ) ? latency_frames[latency_timestamp_no] : frame;
+  }
+  inline void sent(uint64_t sent_frames) {
+    if ( unlikely( sent_frames == send_next_latency_frame ) ) {
+      send_ts[latency_timestamp_no++]=rte_rdtsc();
+      send_next_latency_frame = start_latency_frame + latency_timestamp_no*frames_during_latency_test/num_timestamps;
+    }
+  }
+};
+
+// every PDV Frame carries its ordinal number, the UDP checksum is updated incrementally, and the sending time of each frame is recorded
+// (each frame exists in N copies to mitigate the problem of write after send)
+class pdvStamp {
+  uint64_t *snd_ts;				// sending timestamps of all frames
+  uint16_t fg_counter, fg_chksum;		// offsets of the counter and the UDP checksum in the foreground frames
+  uint16_t bg_counter, bg_chksum;		// offsets of the counter and the UDP checksum in the (IPv6) background frames
+  uint16_t fg_chksum_start[256], bg_chksum_start[256];	// uncomplemented checksums of the frames of each flow with counter 0
+public:
+  static const int copies = N;
+  pdvStamp(senderFrames *f, int ip_version, uint64_t *snd_ts_) {
+    snd_ts = snd_ts_;
+    fg_counter = layout(ip_version).id;
+    fg_chksum = layout(ip_version).udp_chksum;
+    bg_counter = layout6.id;
+    bg_chksum = layout6.udp_chksum;
+    for ( int i=0; i<f->num_flows; i++ ) {
+      fg_chksum_start[i] = ~*rte_pktmbuf_mtod_offset(f->fg[i*copies], uint16_t *, fg_chksum);
+      bg_chksum_start[i] = ~*rte_pktmbuf_mtod_offset(f->bg[i*copies], uint16_t *, bg_chksum);
+    }
+  }
+  inline struct rte_mbuf *stamp(uint64_t sent_frames, struct rte_mbuf *frame, bool fg, int flow) {
+    uint8_t *pkt = rte_pktmbuf_mtod(frame, uint8_t *);
+    uint32_t chksum; // temporary variable for checksum calculation
+    *(uint64_t *)(pkt + (fg ? fg_counter : bg_counter)) = sent_frames;	// set the counter in the frame
+    chksum = (fg ? fg_chksum_start[flow] : bg_chksum_start[flow]) + rte_raw_cksum(&sent_frames,8); // add the checksum of the counter to the initial checksum value
+    chksum = ((chksum & 0xffff0000) >> 16) + (chksum & 0xffff);	// calculate 16-bit one's complement sum
+    chksum = (~chksum) & 0xffff;					// make one's complement
+    if (chksum == 0)							// checksum should not be 0 (0 means, no checksum is used)
+      chksum = 0xffff;
+    *(uint16_t *)(pkt + (fg ? fg_chksum : bg_chksum)) = (uint16_t) chksum;	// set checksum in the frame
+    return frame;
+  }
+  inline void sent(uint64_t sent_frames) { snd_ts[sent_frames] = rte_rdtsc(); }
+};
+
+// an entry of the send timestamp ring of the soak test: counter is the ID of the frame, the timestamp of which is stored in ts
+struct soakEntry {
+  volatile uint64_t counter;
+  volatile uint64_t ts;
+};
+
+// soak test: the frames are stamped as above, but the send timestamps are stored in a ring of fixed size, where the receiver looks
+// them up; the counter of the entry is invalidated while its timestamp is overwritten, thus the receiver can check its consistency
+class soakStamp : public pdvStamp {
+  soakEntry *ring;		// ring_mask+1 entries
+  uint64_t ring_mask;
+public:
+  soakStamp(senderFrames *f, int ip_version, soakEntry *ring_, uint64_t ring_size) : pdvStamp(f, ip_version, NULL) {
+    ring = ring_;
+    ring_mask = ring_size-1;
+  }
+  inline void sent(uint64_t sent_frames) {
+    uint64_t timestamp = rte_rdtsc();
+    soakEntry *e = &ring[sent_frames & ring_mask];
+    e->counter = ~0ULL;
+    rte_smp_wmb();
+    e->ts = timestamp;
+    rte_smp_wmb();
+    e->counter = sent_frames;
+  }
+};
+
+// the frames are numbered as above, but their send timestamps are not needed (system recovery test)
+class seqStamp : public pdvStamp {
+public:
+  seqStamp(senderFrames *f, int ip_version) : pdvStamp(f, ip_version, NULL) {}
+  inline void sent(uint64_t sent_frames) {}
+};
+
+// Pacing strategies: wait() returns, when the next frame may be sent (its scheduled time is shifted by the size selector),
+// then enqueue() sends it; flush() sends the frames still held by the pacer at the end of the sending cycle
+
+// the common part of the pacing strategies: the lateness statistics, and the frames are enqueued one by one
+class pacerBase {
+protected:
+  uint8_t eth_id;	// the port of the sender
+public:
+  pacingStats stats;	// lateness statistics
+  uint64_t lateness;	// lateness of the last frame
+  uint64_t spin_cycles;	// TSC cycles spent waiting (counted only with data-plane instrumentation)
+  pacerBase(senderParameters *p) : eth_id(p->eth_id), lateness(0), spin_cycles(0) {}
+  inline void enqueue(struct rte_mbuf *frame, uint64_t *tx_retries) {
+    while ( !rte_eth_tx_burst(eth_id, 0, &frame, 1) ) (*tx_retries)++; // Beware: an "empty" loop, too!
+  }
+  inline void flush(uint64_t *tx_retries) {}
+  inline void finish(uint64_t sent_frames) {}
+};
+
+// the frames are sent at their scheduled TSC values, and their lateness is recorded
+// the scheduled time is computed from the beginning of the current second of sending, because sent_frames*hz would overflow
+// after about 400 seconds at 14.88Mfps, which is much shorter than a soak test
+class tscPacing : public pacerBase {
+  uint64_t second_tsc;	// beginning of the current second of sending
+  uint32_t frame_in_second;	// index of the current frame within the current second
+  uint64_t hz;		// number of clock cycles per second
+  uint32_t frame_rate;	// number of frames per second
+  uint64_t frame_tsc;	// inter-frame time: a frame is a catch-up frame, if it is started later than its scheduled time plus this value
+public:
+  tscPacing(senderParameters *p) : pacerBase(p) {
+    senderCommonParameters *cp = p->cp;
+    second_tsc = cp->start_tsc;
+    frame_in_second = 0;
+    hz = cp->hz;
+    frame_rate = cp->frame_rate;
+    frame_tsc = hz/frame_rate;
+  }
+  inline void wait(uint64_t sent_frames, int64_t shift) {
+    uint64_t deadline = second_tsc+frame_in_second*hz/frame_rate+shift;	// scheduled time of starting the sending of the current frame
+    uint64_t now = rte_rdtsc();
+    lateness = now > deadline ? now-deadline : 0;
+    stats.record(lateness, frame_tsc); // if the frame is not late, it is started at its deadline
+    while ( rte_rdtsc() < deadline ); // Beware: an "empty" loop!
+    INSTR( spin_cycles += rte_rdtsc()-now );
+    if ( unlikely( ++frame_in_second == frame_rate ) ) {
+      frame_in_second = 0;
+      second_tsc += hz;
+    }
+  }
+};
+
+// the TX queue is rate limited by the NIC, which spaces the frames: they are collected and enqueued in bursts of HW_PACING_BURST
+// frames, when the last frame of the burst is HW_PACING_AHEAD frames ahead of its scheduled time (but not before start_tsc), and
+// the sender sleeps, if it is far ahead; the lateness of enqueueing is recorded, as a late frame means that the TX queue ran empty
+class hwPacing : public pacerBase {
+  uint64_t start_tsc;	// sending of the test frames will begin at this time
+  uint64_t second_tsc;	// beginning of the current second of sending (see tscPacing)
+  uint32_t frame_in_second;	// index of the current frame within the current second
+  uint64_t hz;		// number of clock cycles per second
+  uint32_t frame_rate;	// number of frames per second
+  uint64_t frame_tsc;	// inter-frame time
+  uint64_t ahead_tsc;	// the frames are enqueued so much earlier than their scheduled time
+  uint64_t sleep_tsc;	// the sender sleeps instead of spinning, if it has to wait longer than this
+  const char *side;	// "Forward" or "Reverse"
+  uint64_t opackets_start; // the number of frames sent by the port before the test
+  struct rte_mbuf *burst[HW_PACING_BURST];	// the frames collected for the next burst
+  uint64_t deadline[HW_PACING_BURST];	// and their scheduled times
+  int queued;		// the number of the collected frames
+  void sendBurst(uint64_t *tx_retries);
+public:
+  hwPacing(senderParameters *p) : pacerBase(p) {
+    senderCommonParameters *cp = p->cp;
+    struct rte_eth_stats port_stats;
+    start_tsc = second_tsc = cp->start_tsc;
+    frame_in_second = 0;
+    hz = cp->hz;
+    frame_rate = cp->frame_rate;
+    frame_tsc = hz/frame_rate;
+    ahead_tsc = HW_PACING_AHEAD*hz/frame_rate;
+    sleep_tsc = hz*HW_PACING_SLEEP/1000000;
+    side = p->side;
+    rte_eth_stats_get(eth_id, &port_stats);
+    opackets_start = port_stats.opackets;
+    queued = 0;
+  }
+  inline void wait(uint64_t sent_frames, int64_t shift) {
+    deadline[queued] = second_tsc+frame_in_second*hz/frame_rate+shift;	// scheduled time of sending the current frame
+    if ( unlikely( ++frame_in_second == frame_rate ) ) {
+      frame_in_second = 0;
+      second_tsc += hz;
+    }
+  }
+  inline void enqueue(struct rte_mbuf *frame, uint64_t *tx_retries) {
+    burst[queued++] = frame;
+    if ( queued == HW_PACING_BURST )
+      sendBurst(tx_retries);
+  }
+  inline void flush(uint64_t *tx_retries) {
+    if ( queued )
+      sendBurst(tx_retries);
+  }
+  void finish(uint64_t sent_frames);
+};
+
+// back-to-back test: a train of train_length frames is sent at the frame rate at the beginning of every second, the rest of the second
+// is idle, thus the DUT may recover; the lateness is recorded as above (the timeline snapshots of the idle part of the second are
+// published by the sending cycle after the wait for the next train, with the TSC values of the end of their intervals)
+class trainPacing : public pacerBase {
+  uint64_t hz;		// number of clock cycles per second
+  uint32_t frame_rate;	// number of frames per second within a train
+  uint64_t frame_tsc;	// inter-frame time within a train
+  uint32_t train_length;	// number of frames of a train
+  uint32_t pos;		// position of the current frame in its train
+  uint64_t train_start;	// the current train starts at this time
+public:
+  trainPacing(senderParameters *p) : pacerBase(p) {
+    senderCommonParameters *cp = p->cp;
+    hz = cp->hz;
+    frame_rate = cp->frame_rate;
+    frame_tsc = hz/frame_rate;
+    train_length = cp->train_length;
+    pos = 0;
+    train_start = cp->start_tsc;
+  }
+  inline void wait(uint64_t sent_frames, int64_t shift) {
+    uint64_t deadline = train_start+pos*hz/frame_rate+shift;	// scheduled time of starting the sending of the current frame
+    uint64_t now = rte_rdtsc();
+    lateness = now > deadline ? now-deadline : 0;
+    stats.record(lateness, frame_tsc);
+    while ( rte_rdtsc() < deadline ); // Beware: an "empty" loop!
+    INSTR( spin_cycles += rte_rdtsc()-now );
+    if ( ++pos == train_length ) {
+      pos = 0;
+      train_start += hz;
+    }
+  }
+};
+
+// rate profile: the frame rate changes step by step (a ramp consists of many steps), the frames of a step are sent periodically
+// from its beginning; the current step is changed, when its last frame was sent (the size selector does not shift the frames)
+class profilePacing : public pacerBase {
+  uint64_t start_tsc;	// sending of the test frames will begin at this time
+  uint64_t hz;		// number of clock cycles per second
+  const profileStep *step;	// the current step
+  uint64_t second_tsc;	// beginning of the current second of the current step (a constant rate step may be long, see tscPacing)
+  uint32_t frame_in_second;	// index of the current frame within the current second of the step
+  uint64_t frame_tsc;	// inter-frame time of the current step
+  inline void next(uint64_t sent_frames) {
+    while ( sent_frames >= step[1].first_frame ) // the steps without frames are skipped, the last one is followed by a sentinel
+      step++;
+    second_tsc = start_tsc+(uint64_t)step->start_ms*hz/1000;
+    frame_in_second = 0;
+    frame_tsc = hz/step->rate;
+  }
+public:
+  profilePacing(senderParameters *p) : pacerBase(p) {
+    senderCommonParameters *cp = p->cp;
+    start_tsc = cp->start_tsc;
+    hz = cp->hz;
+    step = cp->profile->steps;
+    next(0);
+  }
+  inline void wait(uint64_t sent_frames, int64_t shift) {
+    if ( unlikely( sent_frames >= step[1].first_frame ) )
+      next(sent_frames);
+    uint64_t deadline = second_tsc+frame_in_second*hz/step->rate;	// scheduled time of starting the sending of the current frame
+    uint64_t now = rte_rdtsc();
+    lateness = now > deadline ? now-deadline : 0;
+    stats.record(lateness, frame_tsc);
+    while ( rte_rdtsc() < deadline ); // Beware: an "empty" loop!
+    INSTR( spin_cycles += rte_rdtsc()-now );
+    if ( unlikely( ++frame_in_second == step->rate ) ) {
+      frame_in_second = 0;
+      second_tsc += hz;
+    }
+  }
+};
+
+// random arrival process: the scheduled times of the frames are looked up in the arrival ring, which contains them relative to the
+// start of its cycle (the cycles are 2^ARRIVAL_RING_BITS frames long, and their length corresponds exactly to the mean frame rate)
+class randomPacing : public pacerBase {
+  uint64_t start_tsc;	// sending of the test frames will begin at this time
+  uint64_t frame_tsc;	// mean inter-frame time
+  uint64_t cycle_tsc;	// length of a cycle of the arrival ring
+  const uint64_t *arrivals;	// the arrival ring
+public:
+  randomPacing(senderParameters *p) : pacerBase(p) {
+    senderCommonParameters *cp = p->cp;
+    start_tsc = cp->start_tsc;
+    frame_tsc = cp->hz/cp->frame_rate;
+    cycle_tsc = (cp->hz << ARRIVAL_RING_BITS)/cp->frame_rate;
+    arrivals = p->arrivals;
+  }
+  inline void wait(uint64_t sent_frames, int64_t shift) {
+    uint64_t deadline = start_tsc+(sent_frames >> ARRIVAL_RING_BITS)*cycle_tsc+arrivals[sent_frames & ((1 << ARRIVAL_RING_BITS)-1)]+shift;
+    uint64_t now = rte_rdtsc();
+    lateness = now > deadline ? now-deadline : 0;
+    stats.record(lateness, frame_tsc);
+    while ( rte_rdtsc() < deadline ); // Beware: an "empty" loop!
+    INSTR( spin_cycles += rte_rdtsc()-now );
+  }
+};
+
+// the sending cycle of a sender: the state is kept between the frames, thus the frames of more senders may be interleaved by the
+// run-to-completion loop of a consolidated lcore (see sendReceive()); sendFrame() sends the next frame, finish() reports the results
+template <class FlowSelector, class SizeSelector, class Scheduler, class Stamper, class Pacer>
+class sendingCycle {
+  senderParameters *p;
+  senderFrames *f;		// pre-generated frames
+  Stamper *stamper;
+  uint64_t frames_to_send;	// Each active sender sends this number of frames
+  uint64_t tx_retries;		// number of unsuccessful rte_eth_tx_burst() calls
+  int copy;			// the copy of the frames to be sent (if there are more copies)
+  FlowSelector flows;
+  SizeSelector sizes;
+  Scheduler scheduler;
+  timelineRing *timeline;	// a snapshot is published at the end of every interval, as the receiver does
+  uint64_t timeline_tsc;	// length of the timeline intervals
+  uint64_t next_snapshot;	// end of the current timeline interval (never, if no timeline)
+  liveCounters *live;		// published after every 256 frames
+public:
+  Pacer pacer;
+  uint64_t sent_frames;		// counts the number of sent frames
+
+  // dummy_counters: the live counters are published here, if there is no live page
+  sendingCycle(senderParameters *p_, senderFrames *f_, Stamper *stamper_, liveCounters *dummy_counters) :
+    p(p_), f(f_), stamper(stamper_), flows(f_->num_flows), sizes(p_->cp), scheduler(p_->cp->n, p_->cp->m), pacer(p_) {
+    senderCommonParameters *cp = p->cp;
+    frames_to_send = cp->frames_to_send;
+    tx_retries = 0;
+    copy = 0;
+    timeline = p->timeline;
+    timeline_tsc = cp->timeline_tsc;
+    next_snapshot = timeline ? cp->start_tsc+timeline_tsc : ~0ULL;
+    live = p->live ? p->live : dummy_counters;
+    sent_frames = 0;
+  }
+
+  inline bool finished() { return sent_frames >= frames_to_send; }
+
+  // publishes the snapshots of the intervals ended before "now" (the snapshots are paired with those of the receiver by their index)
+  inline void publishSnapshots(uint64_t now) {
+    while ( unlikely( now >= next_snapshot ) ) {
+      timeline->publish(next_snapshot, sent_frames);
+      next_snapshot += timeline_tsc;
+    }
+  }
+
+  inline void sendFrame() {
+    int flow = flows.next();
+    int size = sizes.next();
+    int index = Stamper::copies == 1 ? size*f->num_flows+flow : (size*f->num_flows+flow)*Stamper::copies+copy; // index of the pre-generated frame
+    bool fg = scheduler.next();
+    struct rte_mbuf *frame = stamper->stamp(sent_frames, fg ? f->fg[index] : f->bg[index], fg, flow);
+    pacer.wait(sent_frames, sizes.shift());
+    if ( timeline )
+      publishSnapshots(rte_rdtsc()); // a frame is counted in the interval, in which it is sent
+    pacer.enqueue(frame, &tx_retries);
+    stamper->sent(sent_frames);
+    if ( Stamper::copies > 1 && ++copy == Stamper::copies )
+      copy = 0;
+    if ( unlikely( (sent_frames & LIVE_UPDATE_MASK) == 0 ) ) {
+      live->sent = sent_frames+1;
+      live->tx_retries = tx_retries;
+      live->late_frames = pacer.stats.late_frames;
+      live->tx_lag = pacer.lateness;
+    }
+    sent_frames++;
+  }
+
+  void finish() {
+    pacer.flush(&tx_retries);
+    if ( timeline ) {
+      uint64_t now = rte_rdtsc();
+      publishSnapshots(now);
+      timeline->publish(now, sent_frames); // final snapshot for the last (partial) interval
+    }
+    live->sent = sent_frames;
+    live->tx_retries = tx_retries;
+    live->late_frames = pacer.stats.late_frames;
+    pacer.finish(sent_frames);
+    finishSending(p, sent_frames, &pacer.stats, tx_retries, pacer.spin_cycles);
+  }
+};
+
+// the sending cycle of all senders
+template <class FlowSelector, class SizeSelector, class Scheduler, class Stamper, class Pacer>
+void sendCycle(senderParameters *p, senderFrames *f, Stamper *stamper) {
+  liveCounters dummy_counters;
+  sendingCycle<FlowSelector, SizeSelector, Scheduler, Stamper, Pacer> cycle(p, f, stamper, &dummy_counters);
+
+  while ( !cycle.finished() ) // Main cycle for the number of frames to send
+    cycle.sendFrame();
+  cycle.finish();
+}
+
+// chooses the pacing strategy on the basis of the trains, the rate profile, the arrival process and the rate limit of the TX queue
+template <class FlowSelector, class SizeSelector, class Scheduler, class Stamper>
+void sendPaced(senderParameters *p, senderFrames *f, Stamper *stamper) {
+  if ( p->cp->train_length )
+    sendCycle<FlowSelector, SizeSelector, Scheduler, Stamper, trainPacing>(p, f, stamper);
+  else if ( p->cp->profile )
+    sendCycle<FlowSelector, SizeSelector, Scheduler, Stamper, profilePacing>(p, f, stamper);
+  else if ( p->arrivals )
+    sendCycle<FlowSelector, SizeSelector, Scheduler, Stamper, randomPacing>(p, f, stamper);
+  else if ( p->hw_pacing )
+    sendCycle<FlowSelector, SizeSelector, Scheduler, Stamper, hwPacing>(p, f, stamper);
+  else
+    sendCycle<FlowSelector, SizeSelector, Scheduler, Stamper, tscPacing>(p, f, stamper);
+}
+
+// chooses the scheduler on the basis of n and m
+template <class FlowSelector, class SizeSelector, class Stamper>
+void sendScheduled(senderParameters *p, senderFrames *f, Stamper *stamper) {
+  if ( p->cp->m >= p->cp->n )
+    sendPaced<FlowSelector, SizeSelector, foregroundOnly, Stamper>(p, f, stamper);
+  else if ( p->cp->m == 0 )
+    sendPaced<FlowSelector, SizeSelector, backgroundOnly, Stamper>(p, f, stamper);
+  else
+    sendPaced<FlowSelector, SizeSelector, mixedTraffic, Stamper>(p, f, stamper);
+}
+
+// chooses the size selector on the basis of the frame size mix
+template <class FlowSelector, class Stamper>
+void sendSized(senderParameters *p, senderFrames *f, Stamper *stamper) {
+  if ( f->num_sizes == 1 )
+    sendScheduled<FlowSelector, singleSize>(p, f, stamper);
+  else
+    sendScheduled<FlowSelector, mixedSizes>(p, f, stamper);
+}
+
+// chooses the flow selector on the basis of the number of flows, and sends all frames
+template <class Stamper>
+void sendFrames(senderParameters *p, senderFrames *f, Stamper *stamper) {
+  if ( f->num_flows == 1 )
+    sendSized<singleFlow>(p, f, stamper);
+  else
+    sendSized<randomFlow>(p, f, stamper);
+}
+
+#endif
@@ -0,0 +1,104 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// siitperf-top: a lightweight monitor, which maps the live counters page of a running Tester read-only,
+// and displays the rates and counters of its senders and receivers periodically
+// usage: siitperf-top [<live page name> [<refresh interval in ms>]]
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "live.h"
+
+#define DEFAULT_LIVE_PAGE "/siitperf"	/* used, if no name is given on the command line */
+#define DEFAULT_REFRESH 1000		/* refresh interval in milliseconds */
+
+const char *roleName[LIVE_ROLES] = { "Left Sender", "Right Receiver", "Right Sender", "Left Receiver" };
+
+// returns the current time in seconds
+double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+int main(int argc, const char *argv[]) {
+  const char *name = argc > 1 ? argv[1] : DEFAULT_LIVE_PAGE;
+  int refresh = argc > 2 ? atoi(argv[2]) : DEFAULT_REFRESH;
+  int fd;				// file descriptor of the shared memory segment
+  const livePage *live;			// the mapped page
+  uint64_t prev_frames[LIVE_ROLES];	// frame counters at the previous refresh
+  uint64_t prev_trial;			// trial number at the previous refresh
+  double prev_time, curr_time;		// time of the previous and the current refresh
+  int i;				// cycle variable
+
+  if ( refresh <= 0 ) {
+    fprintf(stderr, "Input Error: Refresh interval must be a positive number of milliseconds.\n");
+    return -1;
+  }
+  fd = shm_open(name, O_RDONLY, 0);
+  if ( fd < 0 ) {
+    fprintf(stderr, "Error: Cannot open live page '%s', is the Tester running with 'Live-Page %s'?\n", name, name);
+    return -1;
+  }
+  void *page = mmap(0, sizeof(livePage), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if ( page == MAP_FAILED ) {
+    fprintf(stderr, "Error: Cannot map live page '%s'.\n", name);
+    return -1;
+  }
+  live = reinterpret_cast<const livePage *>(page);
+  if ( live->magic != LIVE_MAGIC ) {
+    fprintf(stderr, "Error: '%s' is not a siitperf live page.\n", name);
+    return -1;
+  }
+
+  prev_trial = live->trial;
+  for ( i=0; i<LIVE_ROLES; i++ )
+    prev_frames[i] = live->role[i].sent + live->role[i].received;
+  prev_time = now();
+  while ( 1 ) {
+    usleep(1000*refresh);
+    curr_time = now();
+    if ( live->trial != prev_trial ) {
+      // a new test was started: counters were cleared
+      prev_trial = live->trial;
+      for ( i=0; i<LIVE_ROLES; i++ )
+        prev_frames[i] = 0;
+    }
+    printf("\n%s: trial %lu, %u fps for %u s\n", name, live->trial, live->frame_rate, live->duration);
+    printf("%-15s %12s %14s %14s %12s %12s %12s\n", "Role", "Rate (fps)", "Sent", "Received", "TX retries", "Late", "TX lag (us)");
+    for ( i=0; i<LIVE_ROLES; i++ ) {
+      if ( !(live->active & (1<<i)) )
+        continue;
+      const liveCounters *c = &live->role[i];
+      uint64_t frames = c->sent + c->received;	// only one of them is used by a given role
+      printf("%-15s %12.0lf %14lu %14lu %12lu %12lu %12.3lf\n", roleName[i], (frames-prev_frames[i])/(curr_time-prev_time),
+             c->sent, c->received, c->tx_retries, c->late_frames, live->hz ? 1e6*c->tx_lag/live->hz : 0.0);
+      prev_frames[i] = frames;
+    }
+    fflush(stdout);
+    prev_time = curr_time;
+  }
+}
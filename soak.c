@@ -0,0 +1,362 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "defines.h"
+#include "includes.h"
+#include "throughput.h"
+#include "pdv.h"
+#include "frame.h"
+#include "timeline.h"
+#include "live.h"
+#include "pacing.h"
+#include "instrument.h"
+#include "sender.h"
+#include "soak.h"
+
+// the understanding of this code requires the knowledge of throughput.c and pdv.c
+// only a few functions are redefined or added here
+
+// after reading the parameters for throughput measurement, further one parameter is read
+int Soak::readCmdLine(int argc, const char *argv[]) {
+  if ( Throughput::readCmdLine(argc-1,argv) < 0 )
+    return -1;
+  if ( sscanf(argv[7], "%u", &interval) != 1 || interval < 1 || interval > duration ) {
+    std::cerr << "Input Error: Summary interval must be between 1 and the duration." << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+int Soak::senderPoolSize(int num_dest_nets) {
+  return Throughput::senderPoolSize(num_dest_nets)*soakStamp::copies; // the PDV Frames of each flow are pre-generated in so many copies
+}
+
+// the ring holds the send timestamps of the frames of the global timeout, but at least SOAK_RING_MIN and at most SOAK_RING_MAX ones
+uint64_t Soak::ringSize() {
+  uint64_t frames = (uint64_t) frame_rate*global_timeout/1000, size;
+  for ( size=SOAK_RING_MIN; size < frames && size < SOAK_RING_MAX; size *= 2 );
+  return size;
+}
+
+uint64_t Soak::timestampMemory() {
+  return (uint64_t) (forward+reverse)*ringSize()*sizeof(soakEntry);
+}
+
+// sends Test Frames for soak tests
+int sendSoak(void *par) {
+  // collecting input parameters:
+  class senderParametersSoak *p = (class senderParametersSoak *)par;
+
+  // fg. and bg. PDV Frames for each flow in N copies were pre-generated, they are updated regarding counter and UDP checksum before sending
+  soakStamp stamper(p->frames, p->ip_version, p->ring, p->ring_size);
+
+  sendFrames(p, p->frames, &stamper);
+  return 0;
+}
+
+void soakStats::add(soakStats *s) {
+  received += s->received;
+  untimed += s->untimed;
+  if ( s->max_delay > max_delay )
+    max_delay = s->max_delay;
+  for ( int i=0; i<SOAK_HIST_SIZE; i++ )
+    histogram[i] += s->histogram[i];
+  s->received = s->untimed = s->max_delay = 0;
+  memset(s->histogram, 0, sizeof(s->histogram));
+}
+
+// reports the frame loss and the distribution of the delays (in milliseconds) as the impairment stage of the reference DUT does,
+// but the maximum is exact
+void soakStats::report(const char *side, const char *name, uint64_t sent, uint64_t hz) {
+  uint64_t total=received-untimed, cumulated=0;
+  double min=-1, median=-1, perc99_9=-1;
+  int i;
+
+  for ( i=0; i<SOAK_HIST_SIZE && perc99_9 < 0; i++ ) {
+    if ( !histogram[i] )
+      continue;
+    cumulated += histogram[i];
+    if ( min < 0 )
+      min = i/1000.0;
+    if ( median < 0 && cumulated >= (total+1)/2 )
+      median = i/1000.0;
+    if ( perc99_9 < 0 && cumulated >= ceil(0.999*total) )
+      perc99_9 = i/1000.0;
+  }
+  printf("Info: %s soak %s: frames sent: %lu, received: %lu, lost: %lu (%.6lf%%)", side, name, sent, received,
+         sent-received, sent ? 100.0*(sent-received)/sent : 0.0);
+  if ( total )
+    printf(", delay (ms): min: %.3lf, median: %.3lf, 99.9th perc: %.3lf, max: %.3lf", min, median, perc99_9, 1000.0*max_delay/hz);
+  if ( untimed )
+    printf(", without timestamp: %lu", untimed);
+  printf("\n");
+}
+
+// reports the statistics of interval k, and adds them to the total
+static void closeInterval(receiverParametersSoak *p, uint64_t k, uint64_t num_intervals, soakStats *s, soakStats *total, uint64_t hz) {
+  uint64_t interval_frames = (uint64_t) p->interval*p->frame_rate;
+  uint64_t sent = k+1 < num_intervals ? interval_frames : p->frames_to_send-k*interval_frames; // the last one may be shorter
+  char name[64];
+
+  snprintf(name, sizeof(name), "interval %lu (%lu-%lu s)", k, k*p->interval, k*p->interval+sent/p->frame_rate);
+  s->report(p->side, name, sent, hz);
+  total->add(s);
+}
+
+// the offsets of the fields are taken from the frame layouts (see frame.h)
+// a frame belongs to the interval, in which it was sent (it is given by its counter); the interval is closed global_timeout
+// milliseconds after its end: its statistics are printed and added to the total, and its slot is reused for a later interval
+int receiveSoak(void *par) {
+  // collecting input parameters:
+  class receiverParametersSoak *p = (class receiverParametersSoak *)par;
+  uint64_t finish_receiving = p->finish_receiving;
+  uint8_t eth_id = p->eth_id;
+  const char *side = p->side;
+  uint64_t frames_to_send = p->frames_to_send;
+  soakEntry *ring = p->ring;
+  uint64_t ring_mask = p->ring_size-1;
+
+  // further local variables
+  int frames, i;
+  struct rte_mbuf *pkt_mbufs[MAX_PKT_BURST]; // pointers for the mbufs of received frames
+  INSTR( lcoreInstruments ins; ) // data-plane instrumentation (if compiled in)
+  uint16_t ipv4=htons(0x0800); // EtherType for IPv4 in Network Byte Order
+  uint16_t ipv6=htons(0x86DD); // EtherType for IPv6 in Network Byte Order
+  uint8_t identify[8]= { 'I', 'D', 'E', 'N', 'T', 'I', 'F', 'Y' };      // Identificion of the Test Frames
+  uint64_t *id=(uint64_t *) identify;
+  uint64_t all_frames=0; // number of all frames received, the ones not matching the test signature are counted as foreign traffic
+  uint64_t received=0;  // number of received frames
+  uint64_t late=0;	// number of frames received after their interval was closed
+  uint64_t hz = rte_get_tsc_hz();
+  uint64_t tsc_per_us = hz/1000000;	// for the histograms
+  uint64_t interval_frames = (uint64_t) p->interval*p->frame_rate;	// number of frames sent in an interval (except the last one)
+  uint64_t num_intervals = (frames_to_send+interval_frames-1)/interval_frames;
+  uint64_t interval_tsc = hz*p->interval;
+  int num_slots = p->global_timeout/(1000*p->interval)+2;	// the frames of so many intervals may arrive at the same time
+  uint64_t first=0;	// the oldest interval, which is not yet closed
+  uint64_t close_tsc = p->start_tsc+interval_tsc+hz*p->global_timeout/1000; // the oldest interval is closed at this time
+  uint64_t now;
+
+  soakStats *slot = new soakStats[num_slots];	// the statistics of the interval k are collected in slot[k % num_slots]
+  soakStats *total = new soakStats;
+
+  while ( (now = rte_rdtsc()) < finish_receiving ){
+    if ( unlikely( now >= close_tsc && first < num_intervals ) ) {
+      closeInterval(p, first, num_intervals, &slot[first % num_slots], total, hz);
+      first++;
+      close_tsc += interval_tsc;
+    }
+    INSTR( ins.t0 = rte_rdtsc() );
+    frames = rte_eth_rx_burst(eth_id, 0, pkt_mbufs, MAX_PKT_BURST);
+    INSTR( ins.burst[frames]++ );
+    all_frames += frames;
+    for (i=0; i < frames; i++){
+      uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbufs[i], uint8_t *); // Access the PDV Frame in the message buffer
+      const frameLayout *l; // layout of the frame
+      // check EtherType at offset 12: IPv6, IPv4, or anything else
+      if ( *(uint16_t *)&pkt[layout6.ether_type]==ipv6 )
+        l = &layout6;
+      else if ( *(uint16_t *)&pkt[layout4.ether_type]==ipv4 )
+        l = &layout4;
+      else
+        l = NULL;
+      /* check if the transport protocol is UDP, and the first 8 bytes of UDP data is 'IDENTIFY' */
+      if ( likely( l && pkt[l->proto]==17 && *(uint64_t *)&pkt[l->data]==*id ) ) {
+        // PDV frame
+        uint64_t timestamp = rte_rdtsc(); // get a timestamp ASAP
+        uint64_t counter = *(uint64_t *)&pkt[l->id];
+        if ( unlikely ( counter >= frames_to_send ) )
+          rte_exit(EXIT_FAILURE, "Error: PDV Frame with invalid frame ID was received!\n"); // to avoid segmentation fault
+        received++; // also count it
+        uint64_t k = counter/interval_frames; // the interval of the frame
+        if ( unlikely( k < first || k >= first+num_slots ) ) {
+          late++; // its interval is already closed
+        } else {
+          soakStats *s = &slot[k % num_slots];
+          s->received++;
+          // the entry is consistent, if it holds the counter of the frame both before and after reading the timestamp
+          soakEntry *e = &ring[counter & ring_mask];
+          uint64_t c1 = e->counter;
+          rte_smp_rmb();
+          uint64_t ts = e->ts;
+          rte_smp_rmb();
+          if ( likely( c1 == counter && e->counter == counter ) ) {
+            uint64_t delay = timestamp > ts ? timestamp-ts : 0;
+            uint64_t bucket = delay/tsc_per_us;
+            s->histogram[bucket < SOAK_HIST_SIZE ? bucket : SOAK_HIST_SIZE-1]++;
+            if ( delay > s->max_delay )
+              s->max_delay = delay;
+          } else {
+            s->untimed++; // the timestamp was overwritten by a later frame
+          }
+        }
+      }
+      rte_pktmbuf_free(pkt_mbufs[i]);
+    }
+    INSTR( if ( frames ) ins.busy_cycles += rte_rdtsc()-ins.t0 );
+  }
+  // the remaining intervals are closed, too
+  for ( ; first < num_intervals; first++ ) {
+    closeInterval(p, first, num_intervals, &slot[first % num_slots], total, hz);
+  }
+  INSTR( reportReceiverInstruments(&ins, side) );
+  printf("Info: %s foreign frames received: %lu\n", side, all_frames-received);
+  printf("%s frames received: %lu\n", side, received);
+  printf("Info: %s frames received after the global timeout of their interval: %lu\n", side, late);
+  total->report(side, "total", frames_to_send, hz);
+  delete [] slot;
+  delete total;
+  return received;
+}
+
+void Soak::measure(uint16_t leftport, uint16_t rightport) {
+  soakEntry *left_ring=0, *right_ring=0; // send timestamp rings
+  uint64_t ring_size = ringSize();
+  senderParametersSoak *left_spars=0, *right_spars=0; // parameters of the active senders, they must exist until the senders finish
+  receiverParametersSoak *left_rpars=0, *right_rpars=0; // parameters of the active receivers, they must exist until the receivers finish
+
+  startPortStats(); // before anything is sent
+
+  // set common parameters for senders
+  senderCommonParameters scp(ipv6_frame_size,ipv4_frame_size,frame_rate,duration,n,m,hz,start_tsc);
+  scp.max_lateness_tsc = hz*max_lateness/1000000;
+  scp.arrival_dist = arrival_dist;
+  scp.arrival_burst = arrival_burst;
+  scp.arrival_peak = arrival_peak;
+
+  // the entries of the rings are invalid at the beginning
+  if ( forward ) {
+    left_ring = (soakEntry *) rte_malloc_socket(0, ring_size*sizeof(soakEntry), 128, rte_lcore_to_socket_id(cpu_left_sender));
+    if ( !left_ring )
+      rte_exit(EXIT_FAILURE, "Error: Tester can't allocate memory for the send timestamp ring!\n");
+    memset(left_ring, 0xff, ring_size*sizeof(soakEntry));
+  }
+  if ( reverse ) {
+    right_ring = (soakEntry *) rte_malloc_socket(0, ring_size*sizeof(soakEntry), 128, rte_lcore_to_socket_id(cpu_right_sender));
+    if ( !right_ring )
+      rte_exit(EXIT_FAILURE, "Error: Tester can't allocate memory for the send timestamp ring!\n");
+    memset(right_ring, 0xff, ring_size*sizeof(soakEntry));
+  }
+  printf("Info: Send timestamp rings of %lu entries are used, delays above %.3lf ms cannot be measured.\n", ring_size, 1000.0*ring_size/frame_rate);
+
+  if ( forward ) {      // Left to right direction is active
+
+    // set individual parameters for the left sender
+
+    // first, collect the appropriate values dependig on the IP versions
+    ipQuad ipq(ip_left_version,ip_right_version,&ipv4_left_real,&ipv4_right_real,&ipv4_left_virtual,&ipv4_right_virtual,
+               &ipv6_left_real,&ipv6_right_real,&ipv6_left_virtual,&ipv6_right_virtual);
+
+    // then, initialize the parameter class instance
+    left_spars = new senderParametersSoak(&scp,ip_left_version,pkt_pool_left_sender,leftport,"Forward",(ether_addr *)mac_left_dut,(ether_addr *)mac_left_tester,
+                                          ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_left_real,&ipv6_right_real,num_right_nets,left_ring,ring_size);
+  }
+
+  if ( reverse ) {      // Right to Left direction is active
+
+    // set individual parameters for the right sender
+
+    // first, collect the appropriate values dependig on the IP versions
+    ipQuad ipq(ip_right_version,ip_left_version,&ipv4_right_real,&ipv4_left_real,&ipv4_right_virtual,&ipv4_left_virtual,
+               &ipv6_right_real,&ipv6_left_real,&ipv6_right_virtual,&ipv6_left_virtual);
+
+    // then, initialize the parameter class instance
+    right_spars = new senderParametersSoak(&scp,ip_right_version,pkt_pool_right_sender,rightport,"Reverse",(ether_addr *)mac_right_dut,(ether_addr *)mac_right_tester,
+                                           ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_right_real,&ipv6_left_real,num_left_nets,right_ring,ring_size);
+  }
+
+  // the PDV Frames are pre-generated in parallel, and the senders start START_DELAY after it
+  pregenerateFrames(this, left_spars, right_spars, soakStamp::copies, mkPdvFrame4, mkPdvFrame6);
+  setStartTime();
+  scp.start_tsc = start_tsc;
+  startRefDut();
+
+  if ( forward ) {
+    // start left sender
+    if ( rte_eal_remote_launch(sendSoak, left_spars, cpu_left_sender) )
+      std::cout << "Error: could not start Left Sender." << std::endl;
+
+    // set parameters for the right receiver
+    right_rpars = new receiverParametersSoak(finish_receiving,rightport,"Forward",left_ring,ring_size,frame_rate,interval,global_timeout);
+    right_rpars->start_tsc = start_tsc;
+    right_rpars->frames_to_send = scp.frames_to_send;
+
+    // start right receiver
+    if ( rte_eal_remote_launch(receiveSoak, right_rpars, cpu_right_receiver) )
+      std::cout << "Error: could not start Right Receiver." << std::endl;
+  }
+
+  if ( reverse ) {
+    // start right sender
+    if (rte_eal_remote_launch(sendSoak, right_spars, cpu_right_sender) )
+      std::cout << "Error: could not start Right Sender." << std::endl;
+
+    // set parameters for the left receiver
+    left_rpars = new receiverParametersSoak(finish_receiving,leftport,"Reverse",right_ring,ring_size,frame_rate,interval,global_timeout);
+    left_rpars->start_tsc = start_tsc;
+    left_rpars->frames_to_send = scp.frames_to_send;
+
+    // start left receiver
+    if ( rte_eal_remote_launch(receiveSoak, left_rpars, cpu_left_receiver) )
+      std::cout << "Error: could not start Left Receiver." << std::endl;
+
+  }
+
+  std::cout << "Info: Testing started." << std::endl;
+
+  // wait until active senders and receivers finish
+  if ( forward ) {
+    rte_eal_wait_lcore(cpu_left_sender);
+    rte_eal_wait_lcore(cpu_right_receiver);
+  }
+  if ( reverse ) {
+    rte_eal_wait_lcore(cpu_right_sender);
+    rte_eal_wait_lcore(cpu_left_receiver);
+  }
+  deleteSenderParameters(left_spars);
+  deleteSenderParameters(right_spars);
+  delete left_rpars;
+  delete right_rpars;
+  finishRefDut();
+  finishPortStats();
+  rte_free(left_ring);
+  rte_free(right_ring);
+
+  std::cout << "Info: Test finished." << std::endl;
+}
+
+senderParametersSoak::senderParametersSoak(class senderCommonParameters *cp_, int ip_version_, rte_mempool *pkt_pool_, uint8_t eth_id_, const char *side_,
+                                           struct ether_addr *dst_mac_,  struct ether_addr *src_mac_,  uint32_t *src_ipv4_, uint32_t *dst_ipv4_,
+                                           struct in6_addr *src_ipv6_, struct in6_addr *dst_ipv6_, struct in6_addr *src_bg_, struct in6_addr *dst_bg_,
+                                           uint16_t num_dest_nets_, soakEntry *ring_, uint64_t ring_size_) :
+  senderParameters(cp_,ip_version_,pkt_pool_,eth_id_,side_,dst_mac_,src_mac_,src_ipv4_,dst_ipv4_,src_ipv6_,dst_ipv6_,src_bg_,dst_bg_,num_dest_nets_) {
+  ring = ring_;
+  ring_size = ring_size_;
+}
+
+receiverParametersSoak::receiverParametersSoak(uint64_t finish_receiving_, uint8_t eth_id_, const char *side_, soakEntry *ring_, uint64_t ring_size_,
+                                               uint32_t frame_rate_, uint32_t interval_, uint16_t global_timeout_) :
+  receiverParameters(finish_receiving_,eth_id_,side_) {
+  ring = ring_;
+  ring_size = ring_size_;
+  frame_rate = frame_rate_;
+  interval = interval_;
+  global_timeout = global_timeout_;
+}
@@ -0,0 +1,83 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOAK_H_INCLUDED
+#define SOAK_H_INCLUDED
+
+struct soakEntry;	// see sender.h
+
+// the main class for long-duration soak tests, adds some features to class Throughput:
+// the frames are PDV Frames, their send timestamps are kept in a ring of fixed size, and the receivers collect the frame loss
+// and a delay histogram for each summary interval, which is printed, when the global timeout has elapsed after the end of the
+// interval; thus the memory consumption does not depend on the duration (which may be up to MAX_SOAK_DURATION seconds)
+class Soak : public Throughput {
+public:
+  uint32_t interval;		// length of the summary intervals (in seconds)
+
+  Soak() : Throughput() { program = "soak"; }; // default constructor
+  int readCmdLine(int argc, const char *argv[]);	// reads further one argument: interval
+  virtual int senderPoolSize(int numDestNets);
+  virtual uint64_t timestampMemory();	// the send timestamp rings
+  uint64_t ringSize();			// number of entries of a send timestamp ring
+
+  // perform soak test
+  void measure(uint16_t leftport, uint16_t rightport);
+};
+
+// delay and loss statistics of a summary interval or of the whole soak test
+struct soakStats {
+  uint64_t received;			// number of frames received in time
+  uint64_t untimed;			// number of frames received, the send timestamp of which was already overwritten in the ring
+  uint64_t max_delay;			// the highest delay (in TSC)
+  uint64_t histogram[SOAK_HIST_SIZE];	// delays with 1us resolution, longer ones are counted in the last bucket
+
+  soakStats() { memset(this, 0, sizeof(*this)); }
+  void add(soakStats *s);		// adds s to this one, and clears s
+  void report(const char *side, const char *name, uint64_t sent, uint64_t hz);
+};
+
+class senderParametersSoak : public senderParameters {
+public:
+  soakEntry *ring;		// send timestamp ring
+  uint64_t ring_size;		// number of entries, a power of 2
+  senderParametersSoak(class senderCommonParameters *cp_, int ip_version_, rte_mempool *pkt_pool_, uint8_t eth_id_, const char *side_,
+                       struct ether_addr *dst_mac_,  struct ether_addr *src_mac_,  uint32_t *src_ipv4_, uint32_t *dst_ipv4_,
+                       struct in6_addr *src_ipv6_, struct in6_addr *dst_ipv6_, struct in6_addr *src_bg_, struct in6_addr *dst_bg_,
+                       uint16_t num_dest_nets_, soakEntry *ring_, uint64_t ring_size_);
+};
+
+class receiverParametersSoak : public receiverParameters {
+  public:
+  soakEntry *ring;		// send timestamp ring of the sender of the same direction
+  uint64_t ring_size;		// number of entries, a power of 2
+  uint32_t frame_rate;		// number of frames per second
+  uint32_t interval;		// length of the summary intervals (in seconds)
+  uint16_t global_timeout;	// an interval is closed so many milliseconds after its end
+  receiverParametersSoak(uint64_t finish_receiving_, uint8_t eth_id_, const char *side_, soakEntry *ring_, uint64_t ring_size_,
+                         uint32_t frame_rate_, uint32_t interval_, uint16_t global_timeout_);
+};
+
+// sends PDV Frames, and stores their send timestamps in the ring
+int sendSoak(void *par);
+
+// receives PDV Frames, and collects the statistics of the summary intervals
+int receiveSoak(void *par);
+
+#endif
@@ -21,6 +21,14 @@
 #include "defines.h"
 #include "includes.h"
 #include "throughput.h"
+#include "frame.h"
+#include "timeline.h"
+#include "live.h"
+#include "pacing.h"
+#include "instrument.h"
+#include "sender.h"
+#include "nicstats.h"
+#include "refdut.h"
 
 char coresList[101]; // buffer for preparing the list of lcores for DPDK init (like a command line argument)
 char numChannels[11]; // buffer for printing the number of memory channels into a string for DPDK init (like a command line argument)
@@ -36,9 +44,38 @@ Throughput::Throughput(){
   cpu_right_receiver = -1; 	// MUST be set in the config file if forward != 0
   cpu_right_sender = -1; 	// MUST be set in the config file if reverse != 0
   cpu_left_receiver = -1; 	// MUST be set in the config file if reverse != 0
+  cpu_ref_dut = -1;		// default value: no reference DUT
+  cpu_auto = 0;			// default value: the lcores are set in the config file
+  imp_delay = imp_jitter = 0;	// default value: no impairment
+  imp_dist = 'U';		// default value: uniform jitter
+  imp_loss = imp_dup = imp_reorder = 0; // default value: no impairment
+  imp_burst = 1;		// default value: single frame loss events
+  ring_loopback = 0;		// default value: the ports are NICs (or net_ring ports of the reference DUT)
+  program = "tp";		// redefined by the constructors of the derived classes
   memory_channels = 1; 		// default value, this value will be set, if not specified in the config file
   num_left_nets = 1;		// default value: single flow
   num_right_nets = 1;		// default value: single flow
+  timeline_interval = 0;	// default value: no throughput timeline
+  live_page_name[0] = 0;	// default value: no live counters page
+  live = 0;			// set by init(), if live_page_name is not empty
+  max_lateness = 0;		// default value: frame lateness is not checked
+  hw_pacing = 0;		// default value: the senders are paced by the TSC
+  size_mix.num_sizes = 0;	// default value: all frames have the size given in the command line
+  rate_profile.num_segments = rate_profile.num_steps = 0; // default value: constant frame rate
+  rate_profile.segments = 0;
+  rate_profile.steps = 0;
+  train_length = 0;		// set by BackToBack::readCmdLine()
+  arrival_dist = 'P';		// default value: periodic sending
+  arrival_burst = 16;		// default value for Markov on/off arrivals
+  arrival_peak = 4;		// default value for Markov on/off arrivals
+  left_port_stats = right_port_stats = 0; // set by init()
+  pkt_pool_ref_dut = 0;		// set by init(), if cpu_ref_dut >= 0
+  ref_dut_eam = 0;		// set by init(), if cpu_ref_dut >= 0
+  ref_dut_pars = 0;		// set by startRefDut()
+  imp_queue_size = 0;		// set by initRefDut(), if impairments are used
+  num_pairs = 1;		// default value: only the Left and Right ports are used
+  core_consol = 0;		// default value: each sender and receiver has its own lcore
+  setPairId(0);
 };
 
 // finds a 'key' (name of a parameter) in the 'line' string
@@ -97,6 +134,173 @@ int nonComment(const char *line) {
   return 1;
 }
 
+// reads a frame size mix: a comma separated list of "IPv6 frame size:weight" pairs, or "IMIX", which is the simple IMIX with 7:4:1
+// weights as "84:7,614:4,1518:1" (that is, 64 and 594 byte IPv4 frames, and 1518 byte IPv6 frames as the largest ones);
+// the size sequence is made by smooth weighted round robin, thus the size classes are evenly interleaved
+int Throughput::readSizeMix(const char *spec) {
+  sizeMix *mix = &size_mix;
+  int current[MAX_SIZE_CLASSES];	// current weights of the smooth weighted round robin
+  unsigned size, weight;		// the values of the actual pair
+  int chars;				// number of characters of the actual pair
+  int i, j, best;
+
+  if ( !strcmp(spec, "IMIX") )
+    spec = "84:7,614:4,1518:1";
+  mix->num_sizes = 0;
+  mix->seq_len = 0;
+  while ( sscanf(spec, "%u:%u%n", &size, &weight, &chars) == 2 ) {
+    if ( mix->num_sizes == MAX_SIZE_CLASSES ) {
+      std::cerr << "Input Error: 'Size-Mix' may contain at most " << MAX_SIZE_CLASSES << " frame sizes." << std::endl;
+      return -1;
+    }
+    if ( size < 84 || size > MAX_FRAME_SIZE || weight < 1 || mix->seq_len+weight > MAX_SIZE_SEQ ) {
+      std::cerr << "Input Error: 'Size-Mix' frame sizes must be between 84 and " << MAX_FRAME_SIZE << ", and the sum of the weights must be between 1 and "
+                << MAX_SIZE_SEQ << "." << std::endl;
+      return -1;
+    }
+    for ( i=0; i<mix->num_sizes; i++ )
+      if ( mix->ipv6_size[i] == size ) {
+        std::cerr << "Input Error: Frame size " << size << " occurs more than once in 'Size-Mix'." << std::endl;
+        return -1;
+      }
+    mix->ipv6_size[mix->num_sizes] = size;
+    mix->weight[mix->num_sizes++] = weight;
+    mix->seq_len += weight;
+    spec += chars;
+    if ( *spec != ',' )
+      break;
+    spec++;
+  }
+  if ( *spec || !mix->num_sizes ) {
+    std::cerr << "Input Error: 'Size-Mix' must be 'IMIX' or a comma separated list of 'size:weight' pairs." << std::endl;
+    return -1;
+  }
+  for ( i=0; i<mix->num_sizes; i++ )
+    current[i] = 0;
+  for ( j=0; j<mix->seq_len; j++ ) {
+    for ( i=best=0; i<mix->num_sizes; i++ ) {
+      current[i] += mix->weight[i];
+      if ( current[i] > current[best] )
+        best = i;
+    }
+    current[best] -= mix->seq_len;
+    mix->seq[j] = best;
+  }
+  return 0;
+}
+
+// reads a rate profile file: each line is a segment given by its length in seconds and its frame rate, or its frame rate at the
+// beginning and at the end, if the frame rate changes linearly (e.g. "10 100000 500000" is a 10 seconds long ramp); the ramps
+// are approximated by PROFILE_STEP_MS milliseconds long steps with the frame rate of their middle; the profile is shared by
+// the objects of the trials of a session, thus it is never freed (only a profile given earlier in the config file is replaced)
+int Throughput::readRateProfile(const char *filename) {
+  FILE *f;			// file descriptor
+  char line[LINELEN+1];		// buffer for reading a line of the file
+  double seconds;		// length of the current segment
+  uint32_t start_rate, end_rate;	// frame rate at the beginning and at the end of the current segment
+  uint32_t start_ms=0;		// beginning of the current segment
+  profileSegment *seg;		// the segments read (only num_segments of them are kept)
+  int num_segments=0;
+
+  if ( !(f=fopen(filename,"r")) ) {
+    std::cerr << "Input Error: Can't open rate profile file '" << filename << "'." << std::endl;
+    return -1;
+  }
+  seg = new profileSegment[MAX_PROFILE_SEGMENTS];
+  while ( fgets(line, LINELEN+1, f) ) {
+    if ( !nonComment(line) )
+      continue;
+    int fields = sscanf(line, "%lf %u %u", &seconds, &start_rate, &end_rate);
+    if ( fields < 2 || seconds < 0.001 || start_rate > 14880952 || (fields == 3 && end_rate > 14880952) ) {
+      std::cerr << "Input Error: Bad rate profile line: " << line << "It must contain the length (in seconds) and the frame rate(s) of a segment." << std::endl;
+      fclose(f);
+      delete [] seg;
+      return -1;
+    }
+    if ( num_segments == MAX_PROFILE_SEGMENTS ) {
+      std::cerr << "Input Error: The rate profile may contain at most " << MAX_PROFILE_SEGMENTS << " segments." << std::endl;
+      fclose(f);
+      delete [] seg;
+      return -1;
+    }
+    seg[num_segments].start_rate = start_rate;
+    seg[num_segments].end_rate = fields == 3 ? end_rate : start_rate;
+    start_ms += (uint32_t) (seconds*1000+0.5);
+    seg[num_segments++].end_ms = start_ms;
+    if ( start_ms > 3600000 ) {
+      std::cerr << "Input Error: The rate profile must not be longer than 3600 seconds." << std::endl;
+      fclose(f);
+      delete [] seg;
+      return -1;
+    }
+  }
+  fclose(f);
+  if ( !num_segments ) {
+    std::cerr << "Input Error: The rate profile is empty." << std::endl;
+    delete [] seg;
+    return -1;
+  }
+  profileSegment *segments = new profileSegment[num_segments];
+  std::copy(seg, seg+num_segments, segments);
+  delete [] seg;
+  delete [] rate_profile.segments;	// if 'Rate-Profile' was given more than once
+  delete [] rate_profile.steps;
+  rate_profile.num_segments = rate_profile.num_steps = 0;
+  rate_profile.segments = 0;
+  rate_profile.steps = 0;
+  if ( setRateProfile(segments, num_segments) < 0 ) {
+    delete [] segments;
+    return -1;
+  }
+  return 0;
+}
+
+// sets the rate profile from its segments (their end_ms, start_rate and end_rate are given, end_frame is computed)
+int Throughput::setRateProfile(profileSegment *seg, int num_segments) {
+  uint32_t start_ms;		// beginning of the current segment
+  double frames=0;		// number of frames sent before the current step (not rounded)
+  int num_steps=0, i;
+  uint32_t t;			// beginning of the current step relative to the beginning of the segment
+
+  // the steps: a single one for a constant rate segment, and one for every PROFILE_STEP_MS milliseconds of a ramp
+  for ( i=0, start_ms=0; i<num_segments; start_ms=seg[i++].end_ms )
+    num_steps += seg[i].start_rate == seg[i].end_rate ? 1 : (seg[i].end_ms-start_ms+PROFILE_STEP_MS-1)/PROFILE_STEP_MS;
+  profileStep *step = new profileStep[num_steps+1];
+  num_steps = 0;
+  for ( i=0, start_ms=0; i<num_segments; start_ms=seg[i++].end_ms ) {
+    uint32_t length = seg[i].end_ms-start_ms;	// length of the segment
+    uint32_t step_ms = seg[i].start_rate == seg[i].end_rate ? length : PROFILE_STEP_MS; // length of its steps
+    for ( t=0; t<length; t+=step_ms ) {
+      uint32_t ms = std::min(step_ms, length-t);	// length of the current step
+      step[num_steps].first_frame = (uint64_t) (frames+0.5);
+      step[num_steps].start_ms = start_ms+t;
+      step[num_steps].rate = (uint32_t) (seg[i].start_rate+((double)seg[i].end_rate-seg[i].start_rate)*(t+ms/2.0)/length+0.5);
+      frames += (double) step[num_steps++].rate*ms/1000;
+    }
+    seg[i].end_frame = (uint64_t) (frames+0.5);
+  }
+  step[num_steps].first_frame = ~0ULL; // sentinel
+  if ( !seg[num_segments-1].end_frame ) {
+    std::cerr << "Input Error: No frames are sent according to the rate profile." << std::endl;
+    delete [] step;
+    return -1;
+  }
+  rate_profile.num_segments = num_segments;
+  rate_profile.segments = seg;
+  rate_profile.num_steps = num_steps;
+  rate_profile.steps = step;
+  return 0;
+}
+
+// returns the number of frames of the given size class among the first "frames" frames
+uint64_t sizeMixCount(const sizeMix *mix, int size_class, uint64_t frames) {
+  uint64_t count = frames/mix->seq_len*mix->weight[size_class];
+  for ( int i=0; i<(int)(frames%mix->seq_len); i++ )
+    if ( mix->seq[i] == size_class )
+      count++;
+  return count;
+}
+
 // reads the configuration file and stores the information in data members of class Throughput
 int Throughput::readConfigFile(const char *filename) {
   FILE *f; 	// file descriptor
@@ -229,12 +433,102 @@ int Throughput::readConfigFile(const char *filename) {
         std::cerr << "Input Error: 'CPU-L-Recv' must be >= 0 and < RTE_MAX_LCORE." << std::endl;
         return -1;
       }
+    } else if ( (pos = findKey(line, "CPU-Ref-DUT")) >= 0 ) {
+      sscanf(line+pos, "%d", &cpu_ref_dut);
+      if ( cpu_ref_dut < 0 || cpu_ref_dut >= RTE_MAX_LCORE ) {
+        std::cerr << "Input Error: 'CPU-Ref-DUT' must be >= 0 and < RTE_MAX_LCORE." << std::endl;
+        return -1;
+      }
+    } else if ( (pos = findKey(line, "CPU-Auto")) >= 0 ) {
+      sscanf(line+pos, "%d", &cpu_auto);
+    } else if ( (pos = findKey(line, "Core-Consol")) >= 0 ) {
+      sscanf(line+pos, "%d", &core_consol);
+      if ( core_consol < 0 || core_consol > 2 ) {
+        std::cerr << "Input Error: 'Core-Consol' must be 0, 1 or 2." << std::endl;
+        return -1;
+      }
+    } else if ( (pos = findKey(line, "Imp-Delay")) >= 0 ) {
+      sscanf(line+pos, "%u", &imp_delay);
+    } else if ( (pos = findKey(line, "Imp-Jitter")) >= 0 ) {
+      sscanf(line+pos, "%u", &imp_jitter);
+    } else if ( (pos = findKey(line, "Imp-Dist")) >= 0 ) {
+      imp_dist = *prune(line+pos);
+      if ( imp_dist!='U' && imp_dist!='E' && imp_dist!='N' ) {
+        std::cerr << "Input Error: 'Imp-Dist' must be U, E or N." << std::endl;
+        return -1;
+      }
+    } else if ( (pos = findKey(line, "Imp-Loss")) >= 0 ) {
+      sscanf(line+pos, "%u", &imp_loss);
+    } else if ( (pos = findKey(line, "Imp-Burst")) >= 0 ) {
+      sscanf(line+pos, "%hu", &imp_burst);
+      if ( imp_burst < 1 ) {
+        std::cerr << "Input Error: 'Imp-Burst' must be at least 1." << std::endl;
+        return -1;
+      }
+    } else if ( (pos = findKey(line, "Imp-Dup")) >= 0 ) {
+      sscanf(line+pos, "%u", &imp_dup);
+    } else if ( (pos = findKey(line, "Imp-Reorder")) >= 0 ) {
+      sscanf(line+pos, "%u", &imp_reorder);
+    } else if ( (pos = findKey(line, "Ring-Loopback")) >= 0 ) {
+      sscanf(line+pos, "%d", &ring_loopback);
     } else if ( (pos = findKey(line, "MEM-Channels")) >= 0 ) {
       sscanf(line+pos, "%hhu", &memory_channels);
       if ( memory_channels <= 0 ) {
         std::cerr << "Input Error: 'MEM-Channels' must be > 0." << std::endl;
         return -1;
       }
+    } else if ( (pos = findKey(line, "Live-Page")) >= 0 ) {
+      strcpy(live_page_name, prune(line+pos));
+      if ( live_page_name[0] != '/' || strchr(live_page_name+1,'/') ) {
+        std::cerr << "Input Error: 'Live-Page' must be a name starting with '/' and containing no further '/'." << std::endl;
+        return -1;
+      }
+    } else if ( (pos = findKey(line, "Max-Lateness")) >= 0 ) {
+      sscanf(line+pos, "%u", &max_lateness);
+    } else if ( (pos = findKey(line, "Rate-Profile")) >= 0 ) {
+      if ( readRateProfile(prune(line+pos)) < 0 )
+        return -1;
+    } else if ( (pos = findKey(line, "Size-Mix")) >= 0 ) {
+      if ( readSizeMix(prune(line+pos)) < 0 )
+        return -1;
+    } else if ( (pos = findKey(line, "Arrival-Dist")) >= 0 ) {
+      arrival_dist = *prune(line+pos);
+      if ( arrival_dist!='P' && arrival_dist!='E' && arrival_dist!='O' ) {
+        std::cerr << "Input Error: 'Arrival-Dist' must be P, E or O." << std::endl;
+        return -1;
+      }
+    } else if ( (pos = findKey(line, "Arrival-Burst")) >= 0 ) {
+      sscanf(line+pos, "%hu", &arrival_burst);
+      if ( arrival_burst < 1 ) {
+        std::cerr << "Input Error: 'Arrival-Burst' must be at least 1." << std::endl;
+        return -1;
+      }
+    } else if ( (pos = findKey(line, "Arrival-Peak")) >= 0 ) {
+      sscanf(line+pos, "%hu", &arrival_peak);
+      if ( arrival_peak < 2 ) {
+        std::cerr << "Input Error: 'Arrival-Peak' must be at least 2." << std::endl;
+        return -1;
+      }
+    } else if ( (pos = findKey(line, "HW-Pacing")) >= 0 ) {
+      sscanf(line+pos, "%d", &hw_pacing);
+    } else if ( (pos = findKey(line, "Timeline-Ival")) >= 0 ) {
+      unsigned interval = 0;
+      sscanf(line+pos, "%u", &interval);
+      if ( interval < 1 || interval > 60000 ) {
+        std::cerr << "Input Error: 'Timeline-Ival' must be between 1 and 60000." << std::endl;
+        return -1;
+      }
+      timeline_interval = interval;
+    } else if ( (pos = findKey(line, "Pair-Config")) >= 0 ) {
+      if ( pair_id ) {
+        std::cerr << "Input Error: 'Pair-Config' cannot be used in the configuration file of a further port pair." << std::endl;
+        return -1;
+      }
+      if ( num_pairs == MAX_PORT_PAIRS ) {
+        std::cerr << "Input Error: At most " << MAX_PORT_PAIRS << " port pairs can be used." << std::endl;
+        return -1;
+      }
+      strcpy(pair_config[num_pairs++], prune(line+pos));
     } else if ( nonComment(line) ) { // It may be too strict!
         std::cerr << "Input Error: Cannot interpret '" << filename << "' line " << line_no << ":" << std::endl;
         std::cerr << line << std::endl;
@@ -247,7 +541,37 @@ int Throughput::readConfigFile(const char *filename) {
     std::cerr << "Input Error: No active direction was specified." << std::endl;
     return -1;
   }
-  // check if the necessary lcores were specified
+  if ( ring_loopback && cpu_ref_dut >= 0 ) {
+    std::cerr << "Input Error: 'Ring-Loopback' and 'CPU-Ref-DUT' cannot be used together." << std::endl;
+    return -1;
+  }
+  // check if the impairments can be applied
+  if ( ( imp_delay || imp_jitter || imp_loss || imp_dup || imp_reorder ) && cpu_ref_dut < 0 ) {
+    std::cerr << "Input Error: Impairments can only be used with the reference DUT ('CPU-Ref-DUT')." << std::endl;
+    return -1;
+  }
+  if ( imp_loss > 1000000 || imp_dup > 1000000 || imp_reorder > 1000000 ) {
+    std::cerr << "Input Error: 'Imp-Loss', 'Imp-Dup' and 'Imp-Reorder' must be <= 1000000." << std::endl;
+    return -1;
+  }
+  if ( num_pairs > 1 && readPairs() < 0 )
+    return -1;
+  if ( core_consol ) {
+    if ( cpu_auto || num_pairs > 1 || timeline_interval || live_page_name[0] || size_mix.num_sizes || rate_profile.num_segments ||
+         arrival_dist != 'P' || hw_pacing ) {
+      std::cerr << "Input Error: 'Core-Consol' cannot be used together with 'CPU-Auto', 'Pair-Config', 'Timeline-Ival', 'Live-Page', "
+                   "'Size-Mix', 'Rate-Profile', 'Arrival-Dist' (other than P) or 'HW-Pacing'." << std::endl;
+      return -1;
+    }
+    // the receivers run on the lcores of the senders
+    if ( core_consol == 2 && forward && reverse )
+      cpu_right_sender = cpu_left_sender;
+    cpu_right_receiver = core_consol == 2 && !forward ? cpu_right_sender : cpu_left_sender;
+    cpu_left_receiver = core_consol == 2 && forward ? cpu_left_sender : cpu_right_sender;
+  }
+  // check if the necessary lcores were specified (or they are chosen automatically)
+  if ( cpu_auto )
+    return 0;
   if ( forward ) {
     if ( cpu_left_sender < 0 ) {
       std::cerr << "Input Error: No 'CPU-L-Send' was specified." << std::endl;
@@ -271,6 +595,65 @@ int Throughput::readConfigFile(const char *filename) {
   return 0;
 }
 
+// reads the configuration files of the further port pairs: each pair starts as a copy of this object, thus its file needs to contain
+// only the parameters that differ, e.g. the addresses, the number of destination networks, the directions and the lcores
+int Throughput::readPairs() {
+  int lcores[4*MAX_PORT_PAIRS], num_lcores=0, i, j, k;
+
+  setPairId(0); // the ports of the first pair are also numbered
+  for ( k=1; k<num_pairs; k++ ) {
+    pair[k] = new Throughput(*this);
+    pair[k]->num_pairs = 1;
+    pair[k]->setPairId(k);
+    if ( pair[k]->readConfigFile(pair_config[k]) < 0 )
+      return -1;
+  }
+  for ( k=0; k<num_pairs; k++ ) {
+    Throughput *t = k ? pair[k] : this;
+    if ( t->cpu_auto || t->cpu_ref_dut >= 0 || t->ring_loopback || t->live_page_name[0] || t->timeline_interval || t->core_consol ) {
+      std::cerr << "Input Error: 'Pair-Config' cannot be used together with 'CPU-Auto', 'CPU-Ref-DUT', 'Ring-Loopback', 'Live-Page', 'Timeline-Ival' or 'Core-Consol'." << std::endl;
+      return -1;
+    }
+    if ( t->forward ) {
+      lcores[num_lcores++] = t->cpu_left_sender;
+      lcores[num_lcores++] = t->cpu_right_receiver;
+    }
+    if ( t->reverse ) {
+      lcores[num_lcores++] = t->cpu_right_sender;
+      lcores[num_lcores++] = t->cpu_left_receiver;
+    }
+  }
+  // all senders and receivers must have their own lcores
+  for ( i=0; i<num_lcores; i++ )
+    for ( j=i+1; j<num_lcores; j++ )
+      if ( lcores[i] >= 0 && lcores[i] == lcores[j] ) {
+        std::cerr << "Input Error: lcore " << lcores[i] << " is used by more than one sender or receiver of the port pairs." << std::endl;
+        return -1;
+      }
+  return 0;
+}
+
+// sets the index of this object among the port pairs, and the names of its ports
+void Throughput::setPairId(int id) {
+  pair_id = id;
+  if ( num_pairs > 1 || id ) {
+    snprintf(left_name, sizeof(left_name), "Left %d", id);
+    snprintf(right_name, sizeof(right_name), "Right %d", id);
+  } else {
+    strcpy(left_name, "Left");
+    strcpy(right_name, "Right");
+  }
+}
+
+// the names of the packet pools of the further port pairs are suffixed by their index, as the names must be unique
+const char *Throughput::poolName(char *name, const char *base) {
+  if ( pair_id )
+    snprintf(name, RTE_MEMPOOL_NAMESIZE, "%s_%d", base, pair_id);
+  else
+    snprintf(name, RTE_MEMPOOL_NAMESIZE, "%s", base);
+  return name;
+}
+
 // reads the command line arguments and stores the information in data members of class Throughput
 // It may be called only AFTER the execution of readConfigFile
 int Throughput::readCmdLine(int argc, const char *argv[]) {
@@ -283,14 +666,23 @@ int Throughput::readCmdLine(int argc, const char *argv[]) {
     return -1;
   }
   // Further checking of the frame size will be done, when n and m are read.
+  if ( size_mix.num_sizes && strcmp(program, "tp") ) {
+    std::cout << "Warning: 'Size-Mix' is supported by siitperf-tp only, the frame size of the command line is used." << std::endl;
+    size_mix.num_sizes = 0;
+  }
+  if ( size_mix.num_sizes ) {
+    ipv6_frame_size = *std::max_element(size_mix.ipv6_size, size_mix.ipv6_size+size_mix.num_sizes); // for the pools and the checks
+    std::cout << "Info: Frame size mix is used, the largest IPv6 frame size is " << ipv6_frame_size << "." << std::endl;
+  }
   ipv4_frame_size=ipv6_frame_size-20;
   if ( sscanf(argv[2], "%u", &frame_rate) != 1 || frame_rate < 1 || frame_rate > 14880952 ) { 
     // 14,880,952 is the maximum frame rate for 10Gbps Ethernet using 64-byte frame size
     std::cerr << "Input Error: Frame rate must be between 1 and 14880952." << std::endl;
     return -1;
   }
-  if ( sscanf(argv[3], "%hu", &duration) != 1 || duration < 1 || duration > 3600 ) {
-    std::cerr << "Input Error: Test duration must be between 1 and 3600." << std::endl;
+  uint32_t max_duration = strcmp(program,"soak") ? 3600 : MAX_SOAK_DURATION; // only the soak test uses fixed memory for any duration
+  if ( sscanf(argv[3], "%u", &duration) != 1 || duration < 1 || duration > max_duration ) {
+    std::cerr << "Input Error: Test duration must be between 1 and " << max_duration << "." << std::endl;
     return -1;
   }
   if ( sscanf(argv[4], "%hu", &global_timeout) != 1 || global_timeout > 60000 ) {
@@ -306,44 +698,198 @@ int Throughput::readCmdLine(int argc, const char *argv[]) {
     return -1;
   }
 
+  if ( rate_profile.num_segments && strcmp(program, "tp") ) {
+    std::cout << "Warning: 'Rate-Profile' is supported by siitperf-tp only, the frame rate and the duration of the command line are used." << std::endl;
+    rate_profile.num_segments = 0;
+  }
+  if ( rate_profile.num_segments ) {
+    const profileSegment *seg = rate_profile.segments;
+    duration = (seg[rate_profile.num_segments-1].end_ms+999)/1000;
+    frame_rate = 0;
+    for ( int i=0; i<rate_profile.num_segments; i++ )
+      frame_rate = std::max(frame_rate, std::max(seg[i].start_rate, seg[i].end_rate));
+    std::cout << "Info: Rate profile is used: " << rate_profile.num_segments << " segments, " << duration << " seconds, maximum frame rate: "
+              << frame_rate << " fps." << std::endl;
+  }
+
   if ( ipv6_frame_size > 1518 && ( forward && ip_left_version == 6 || reverse && ip_right_version == 6 || m < n ) ) {
     std::cerr << "Input Error: IPv6 frame sizes between 1518 and 1538 are allowed for pure IPv4 traffic only (as IPv4 frames are 20 bytes shorter)." << std::endl;
     return -1;
   }
 
+  if ( num_pairs > 1 && strcmp(program, "tp") ) {
+    std::cout << "Warning: 'Pair-Config' is supported by siitperf-tp only, only the first port pair is used." << std::endl;
+    num_pairs = 1;
+  }
+  // the further port pairs use the same traffic parameters
+  for ( int k=1; k<num_pairs; k++ ) {
+    pair[k]->ipv6_frame_size = ipv6_frame_size;
+    pair[k]->ipv4_frame_size = ipv4_frame_size;
+    pair[k]->frame_rate = frame_rate;
+    pair[k]->duration = duration;
+    pair[k]->global_timeout = global_timeout;
+    pair[k]->n = n;
+    pair[k]->m = m;
+    pair[k]->size_mix = size_mix;
+    pair[k]->rate_profile = rate_profile;
+  }
+
+  // the senders and receivers of the other programs cannot share an lcore
+  if ( core_consol && strcmp(program, "tp") ) {
+    std::cerr << "Input Error: 'Core-Consol' is supported by siitperf-tp only." << std::endl;
+    return -1;
+  }
+
+  return checkCalibration(program, core_consol);
+}
+
+// checks if the frame rate is close to the maximum rate of the Tester (if there is calibration data for the given frame size and direction)
+// the lines of the calibration file are: program, IPv6 frame size, direction (b, f or r), maximum loss-free on-schedule frame rate
+// cal_prog: the program of the calibration data; if hard_limit is set (e.g. with core consolidation), then -1 is returned, if the
+// calibrated rate is exceeded
+int Throughput::checkCalibration(const char *cal_prog, int hard_limit) {
+  FILE *f;		// file descriptor
+  char line[LINELEN+1];	// buffer for reading a line of the calibration file
+  char prog[8], dir[2];	// program and direction in the current line
+  char calibrated[8];	// program of the calibration data: with core consolidation, e.g. "tp-c2"
+  const char *direction = forward && reverse ? "b" : forward ? "f" : "r"; // direction of the current test
+  const char *limited = core_consol ? "the consolidated lcores" : "the Tester"; // whose capacity is a hard limit
+  uint16_t size;	// frame size in the current line
+  uint32_t max_rate=0;	// calibrated maximum rate
+
+  if ( core_consol )
+    snprintf(calibrated, 8, "%s-c%d", cal_prog, core_consol);
+  else
+    snprintf(calibrated, 8, "%s", cal_prog);
+  if ( ring_loopback || !(f=fopen(CALIBRATIONFILE,"r")) ) {
+    // no warning is needed during calibration, and calibration is optional
+    if ( hard_limit && !ring_loopback )
+      std::cout << "Warning: No calibration data, the frame rate cannot be limited to the capacity of " << limited << "." << std::endl;
+    return 0;
+  }
+  while ( fgets(line, LINELEN+1, f) )
+    if ( nonComment(line) && sscanf(line, "%7s %hu %1s", prog, &size, dir) == 3 &&
+         !strcmp(prog, calibrated) && size == ipv6_frame_size && !strcmp(dir, direction) )
+      sscanf(line, "%*s %*s %*s %u", &max_rate); // the last matching line is used
+  fclose(f);
+  if ( !max_rate ) {
+    std::cout << "Info: No calibration data for siitperf-" << calibrated << ", frame size " << ipv6_frame_size << ", direction " << direction << "." << std::endl;
+    if ( hard_limit )
+      std::cout << "Warning: The frame rate cannot be limited to the capacity of " << limited << "." << std::endl;
+  } else if ( hard_limit && frame_rate > max_rate ) {
+    // the Tester cannot keep its schedule above its capacity, thus the test would only measure the Tester
+    std::cerr << "Input Error: The frame rate exceeds the calibrated capacity of " << limited << " (" << max_rate << " fps)." << std::endl;
+    return -1;
+  } else if ( frame_rate > CALIBRATION_MARGIN*max_rate )
+    printf("Warning: The frame rate is %.1lf%% of the calibrated maximum rate of the Tester (%u fps), the results may be tester-limited!\n",
+           100.0*frame_rate/max_rate, max_rate);
   return 0;
 }
 
 // Initializes DPDK EAL, starts network ports, creates and sets up TX/RX queues, checks NUMA localty and TSC synchronization of lcores
+// returns the NUMA node of an lcore, or SOCKET_ID_ANY, if the lcore is not used
+static int lcoreSocket(int cpu) {
+  return cpu >= 0 ? (int) rte_lcore_to_socket_id(cpu) : SOCKET_ID_ANY;
+}
+
+// writes the list of the lcores the Tester may use as ranges (e.g. "0-15,32-47") into the buffer
+static void allowedCores(char *list, int size) {
+  int num_cpus = std::min(numa_num_configured_cpus(), RTE_MAX_LCORE);
+  int i, first, len=0;
+
+  list[0] = 0;
+  for ( i=0; i<num_cpus; i++ ) {
+    if ( !numa_bitmask_isbitset(numa_all_cpus_ptr, i) )
+      continue;
+    for ( first=i; i+1<num_cpus && numa_bitmask_isbitset(numa_all_cpus_ptr, i+1); i++ )
+      ;
+    if ( len+25 > size )
+      break; // no more room, the remaining lcores are not used
+    len += snprintf(list+len, size-len, first == i ? "%s%d" : "%s%d-%d", len ? "," : "", first, i);
+  }
+}
+
 int Throughput::init(const char *argv0, uint16_t leftport, uint16_t rightport) {
-  const char *rte_argv[6]; // parameters for DPDK EAL init, e.g.: {NULL, "-l", "4,5,6,7", "-n", "2", NULL};
-  int rte_argc = static_cast<int>(sizeof(rte_argv) / sizeof(rte_argv[0])) - 1; // argc value for DPDK EAL init
-  struct rte_eth_conf cfg_port;		// for configuring the Ethernet ports
-  struct rte_eth_link link_info;	// for retrieving link info by rte_eth_link_get()
-  int trials; 	// cycle variable for port state checking
+  const char *rte_argv[7]; // parameters for DPDK EAL init, e.g.: {NULL, "-l", "4,5,6,7", "-n", "2", NULL};
+  int rte_argc = 5; // argc value for DPDK EAL init, "--no-pci" may be added
 
   // prepare 'command line' arguments for rte_eal_init
   rte_argv[0]=argv0; 	// program name
   rte_argv[1]="-l";	// list of lcores will follow
   // Only lcores for the active directions are to be included (at least one of them MUST be non-zero)
-  if ( forward && reverse ) {
+  // With automatic placement, all lcores are included, because the NUMA nodes of the ports are known only after rte_eal_init()
+  if ( cpu_auto ) {
+    allowedCores(coresList, 101);
+  } else if ( core_consol ) {
+    // the receivers use the lcores of the senders
+    snprintf(coresList, 101, "0,%d", forward ? cpu_left_sender : cpu_right_sender);
+    if ( forward && reverse && cpu_right_sender != cpu_left_sender )
+      snprintf(coresList+strlen(coresList), 101-strlen(coresList), ",%d", cpu_right_sender);
+  } else if ( forward && reverse ) {
     // both directions are active 
     snprintf(coresList, 101, "0,%d,%d,%d,%d", cpu_left_sender, cpu_right_receiver, cpu_right_sender, cpu_left_receiver);
   } else if ( forward )
     snprintf(coresList, 101, "0,%d,%d", cpu_left_sender, cpu_right_receiver); // only forward (left to right) is active 
   else 
     snprintf(coresList, 101, "0,%d,%d", cpu_right_sender, cpu_left_receiver); // only reverse (right to left) is active
+  if ( cpu_ref_dut >= 0 && !cpu_auto )
+    snprintf(coresList+strlen(coresList), 101-strlen(coresList), ",%d", cpu_ref_dut);
+  for ( int k=1; k<num_pairs; k++ ) {
+    if ( pair[k]->forward )
+      snprintf(coresList+strlen(coresList), 101-strlen(coresList), ",%d,%d", pair[k]->cpu_left_sender, pair[k]->cpu_right_receiver);
+    if ( pair[k]->reverse )
+      snprintf(coresList+strlen(coresList), 101-strlen(coresList), ",%d,%d", pair[k]->cpu_right_sender, pair[k]->cpu_left_receiver);
+  }
   rte_argv[2]=coresList;
   rte_argv[3]="-n";
   snprintf(numChannels, 11, "%hhu", memory_channels);
   rte_argv[4]=numChannels;
-  rte_argv[5]=0;
+  if ( cpu_ref_dut >= 0 || ring_loopback )
+    rte_argv[rte_argc++]="--no-pci"; // the Tester (and the reference DUT) use net_ring ports only
+  rte_argv[rte_argc]=0;
 
   if ( rte_eal_init(rte_argc, const_cast<char **>(rte_argv)) < 0 ) {
     std::cerr << "Error: DPDK RTE initialization failed, Tester exits." << std::endl;
     return -1;
   }
 
+  if ( live_page_name[0] && !(live = createLivePage(live_page_name)) ) {
+    std::cerr << "Error: Cannot create the live counters page, Tester exits." << std::endl;
+    return -1;
+  }
+
+  if ( cpu_ref_dut >= 0 && initRefDut(leftport, rightport) < 0 )
+    return -1;
+
+  if ( ring_loopback ) {
+    uint16_t left, right; // port IDs of the net_ring ports
+    if ( createLoopbackPorts(rte_socket_id(), &left, &right) < 0 || left != leftport || right != rightport ) {
+      std::cerr << "Error: Cannot create the net_ring loopback ports as port #" << leftport << " and #" << rightport << ", Tester exits." << std::endl;
+      return -1;
+    }
+  }
+
+  if ( initPorts(leftport, rightport) < 0 )
+    return -1;
+  // the further port pairs use the next port IDs
+  for ( int k=1; k<num_pairs; k++ )
+    if ( pair[k]->initPorts(leftport+2*k, rightport+2*k) < 0 )
+      return -1;
+
+  // prepare further values for testing
+  hz = rte_get_timer_hz();		// number of clock cycles per second
+  for ( int k=1; k<num_pairs; k++ )
+    pair[k]->hz = hz;
+  setStartTime();
+  reportMemory();
+  return 0;
+}
+
+// checks, configures and starts the ports of a port pair, and creates their packet pools
+int Throughput::initPorts(uint16_t leftport, uint16_t rightport) {
+  struct rte_eth_conf cfg_port;		// for configuring the Ethernet ports
+  char name[RTE_MEMPOOL_NAMESIZE];	// name of a packet pool
+
   if ( !rte_eth_dev_is_valid_port(leftport) ) {
     std::cerr << "Error: Network port #" << leftport << " provided as Left Port is not available, Tester exits." << std::endl;
     return -1;
@@ -354,6 +900,9 @@ int Throughput::init(const char *argv0, uint16_t leftport, uint16_t rightport) {
     return -1;
   }
 
+  if ( cpu_auto && placeLcores(leftport, rightport) < 0 )
+    return -1;
+
   // prepare for configuring the Ethernet ports
   memset(&cfg_port, 0, sizeof(cfg_port)); 	// e.g. no CRC generation offloading, etc. (May be improved later!)
   cfg_port.txmode.mq_mode = ETH_MQ_TX_NONE;	// no multi queues 
@@ -371,36 +920,37 @@ int Throughput::init(const char *argv0, uint16_t leftport, uint16_t rightport) {
 
   // Important remark: with no regard whether actual test will be performed in the forward or reverese direcetion, 
   // all TX and RX queues MUST be set up properly, otherwise rte_eth_dev_start() will cause segmentation fault.
-  // Sender pool size calculation uses 0 instead of num_{left,right}_nets, when no actual frame sending is needed. 
 
   // calculate packet pool sizes and then create the pools
+  // The receivers use the default data room, as foreign frames may be as long as ETHER_MAX_LEN, and many NICs use RX buffers
+  // in 1kB units. The receivers on the same NUMA node share a pool, in which each of them has its own cache.
   int receiver_pool_size = PORT_RX_QUEUE_SIZE + 2 * MAX_PKT_BURST + 100; // While one of them is processed, the other one is being filled. 
+  int left_socket = lcoreSocket(cpu_left_receiver), right_socket = lcoreSocket(cpu_right_receiver);
 
-  pkt_pool_left_sender = rte_pktmbuf_pool_create ( "pp_left_sender", senderPoolSize(forward ? num_right_nets: 0 ), PKTPOOL_CACHE, 0, 
-                                                   RTE_MBUF_DEFAULT_BUF_SIZE, rte_lcore_to_socket_id(cpu_left_sender));
-  if ( !pkt_pool_left_sender ) {
-    std::cerr << "Error: Cannot create packet pool for Left Sender, Tester exits." << std::endl;
-    return -1;
-  }
-  pkt_pool_right_receiver = rte_pktmbuf_pool_create ( "pp_right_receiver", receiver_pool_size, PKTPOOL_CACHE, 0, 
-                                                      RTE_MBUF_DEFAULT_BUF_SIZE, rte_lcore_to_socket_id(cpu_right_receiver));
-  if ( !pkt_pool_right_receiver ) {
-    std::cerr << "Error: Cannot create packet pool for Right Receiver, Tester exits." << std::endl;
-    return -1;
-  }
+  if ( left_socket == right_socket || left_socket == SOCKET_ID_ANY || right_socket == SOCKET_ID_ANY ) {
+    pkt_pool_left_receiver = pkt_pool_right_receiver = rte_pktmbuf_pool_create ( poolName(name, "pp_receivers"), 2*(receiver_pool_size + RX_POOL_CACHE*3/2),
+                                                          RX_POOL_CACHE, 0, RTE_MBUF_DEFAULT_BUF_SIZE, left_socket != SOCKET_ID_ANY ? left_socket : right_socket);
+    if ( !pkt_pool_left_receiver ) {
+      std::cerr << "Error: Cannot create packet pool for the Receivers, Tester exits." << std::endl;
+      return -1;
+    }
+  } else {
+    pkt_pool_right_receiver = rte_pktmbuf_pool_create ( poolName(name, "pp_right_receiver"), receiver_pool_size + RX_POOL_CACHE*3/2, RX_POOL_CACHE, 0, 
+                                                        RTE_MBUF_DEFAULT_BUF_SIZE, right_socket);
+    if ( !pkt_pool_right_receiver ) {
+      std::cerr << "Error: Cannot create packet pool for Right Receiver, Tester exits." << std::endl;
+      return -1;
+    }
 
-  pkt_pool_right_sender = rte_pktmbuf_pool_create ( "pp_right_sender", senderPoolSize(reverse ? num_left_nets : 0), PKTPOOL_CACHE, 0,
-                                                    RTE_MBUF_DEFAULT_BUF_SIZE, rte_lcore_to_socket_id(cpu_right_sender));
-  if ( !pkt_pool_right_sender ) {
-    std::cerr << "Error: Cannot create packet pool for Right Sender, Tester exits." << std::endl;
-    return -1;
+    pkt_pool_left_receiver = rte_pktmbuf_pool_create ( poolName(name, "pp_left_receiver"), receiver_pool_size + RX_POOL_CACHE*3/2, RX_POOL_CACHE, 0,
+                                                       RTE_MBUF_DEFAULT_BUF_SIZE, left_socket);
+    if ( !pkt_pool_left_receiver ) {
+      std::cerr << "Error: Cannot create packet pool for Left Receiver, Tester exits." << std::endl;
+      return -1;
+    }
   }
-  pkt_pool_left_receiver = rte_pktmbuf_pool_create ( "pp_left_receiver", receiver_pool_size, PKTPOOL_CACHE, 0,
-                                                     RTE_MBUF_DEFAULT_BUF_SIZE, rte_lcore_to_socket_id(cpu_left_receiver));
-  if ( !pkt_pool_left_receiver ) {
-    std::cerr << "Error: Cannot create packet pool for Left Receiver, Tester exits." << std::endl;
+  if ( createSenderPools() < 0 )
     return -1;
-  }
 
   // set up the TX/RX queues 
   if ( rte_eth_tx_queue_setup(leftport, 0, PORT_TX_QUEUE_SIZE, rte_eth_dev_socket_id(leftport), NULL) < 0) {
@@ -435,23 +985,12 @@ int Throughput::init(const char *argv0, uint16_t leftport, uint16_t rightport) {
     rte_eth_promiscuous_enable(rightport);
   }
 
-  // check links' states (wait for coming up), try maximum MAX_PORT_TRIALS times
-  trials=0;
-  do {
-    if ( trials++ == MAX_PORT_TRIALS ) { 
-      std::cerr << "Error: Left Ethernet port is DOWN, Tester exits." << std::endl;
-      return -1;
-    }
-  rte_eth_link_get(leftport, &link_info);
-  } while ( link_info.link_status == ETH_LINK_DOWN );
-  trials=0;
-  do {
-    if ( trials++ == MAX_PORT_TRIALS ) {
-      std::cerr << "Error: Right Ethernet port is DOWN, Tester exits." << std::endl;
-      return -1;
-    }
-  rte_eth_link_get(rightport, &link_info);
-  } while ( link_info.link_status == ETH_LINK_DOWN );
+  // prepare for taking the statistics of the ports before and after each test
+  left_port_stats = new portStats(leftport, left_name);
+  right_port_stats = new portStats(rightport, right_name);
+
+  if ( waitLinks(leftport, rightport) < 0 )
+    return -1;
 
   // Some sanity checks: NUMA node of the cores and of the NICs are matching or not...
   if ( numa_available() == -1 )
@@ -461,15 +1000,16 @@ int Throughput::init(const char *argv0, uint16_t leftport, uint16_t rightport) {
       std::cout << "Info: Only a single NUMA node is configured, there is no possibilty for mismatch." << std::endl;
     else {
       if ( forward ) {
-        numaCheck(leftport, "Left", cpu_left_sender, "Left Sender");
-        numaCheck(rightport, "Right", cpu_right_receiver, "Right Receiver");
+        numaCheck(leftport, left_name, cpu_left_sender, "Left Sender");
+        numaCheck(rightport, right_name, cpu_right_receiver, "Right Receiver");
       }
       if ( reverse ) {
-        numaCheck(rightport, "Right", cpu_right_sender, "Right Sender");
-        numaCheck(leftport, "Left", cpu_left_receiver, "Left Receiver");
+        numaCheck(rightport, right_name, cpu_right_sender, "Right Sender");
+        numaCheck(leftport, left_name, cpu_left_receiver, "Left Receiver");
       }
     }
   }
+  smtCheck();
 
   // Some sanity checks: TSCs of the used cores are synchronized or not...
   if ( forward ) {
@@ -480,17 +1020,139 @@ int Throughput::init(const char *argv0, uint16_t leftport, uint16_t rightport) {
     check_tsc(cpu_right_sender, "Right Sender");
     check_tsc(cpu_left_receiver, "Left Receiver");
   }
+  return 0;
+}
 
-  // prepare further values for testing
-  hz = rte_get_timer_hz();		// number of clock cycles per second
+// creates the packet pools of the senders, their sizes depend on the type of the measurement
+// Sender pool size calculation uses 0 instead of num_{left,right}_nets, when no actual frame sending is needed.
+// The data room of the mbufs fits the longest frame of the test (the IPv6 frames are the longest ones).
+int Throughput::createSenderPools() {
+  uint16_t data_room = RTE_PKTMBUF_HEADROOM + ipv6_frame_size;
+  char name[RTE_MEMPOOL_NAMESIZE];	// name of a packet pool
+
+  pkt_pool_left_sender = rte_pktmbuf_pool_create ( poolName(name, "pp_left_sender"), senderPoolSize(forward ? num_right_nets: 0 ), PKTPOOL_CACHE, 0, 
+                                                   data_room, lcoreSocket(cpu_left_sender));
+  if ( !pkt_pool_left_sender ) {
+    std::cerr << "Error: Cannot create packet pool for Left Sender, Tester exits." << std::endl;
+    return -1;
+  }
+  pkt_pool_right_sender = rte_pktmbuf_pool_create ( poolName(name, "pp_right_sender"), senderPoolSize(reverse ? num_left_nets : 0), PKTPOOL_CACHE, 0,
+                                                    data_room, lcoreSocket(cpu_right_sender));
+  if ( !pkt_pool_right_sender ) {
+    std::cerr << "Error: Cannot create packet pool for Right Sender, Tester exits." << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// reports the hugepage memory used by the packet pools and needed by the timestamp arrays of the test
+void Throughput::reportMemory() {
+  rte_mempool *pool[5] = { pkt_pool_left_sender, pkt_pool_right_sender, pkt_pool_left_receiver,
+                           pkt_pool_right_receiver != pkt_pool_left_receiver ? pkt_pool_right_receiver : 0, pkt_pool_ref_dut };
+  struct rte_malloc_socket_stats stats;	// for the free memory of the DPDK heaps
+  uint64_t pools=0, free_heap=0, timestamps=timestampMemory();
+  int i;
+
+  for ( i=0; i<5; i++ ) {
+    if ( !pool[i] )
+      continue;
+    uint64_t bytes = (uint64_t) pool[i]->size*(pool[i]->header_size+pool[i]->elt_size+pool[i]->trailer_size);
+    printf("Info: Packet pool %s: %u mbufs of %u bytes on NUMA node %d, %.1lf MB\n", pool[i]->name, pool[i]->size,
+           pool[i]->header_size+pool[i]->elt_size+pool[i]->trailer_size, pool[i]->socket_id, bytes/1048576.0);
+    pools += bytes;
+  }
+  for ( i=0; i<RTE_MAX_NUMA_NODES; i++ )
+    if ( rte_malloc_get_socket_stats(i, &stats) == 0 )
+      free_heap += stats.heap_freesz_bytes;
+  printf("Info: Hugepage memory budget: packet pools: %.1lf MB, timestamp arrays: %.1lf MB, total: %.1lf MB (free in the DPDK heaps: %.1lf MB)\n",
+         pools/1048576.0, timestamps/1048576.0, (pools+timestamps)/1048576.0, free_heap/1048576.0);
+}
+
+// calculates the memory needed for the timestamp arrays, it is a virtual member function, redefined in derived classes
+uint64_t Throughput::timestampMemory() {
+  return 0; // no timestamps are used
+}
+
+// checks links' states (wait for coming up), try maximum MAX_PORT_TRIALS times
+int Throughput::waitLinks(uint16_t leftport, uint16_t rightport) {
+  struct rte_eth_link link_info;	// for retrieving link info by rte_eth_link_get()
+  int trials; 	// cycle variable for port state checking
+
+  trials=0;
+  do {
+    if ( trials++ == MAX_PORT_TRIALS ) { 
+      std::cerr << "Error: Left Ethernet port is DOWN, Tester exits." << std::endl;
+      return -1;
+    }
+  rte_eth_link_get(leftport, &link_info);
+  } while ( link_info.link_status == ETH_LINK_DOWN );
+  trials=0;
+  do {
+    if ( trials++ == MAX_PORT_TRIALS ) {
+      std::cerr << "Error: Right Ethernet port is DOWN, Tester exits." << std::endl;
+      return -1;
+    }
+  rte_eth_link_get(rightport, &link_info);
+  } while ( link_info.link_status == ETH_LINK_DOWN );
+
+  return 0;
+}
+
+// the senders start sending START_DELAY milliseconds later, and the receivers stop after duration plus global timeout
+void Throughput::setStartTime() {
   start_tsc = rte_rdtsc()+hz*START_DELAY/1000;	// Each active sender starts sending at this time
   finish_receiving = start_tsc + hz*(duration+global_timeout/1000.0); 	// Each receiver stops at this time
+}
+
+// makes this object ready for a trial in a session initialized by another object (used by the single siitperf binary)
+// everything is taken over from the session, except the name of the program
+void Throughput::adopt(const Throughput &session) {
+  const char *prog = program;
+  *this = session;
+  program = prog;
+}
+
+// prepares a trial of a session: the pools of the senders are recreated with the sizes needed by this type of measurement,
+// because the senders send the same mbufs many times, thus the old pools may contain the same mbuf several times;
+// if frames were sent in the session, then the ports are restarted first to release the mbufs still held in their TX queues
+int Throughput::prepareTrial(uint16_t leftport, uint16_t rightport, int restart) {
+  for ( int k=1; k<num_pairs; k++ )
+    if ( pair[k]->prepareTrial(leftport+2*k, rightport+2*k, restart) < 0 )
+      return -1;
+  if ( restart ) {
+    rte_eth_dev_stop(leftport);
+    rte_eth_dev_stop(rightport);
+  }
+  rte_mempool_free(pkt_pool_left_sender);
+  rte_mempool_free(pkt_pool_right_sender);
+  if ( createSenderPools() < 0 )
+    return -1;
+  // the impairment queues (and the pool of the reference DUT holding their frames) are sized for the frame rate of the trial
+  if ( cpu_ref_dut >= 0 && impQueueSize() != imp_queue_size ) {
+    rte_eth_dev_stop(ref_dut_left_port);
+    rte_eth_dev_stop(ref_dut_right_port);
+    rte_mempool_free(pkt_pool_ref_dut);
+    imp_queue_size = impQueueSize();
+    if ( createRefDutPool() < 0 )
+      return -1;
+  }
+  if ( restart ) {
+    if ( rte_eth_dev_start(leftport) < 0 || rte_eth_dev_start(rightport) < 0 ) {
+      std::cerr << "Error: Cannot restart the network ports, Tester exits." << std::endl;
+      return -1;
+    }
+    if ( waitLinks(leftport, rightport) < 0 )
+      return -1;
+  }
+  setStartTime();
+  reportMemory();
   return 0;
 }
 
 // calculates sender pool size, it is a virtual member function, redefined in derived classes
 int Throughput::senderPoolSize(int num_dest_nets) {
-  return 3*num_dest_nets + PORT_TX_QUEUE_SIZE + 100; // 3*: IPv4, IPv6 fg, IPv6 bg
+  int sizes = size_mix.num_sizes ? size_mix.num_sizes : 1; // number of frame sizes
+  return 3*sizes*num_dest_nets + PORT_TX_QUEUE_SIZE + 100; // 3*: IPv4, IPv6 fg, IPv6 bg
 }
 
 //checks NUMA localty: is the NUMA node of network port and CPU the same?
@@ -505,6 +1167,104 @@ void Throughput::numaCheck(uint16_t port, const char *port_side, int cpu, const
       n_port << ", " << n_cpu << ", respectively." << std::endl; 
 }
 
+// returns an identifier of the physical core of an lcore (its hyperthreads have the same one), or -1 if it is unknown
+static int physicalCore(int cpu) {
+  char filename[100];
+  int package, core;
+  FILE *f;
+
+  snprintf(filename, 100, "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+  if ( !(f = fopen(filename, "r")) )
+    return -1;
+  if ( fscanf(f, "%d", &package) != 1 )
+    package = -1;
+  fclose(f);
+  snprintf(filename, 100, "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+  if ( !(f = fopen(filename, "r")) )
+    return -1;
+  if ( fscanf(f, "%d", &core) != 1 )
+    core = -1;
+  fclose(f);
+  if ( package < 0 || core < 0 )
+    return -1;
+  return package << 16 | core;
+}
+
+// chooses the lcores not set in the config file: physical cores on the NUMA node of the port used by the given sender or receiver
+// are preferred, which are not SMT siblings of the main lcore or of the other data-plane lcores
+int Throughput::placeLcores(uint16_t leftport, uint16_t rightport) {
+  int *cpu[4] = { &cpu_left_sender, &cpu_right_receiver, &cpu_right_sender, &cpu_left_receiver };
+  const char *name[4] = { "Left Sender", "Right Receiver", "Right Sender", "Left Receiver" };
+  uint16_t port[4] = { leftport, rightport, rightport, leftport };
+  int active[4] = { forward, forward, reverse, reverse };
+  int used[RTE_MAX_LCORE] = {}; // 1: the lcore is already used
+  int used_core[RTE_MAX_LCORE];	// physical cores already used
+  int num_used_cores = 0;
+  int i, j, k, lcore, relax;
+
+  used[rte_get_master_lcore()] = 1;
+  used_core[num_used_cores++] = physicalCore(rte_get_master_lcore());
+  if ( cpu_ref_dut >= 0 ) {
+    used[cpu_ref_dut] = 1;
+    used_core[num_used_cores++] = physicalCore(cpu_ref_dut);
+  }
+  for ( i=0; i<4; i++ )
+    if ( active[i] && *cpu[i] >= 0 ) {
+      used[*cpu[i]] = 1;
+      used_core[num_used_cores++] = physicalCore(*cpu[i]);
+    }
+  for ( i=0; i<4; i++ ) {
+    if ( !active[i] || *cpu[i] >= 0 )
+      continue;
+    int node = rte_eth_dev_socket_id(port[i]); // SOCKET_ID_ANY, if unknown
+    // relax 0: own physical core on the node of the port, 1: SMT sibling on the node of the port, 2: any free lcore
+    for ( relax=0, lcore=-1; relax<3 && lcore<0; relax++ )
+      for ( j=0; j<RTE_MAX_LCORE && lcore<0; j++ ) {
+        if ( !rte_lcore_is_enabled(j) || used[j] )
+          continue;
+        if ( relax < 2 && node != SOCKET_ID_ANY && (int) rte_lcore_to_socket_id(j) != node )
+          continue;
+        int core = physicalCore(j);
+        for ( k=0; relax == 0 && core >= 0 && k<num_used_cores; k++ )
+          if ( used_core[k] == core )
+            break;
+        if ( relax == 0 && core >= 0 && k < num_used_cores )
+          continue;
+        lcore = j;
+        if ( relax == 1 )
+          std::cout << "Warning: " << name[i] << " shares a physical core with another lcore, as there are not enough free physical cores on NUMA node " << node << "." << std::endl;
+        if ( relax == 2 )
+          std::cout << "Warning: " << name[i] << " runs on a different NUMA node than its port, as there are not enough free lcores on NUMA node " << node << "." << std::endl;
+      }
+    if ( lcore < 0 ) {
+      std::cerr << "Error: No free lcore was found for " << name[i] << ", Tester exits." << std::endl;
+      return -1;
+    }
+    *cpu[i] = lcore;
+    used[lcore] = 1;
+    used_core[num_used_cores++] = physicalCore(lcore);
+    std::cout << "Info: " << name[i] << " is placed on lcore " << lcore << " (NUMA node " << rte_lcore_to_socket_id(lcore) << ")." << std::endl;
+  }
+  return 0;
+}
+
+// checks if any two of the data-plane lcores (and the main lcore) are SMT siblings, which share the resources of a physical core
+void Throughput::smtCheck() {
+  int cpu[6] = { (int) rte_get_master_lcore(), forward ? cpu_left_sender : -1, forward ? cpu_right_receiver : -1,
+                 reverse ? cpu_right_sender : -1, reverse ? cpu_left_receiver : -1, cpu_ref_dut };
+  const char *name[6] = { "Main", "Left Sender", "Right Receiver", "Right Sender", "Left Receiver", "Reference DUT" };
+  int core[6];
+  int i, j;
+
+  for ( i=0; i<6; i++ )
+    core[i] = cpu[i] >= 0 ? physicalCore(cpu[i]) : -1;
+  for ( i=0; i<6; i++ )
+    for ( j=i+1; j<6; j++ )
+      if ( core[i] >= 0 && core[i] == core[j] && cpu[i] != cpu[j] )
+        std::cout << "Warning: " << name[i] << " and " << name[j] << " CPU cores (" << cpu[i] << ", " << cpu[j] <<
+          ") are SMT siblings of the same physical core." << std::endl;
+}
+
 // reports the TSC of the core (in the variable pointed by the input parameter), on which it is running
 int report_tsc(void *par) {
    *(uint64_t *)par = rte_rdtsc();
@@ -525,39 +1285,20 @@ void check_tsc(int cpu, const char *cpu_name) {
     rte_exit(EXIT_FAILURE, "Error: TSC of core #%i for %s is not synchronized with that of the main core!\n", cpu, cpu_name);
 }
 
-// creates an IPv4 Test Frame using several helper functions
+// creates an IPv4 Test Frame from its template (see frame.c)
 struct rte_mbuf *mkTestFrame4(uint16_t length, rte_mempool *pkt_pool, const char *side,
                               const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
                               const uint32_t *src_ip, const uint32_t *dst_ip) {
-  struct rte_mbuf *pkt_mbuf=rte_pktmbuf_alloc(pkt_pool); // message buffer for the Test Frame
-  if ( !pkt_mbuf )
-    rte_exit(EXIT_FAILURE, "Error: %s sender can't allocate a new mbuf for the Test Frame! \n", side);
-  length -=  ETHER_CRC_LEN; // exclude CRC from the frame length
-  pkt_mbuf->pkt_len = pkt_mbuf->data_len = length; // set the length in both places
-  uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbuf, uint8_t *); // Access the Test Frame in the message buffer
-  ether_hdr *eth_hdr = reinterpret_cast<struct ether_hdr *>(pkt); // Ethernet header
-  ipv4_hdr *ip_hdr = reinterpret_cast<ipv4_hdr *>(pkt+sizeof(ether_hdr)); // IPv4 header
-  udp_hdr *udp_hd = reinterpret_cast<udp_hdr *>(pkt+sizeof(ether_hdr)+sizeof(ipv4_hdr)); // UDP header
-  uint8_t *udp_data = reinterpret_cast<uint8_t*>(pkt+sizeof(ether_hdr)+sizeof(ipv4_hdr)+sizeof(udp_hdr)); // UDP data
-
-  mkEthHeader(eth_hdr, dst_mac, src_mac, 0x0800); 	// contains an IPv4 packet
-  int ip_length = length - sizeof(ether_hdr);
-  mkIpv4Header(ip_hdr, ip_length, src_ip, dst_ip); 	// Does not set IPv4 header checksum
-  int udp_length = ip_length - sizeof(ipv4_hdr); 	// No IP Options are used
-  mkUdpHeader(udp_hd, udp_length);			
-  int data_legth = udp_length - sizeof(udp_hdr);
-  mkData(udp_data, data_legth);
-  udp_hd->dgram_cksum = rte_ipv4_udptcp_cksum( ip_hdr, udp_hd ); // UDP checksum is calculated and set
-  ip_hdr->hdr_checksum = rte_ipv4_cksum(ip_hdr);	// IPv4 header checksum is set now
-  return pkt_mbuf;
+  return mkFrame(TEST_FRAME, 4, length, pkt_pool, side, dst_mac, src_mac, src_ip, dst_ip, 0);
 }
 
 // Please refer to RFC 2544 Appendx C.2.6.4 Test Frames for the values to be set in the test frames.
+// The following functions are used to make the templates of the frames (see frame.c).
 
 // creates and Ethernet header
 void mkEthHeader(struct ether_hdr *eth, const struct ether_addr *dst_mac, const struct ether_addr *src_mac, const uint16_t ether_type) {
-  rte_memcpy(&eth->d_addr, dst_mac, sizeof(struct ether_hdr));
-  rte_memcpy(&eth->s_addr, src_mac, sizeof(struct ether_hdr));
+  rte_memcpy(&eth->d_addr, dst_mac, sizeof(struct ether_addr));
+  rte_memcpy(&eth->s_addr, src_mac, sizeof(struct ether_addr));
   eth->ether_type = htons(ether_type);
 }
 
@@ -585,42 +1326,11 @@ void mkUdpHeader(struct udp_hdr *udp, uint16_t length) {
   // UDP checksum is calculated later.
 }
 
-// fills the data field of the Test Frame
-void mkData(uint8_t *data, uint16_t length) {
-  unsigned i;
-  uint8_t identify[8]= { 'I', 'D', 'E', 'N', 'T', 'I', 'F', 'Y' };      // Identification of the Test Frames
-  uint64_t *id=(uint64_t *) identify;
-  *(uint64_t *)data = *id;
-  data += 8;
-  length -= 8;
-  for ( i=0; i<length; i++ )
-    data[i] = i % 256;
-}
-
-// creates an IPv6 Test Frame using several helper functions
+// creates an IPv6 Test Frame from its template (see frame.c)
 struct rte_mbuf *mkTestFrame6(uint16_t length, rte_mempool *pkt_pool, const char *side,
                               const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
                               const struct in6_addr *src_ip, const struct in6_addr *dst_ip) {
-  struct rte_mbuf *pkt_mbuf=rte_pktmbuf_alloc(pkt_pool); // message buffer for the Test Frame
-  if ( !pkt_mbuf )
-    rte_exit(EXIT_FAILURE, "Error: %s sender can't allocate a new mbuf for the Test Frame! \n", side);
-  length -=  ETHER_CRC_LEN; // exclude CRC from the frame length
-  pkt_mbuf->pkt_len = pkt_mbuf->data_len = length; // set the length in both places
-  uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbuf, uint8_t *); // Access the Test Frame in the message buffer
-  ether_hdr *eth_hdr = reinterpret_cast<struct ether_hdr *>(pkt); // Ethernet header
-  ipv6_hdr *ip_hdr = reinterpret_cast<ipv6_hdr *>(pkt+sizeof(ether_hdr)); // IPv6 header
-  udp_hdr *udp_hd = reinterpret_cast<udp_hdr *>(pkt+sizeof(ether_hdr)+sizeof(ipv6_hdr)); // UDP header
-  uint8_t *udp_data = reinterpret_cast<uint8_t*>(pkt+sizeof(ether_hdr)+sizeof(ipv6_hdr)+sizeof(udp_hdr)); // UDP data
-
-  mkEthHeader(eth_hdr, dst_mac, src_mac, 0x86DD); // contains an IPv6 packet
-  int ip_length = length - sizeof(ether_hdr);
-  mkIpv6Header(ip_hdr, ip_length, src_ip, dst_ip); 
-  int udp_length = ip_length - sizeof(ipv6_hdr); // No IP Options are used
-  mkUdpHeader(udp_hd, udp_length);
-  int data_legth = udp_length - sizeof(udp_hdr);
-  mkData(udp_data, data_legth);
-  udp_hd->dgram_cksum = rte_ipv6_udptcp_cksum( ip_hdr, udp_hd ); // UDP checksum is calculated and set
-  return pkt_mbuf;
+  return mkFrame(TEST_FRAME, 6, length, pkt_pool, side, dst_mac, src_mac, src_ip, dst_ip, 0);
 }
 
 // creates and IPv6 header
@@ -635,163 +1345,297 @@ void mkIpv6Header(struct ipv6_hdr *ip, uint16_t length, const struct in6_addr *s
 
 // sends Test Frames for throughput (or frame loss rate) measurements
 int send(void *par) {
-  // collecting input parameters:
   class senderParameters *p = (class senderParameters *)par;
-  class senderCommonParameters *cp = p->cp;
-
-  // parameters directly correspond to the data members of class Throughput
-  uint16_t ipv6_frame_size = cp->ipv6_frame_size;
-  uint16_t ipv4_frame_size = cp->ipv4_frame_size;
-  uint32_t frame_rate = cp->frame_rate;
-  uint16_t duration = cp->duration;
-  uint32_t n = cp->n;
-  uint32_t m = cp->m;
-  uint64_t hz = cp->hz;
-  uint64_t start_tsc = cp->start_tsc;
-
-  // parameters which are different for the Left sender and the Right sender
-  int ip_version = p->ip_version;
-  rte_mempool *pkt_pool = p->pkt_pool;
-  uint8_t eth_id = p->eth_id;
-  const char *side = p->side;
-  struct ether_addr *dst_mac = p->dst_mac;
-  struct ether_addr *src_mac = p->src_mac;
-  uint16_t num_dest_nets = p->num_dest_nets;
-  uint32_t *src_ipv4 = p->src_ipv4;
-  uint32_t *dst_ipv4 = p->dst_ipv4;
-  struct in6_addr *src_ipv6 = p->src_ipv6;
-  struct in6_addr *dst_ipv6 = p->dst_ipv6;
-  struct in6_addr *src_bg= p->src_bg;
-  struct in6_addr *dst_bg = p->dst_bg;
-
-  // further local variables
-  uint64_t frames_to_send = duration * frame_rate;	// Each active sender sends this number of frames
-  uint64_t sent_frames=0; // counts the number of sent frames
-  double elapsed_seconds; // for checking the elapsed seconds during sending
-
-  if ( num_dest_nets== 1 ) { 	
-    // optimized code for single flow: always the same foreground or background frame is sent, no arrays are used
-    struct rte_mbuf *fg_pkt_mbuf, *bg_pkt_mbuf; // message buffers for fg. and bg. Test Frames
-    // create foreground Test Frame
-    if ( ip_version == 4 )
-      fg_pkt_mbuf = mkTestFrame4(ipv4_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv4, dst_ipv4);
-    else  // IPv6
-      fg_pkt_mbuf = mkTestFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv6, dst_ipv6);
-
-    // create backround Test Frame (always IPv6)
-    bg_pkt_mbuf = mkTestFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_bg, dst_bg);
-
-    // naive sender version: it is simple and fast
-    for ( sent_frames = 0; sent_frames < frames_to_send; sent_frames++ ){ // Main cycle for the number of frames to send
-      while ( rte_rdtsc() < start_tsc+sent_frames*hz/frame_rate ); // Beware: an "empty" loop, and further two will come!
-      if ( sent_frames % n  < m )
-        while ( !rte_eth_tx_burst(eth_id, 0, &fg_pkt_mbuf, 1) ); // send foreground frame
-      else
-         while ( !rte_eth_tx_burst(eth_id, 0, &bg_pkt_mbuf, 1) ); // send background frame
-    } // this is the end of the sending cycle
-  } // end of optimized code for single flow
-  else {
-    // optimized code for multiple flows: foreground and background frames are generated for each flow and pointers are stored in arrays
-    // num_dest_nets <= 256 
-    struct rte_mbuf *fg_pkt_mbuf[256], *bg_pkt_mbuf[256]; // message buffers for fg. and bg. Test Frames
-    uint32_t curr_dst_ipv4; 	// IPv4 destination address, which will be changed
-    in6_addr curr_dst_ipv6; 	// foreground IPv6 destination address, which will be changed
-    in6_addr curr_dst_bg; 	// backround IPv6 destination address, which will be changed
-    int i; 			// cycle variable for grenerating different destination network addresses
-    if ( ip_version == 4 )
-      curr_dst_ipv4 = *dst_ipv4;
-    else // IPv6
-      curr_dst_ipv6 = *dst_ipv6;
-    curr_dst_bg = *dst_bg;
-
-    for ( i=0; i<num_dest_nets; i++ ) { 
-      // create foreground Test Frame
-      if ( ip_version == 4 ) {
-        ((uint8_t *)&curr_dst_ipv4)[2] = (uint8_t) i; // bits 16 to 23 of the IPv4 address are rewritten, like in 198.18.x.2
-        fg_pkt_mbuf[i] = mkTestFrame4(ipv4_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv4, &curr_dst_ipv4);
-      }
-      else { // IPv6
-        ((uint8_t *)&curr_dst_ipv6)[7] = (uint8_t) i; // bits 56 to 63 of the IPv6 address are rewritten, like in 2001:2:0:00xx::1
-        fg_pkt_mbuf[i] = mkTestFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_ipv6, &curr_dst_ipv6);
-      } 
-      // create backround Test Frame (always IPv6)
-      ((uint8_t *)&curr_dst_bg)[7] = (uint8_t) i; // see comment above
-      bg_pkt_mbuf[i] = mkTestFrame6(ipv6_frame_size, pkt_pool, side, dst_mac, src_mac, src_bg, &curr_dst_bg);
-    }
- 
-    // random number infrastructure is taken from: https://en.cppreference.com/w/cpp/numeric/random/uniform_int_distribution
-    // MT64 is used because of https://medium.com/@odarbelaeze/how-competitive-are-c-standard-random-number-generators-f3de98d973f0
-    // thread_local is used on the basis of https://stackoverflow.com/questions/40655814/is-mersenne-twister-thread-safe-for-cpp
-    thread_local std::random_device rd;  // Will be used to obtain a seed for the random number engine
-    thread_local std::mt19937_64 gen(rd()); // Standard 64-bit mersenne_twister_engine seeded with rd()
-    std::uniform_int_distribution<int> uni_dis(0, num_dest_nets-1);	// uniform distribution in [0, num_dest_nets-1]
-
-    // naive sender version: it is simple and fast
-    for ( sent_frames = 0; sent_frames < frames_to_send; sent_frames++ ){ // Main cycle for the number of frames to send
-      int index = uni_dis(gen);	// index of the pre-generated frame
-      while ( rte_rdtsc() < start_tsc+sent_frames*hz/frame_rate ); // Beware: an "empty" loop, and further two will come!
-      if ( sent_frames % n  < m )
-        while ( !rte_eth_tx_burst(eth_id, 0, &fg_pkt_mbuf[index], 1) ); // send foreground frame
-      else
-         while ( !rte_eth_tx_burst(eth_id, 0, &bg_pkt_mbuf[index], 1) ); // send background frame
-    } // this is the end of the sending cycle
-  } // end of optimized code for multiple flows
-
-  // Now, we check the time
-  elapsed_seconds = (double)(rte_rdtsc()-start_tsc)/hz;
-  printf("Info: %s sender's sending took %3.10lf seconds.\n", side, elapsed_seconds);
-  if ( elapsed_seconds > duration*TOLERANCE )
-    rte_exit(EXIT_FAILURE, "%s sending exceeded the %3.10lf seconds limit, the test is invalid.\n", side, duration*TOLERANCE);
-  printf("%s frames sent: %lu\n", side, sent_frames);
+  noStamp stamper; // Test Frames are sent as they are
 
+  sendFrames(p, p->frames, &stamper);
   return 0;
 }
 
+// counts the Test Frames among the received frames, and frees all of them; the Test Frames are also counted per size class,
+// if there is a frame size mix (size_class gives the index of the size class of each IPv6 frame size)
+// the offsets of the fields are taken from the frame layouts (see frame.h)
+// return: the number of Test Frames
+static inline int countTestFrames(struct rte_mbuf **pkt_mbufs, int frames, const sizeMix *mix, const uint8_t *size_class,
+                                  uint64_t *received_sizes) {
+  uint16_t ipv4=htons(0x0800); // EtherType for IPv4 in Network Byte Order
+  uint16_t ipv6=htons(0x86DD); // EtherType for IPv6 in Network Byte Order
+  uint8_t identify[8]= { 'I', 'D', 'E', 'N', 'T', 'I', 'F', 'Y' };	// Identificion of the Test Frames
+  uint64_t *id=(uint64_t *) identify;
+  int received=0;
+
+  for ( int i=0; i < frames; i++ ) {
+    uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbufs[i], uint8_t *); // Access the Test Frame in the message buffer
+    // check EtherType at offset 12: IPv6, IPv4, or anything else
+    if ( *(uint16_t *)&pkt[layout6.ether_type]==ipv6 ) { /* IPv6  */
+      /* check if IPv6 Next Header is UDP, and the first 8 bytes of UDP data is 'IDENTIFY' */
+      if ( likely( pkt[layout6.proto]==17 && *(uint64_t *)&pkt[layout6.data]==*id ) ) {
+        received++;
+        if ( mix ) {
+          uint16_t size = frameSize6(pkt);
+          received_sizes[size <= MAX_FRAME_SIZE ? size_class[size] : mix->num_sizes]++;
+        }
+      }
+    } else if ( *(uint16_t *)&pkt[layout4.ether_type]==ipv4 ) { /* IPv4 */
+      if ( likely( pkt[layout4.proto]==17 && *(uint64_t *)&pkt[layout4.data]==*id ) ) {
+        received++;
+        if ( mix ) {
+          uint16_t size = frameSize4(pkt)+20; // the size class is given by the IPv6 frame size
+          received_sizes[size <= MAX_FRAME_SIZE ? size_class[size] : mix->num_sizes]++;
+        }
+      }
+    }
+    rte_pktmbuf_free(pkt_mbufs[i]);
+  }
+  return received;
+}
+
 // receives Test Frames for throughput (or frame loss rate) measurements
-// Offsets from the start of the Ethernet Frame:
-// EtherType: 6+6=12
-// IPv6 Next header: 14+6=20, UDP Data for IPv6: 14+40+8=62
-// IPv4 Protolcol: 14+9=23, UDP Data for IPv4: 14+20+8=42
 int receive(void *par) {
   // collecting input parameters:
   class receiverParameters *p = (class receiverParameters *)par;
   uint64_t finish_receiving = p->finish_receiving;
   uint8_t eth_id = p->eth_id;
   const char *side = p->side;
+  uint64_t start_tsc = p->start_tsc;
+  uint64_t frames_to_send = p->frames_to_send;
 
   // further local variables
   int frames, i;
   struct rte_mbuf *pkt_mbufs[MAX_PKT_BURST]; // pointers for the mbufs of received frames
-  uint16_t ipv4=htons(0x0800); // EtherType for IPv4 in Network Byte Order
-  uint16_t ipv6=htons(0x86DD); // EtherType for IPv6 in Network Byte Order
-  uint8_t identify[8]= { 'I', 'D', 'E', 'N', 'T', 'I', 'F', 'Y' };	// Identificion of the Test Frames
-  uint64_t *id=(uint64_t *) identify;
+  INSTR( lcoreInstruments ins; ) // data-plane instrumentation (if compiled in)
+  uint64_t all_frames=0; // number of all frames received, the ones not matching the test signature are counted as foreign traffic
   uint64_t received=0; 	// number of received frames
+  uint64_t now;		// current TSC value
+
+  // frame size mix: the frames are counted per size class, the index of the size class of each IPv6 frame size is looked up,
+  // unknown sizes are counted at index num_sizes
+  const sizeMix *mix = p->mix;
+  uint8_t size_class[MAX_FRAME_SIZE+1];
+  uint64_t received_sizes[MAX_SIZE_CLASSES+1] = { 0 };
+  if ( mix ) {
+    memset(size_class, mix->num_sizes, sizeof(size_class));
+    for ( i=0; i<mix->num_sizes; i++ )
+      size_class[mix->ipv6_size[i]] = i;
+  }
 
-  while ( rte_rdtsc() < finish_receiving ){
-    frames = rte_eth_rx_burst(eth_id, 0, pkt_mbufs, MAX_PKT_BURST);
-    for (i=0; i < frames; i++){
-      uint8_t *pkt = rte_pktmbuf_mtod(pkt_mbufs[i], uint8_t *); // Access the Test Frame in the message buffer
-      // check EtherType at offset 12: IPv6, IPv4, or anything else
-      if ( *(uint16_t *)&pkt[12]==ipv6 ) { /* IPv6  */
-        /* check if IPv6 Next Header is UDP, and the first 8 bytes of UDP data is 'IDENTIFY' */
-        if ( likely( pkt[20]==17 && *(uint64_t *)&pkt[62]==*id ) )
-          received++;
-      } else if ( *(uint16_t *)&pkt[12]==ipv4 ) { /* IPv4 */
-        if ( likely( pkt[23]==17 && *(uint64_t *)&pkt[42]==*id ) )
-           received++;
-      }
-      rte_pktmbuf_free(pkt_mbufs[i]);
+  // rate profile: the number of frames received until the end of each segment is recorded (the frames received after the end of
+  // the last segment are counted in the last one)
+  const rateProfile *profile = p->profile;
+  uint64_t *segment_received = profile ? new uint64_t[profile->num_segments] : 0;
+  int segment = 0;	// the current segment
+  uint64_t segment_end = profile && profile->num_segments > 1 ? start_tsc+rte_get_tsc_hz()*profile->segments[0].end_ms/1000 : ~0ULL;
+
+  // timeline: a snapshot is published at the end of every interval (never, if no timeline)
+  timelineRing *timeline = p->timeline;
+  uint64_t timeline_tsc = p->timeline_tsc;
+  uint64_t next_snapshot = timeline ? start_tsc+timeline_tsc : ~0ULL;
+
+  // live counters: they are published to the live page (or to a private dummy, if there is no live page) after every burst
+  liveCounters dummy_counters, *live = p->live ? p->live : &dummy_counters;
+
+  while ( (now=rte_rdtsc()) < finish_receiving ){
+    while ( unlikely( now >= next_snapshot ) ) {
+      timeline->publish(next_snapshot, received);
+      next_snapshot += timeline_tsc;
     }
+    if ( unlikely( now >= segment_end ) ) {
+      segment_received[segment++] = received;
+      segment_end = segment < profile->num_segments-1 ? start_tsc+rte_get_tsc_hz()*profile->segments[segment].end_ms/1000 : ~0ULL;
+    }
+    INSTR( ins.t0 = rte_rdtsc() );
+    frames = rte_eth_rx_burst(eth_id, 0, pkt_mbufs, MAX_PKT_BURST);
+    INSTR( ins.burst[frames]++ );
+    all_frames += frames;
+    received += countTestFrames(pkt_mbufs, frames, mix, size_class, received_sizes);
+    INSTR( if ( frames ) ins.busy_cycles += rte_rdtsc()-ins.t0 );
+    if ( frames )
+      live->received = received;
   }
+  if ( timeline )
+    timeline->publish(finish_receiving, received); // final snapshot for the last (partial) interval
+  INSTR( reportReceiverInstruments(&ins, side) );
+  printf("Info: %s foreign frames received: %lu\n", side, all_frames-received);
   printf("%s frames received: %lu\n", side, received);
+  p->received = received;
+  if ( mix ) {
+    for ( i=0; i<mix->num_sizes; i++ ) {
+      uint64_t sent = sizeMixCount(mix, i, frames_to_send);
+      printf("%s frame size %u: frames sent: %lu, received: %lu, lost: %ld (%.4lf%%)\n", side, mix->ipv6_size[i], sent, received_sizes[i],
+             (int64_t) (sent-received_sizes[i]), sent ? 100.0*((int64_t) (sent-received_sizes[i]))/sent : 0.0);
+    }
+    if ( received_sizes[mix->num_sizes] )
+      printf("Warning: %s received %lu Test Frames of unexpected size.\n", side, received_sizes[mix->num_sizes]);
+  }
+  if ( profile ) {
+    while ( segment < profile->num_segments )
+      segment_received[segment++] = received;
+    for ( i=0; i<profile->num_segments; i++ ) {
+      const profileSegment *s = &profile->segments[i];
+      uint64_t sent = s->end_frame-(i ? profile->segments[i-1].end_frame : 0);
+      uint64_t rec = segment_received[i]-(i ? segment_received[i-1] : 0);
+      printf("%s segment %d (%.3lf-%.3lf s, %u-%u fps): frames sent: %lu, received: %lu, lost: %ld (%.4lf%%)\n", side, i,
+             (i ? profile->segments[i-1].end_ms : 0)/1000.0, s->end_ms/1000.0, s->start_rate, s->end_rate, sent, rec,
+             (int64_t) (sent-rec), sent ? 100.0*((int64_t) (sent-rec))/sent : 0.0);
+    }
+    delete [] segment_received;
+  }
   return received;
 }
 
+// polls the receivers of a consolidated lcore, which have not finished yet, and counts the Test Frames received by them
+static inline void pollReceivers(consolParameters *c, uint64_t now) {
+  struct rte_mbuf *pkt_mbufs[MAX_PKT_BURST]; // pointers for the mbufs of received frames
+
+  if ( now-c->last_poll > c->longest_poll )
+    c->longest_poll = now-c->last_poll;
+  c->last_poll = now;
+  c->polls++;
+  for ( int j=0; j<2; j++ ) {
+    receiverParameters *r = c->rpars[j];
+    if ( !r || now >= r->finish_receiving )
+      continue;
+    int frames = rte_eth_rx_burst(r->eth_id, 0, pkt_mbufs, MAX_PKT_BURST);
+    c->all_frames[j] += frames;
+    r->received += countTestFrames(pkt_mbufs, frames, 0, 0, 0);
+  }
+}
+
+// core consolidation: the frames are sent at their scheduled TSC values (see tscPacing), and the receivers sharing the lcore are
+// polled before every frame, while waiting for its scheduled time, and while the TX queue is full; the lateness of a frame is
+// recorded, when it is actually enqueued
+class consolPacing : public pacerBase {
+  consolParameters *c;	// the receivers of the lcore
+  uint64_t second_tsc;	// beginning of the current second of sending
+  uint32_t frame_in_second;	// index of the current frame within the current second
+  uint64_t hz;		// number of clock cycles per second
+  uint32_t frame_rate;	// number of frames per second
+  uint64_t frame_tsc;	// inter-frame time
+  uint64_t deadline;	// scheduled time of the current frame
+public:
+  consolPacing(senderParameters *p) : pacerBase(p) {
+    senderCommonParameters *cp = p->cp;
+    c = p->consol;
+    second_tsc = cp->start_tsc;
+    frame_in_second = 0;
+    hz = cp->hz;
+    frame_rate = cp->frame_rate;
+    frame_tsc = hz/frame_rate;
+    deadline = 0;
+  }
+  inline void wait(uint64_t sent_frames, int64_t shift) {
+    uint64_t now;
+    deadline = second_tsc+frame_in_second*hz/frame_rate+shift;
+    do
+      pollReceivers(c, now=rte_rdtsc());
+    while ( now < deadline );
+    if ( unlikely( ++frame_in_second == frame_rate ) ) {
+      frame_in_second = 0;
+      second_tsc += hz;
+    }
+  }
+  inline void enqueue(struct rte_mbuf *frame, uint64_t *tx_retries) {
+    uint64_t now = rte_rdtsc();
+    while ( !rte_eth_tx_burst(eth_id, 0, &frame, 1) ) {
+      (*tx_retries)++;
+      pollReceivers(c, now); // the receivers are polled, while the TX queue is full
+      now = rte_rdtsc();
+    }
+    lateness = now > deadline ? now-deadline : 0;
+    stats.record(lateness, frame_tsc);
+  }
+};
+
+// the sending cycle of the senders of a consolidated lcore: Test Frames of a single frame size, the flow selector and the
+// foreground/background scheduler handle all cases (the lcore is used for low frame rates)
+typedef sendingCycle<randomFlow, singleSize, mixedTraffic, noStamp, consolPacing> consolCycle;
+
+// the run-to-completion loop of a consolidated lcore: the senders sharing the lcore use the normal sending cycle with consolPacing,
+// which polls the receivers; the senders have the same schedule, thus their frames are sent alternately
+int sendReceive(void *par) {
+  class consolParameters *c = (class consolParameters *)par;
+  noStamp stamper; // Test Frames are sent as they are
+  liveCounters dummy_counters[2];
+  consolCycle *cycle[2] = { 0, 0 };	// the sending cycles of the Left and Right Sender
+  uint64_t finish_receiving = 0;	// the loop runs until the last receiver finishes
+  uint64_t late_frames = 0;		// catch-up frames of both senders
+  uint64_t now;
+  int i, j;
+
+  for ( i=0; i<2; i++ )
+    if ( c->spars[i] )
+      cycle[i] = new consolCycle(c->spars[i], c->spars[i]->frames, &stamper, &dummy_counters[i]);
+  for ( j=0; j<2; j++ )
+    if ( c->rpars[j] )
+      finish_receiving = std::max(finish_receiving, c->rpars[j]->finish_receiving);
+
+  c->last_poll = rte_rdtsc();
+  while ( (cycle[0] && !cycle[0]->finished()) || (cycle[1] && !cycle[1]->finished()) )
+    for ( i=0; i<2; i++ )
+      if ( cycle[i] && !cycle[i]->finished() )
+        cycle[i]->sendFrame();
+  for ( i=0; i<2; i++ )
+    if ( cycle[i] ) {
+      cycle[i]->finish();
+      late_frames += cycle[i]->pacer.stats.late_frames;
+      delete cycle[i];
+    }
+  while ( (now=rte_rdtsc()) < finish_receiving )
+    pollReceivers(c, now);
+
+  for ( j=0; j<2; j++ ) {
+    receiverParameters *p = c->rpars[j];
+    if ( !p )
+      continue;
+    printf("Info: %s foreign frames received: %lu\n", p->side, c->all_frames[j]-p->received);
+    printf("%s frames received: %lu\n", p->side, p->received);
+  }
+  // the loop kept its schedule, if no frame was enqueued later than its scheduled time plus one inter-frame time
+  printf("Info: Consolidated lcore %d: %lu receiver polls, the longest time between two of them was %.3lf us.\n", c->cpu, c->polls,
+         1e6*c->longest_poll/rte_get_tsc_hz());
+  if ( late_frames )
+    printf("Warning: The loop of consolidated lcore %d fell behind its schedule: %lu catch-up frames, the results may be tester-limited!\n",
+           c->cpu, late_frames);
+  else
+    printf("Info: The loop of consolidated lcore %d kept its schedule.\n", c->cpu);
+  return 0;
+}
+
 // performs throughput (or frame loss rate) measurement
 void Throughput::measure(uint16_t leftport, uint16_t rightport) {
+  timelineRing *left_sent=0, *right_received=0, *right_sent=0, *left_received=0; // timeline rings (if timeline is used)
+  senderParameters *left_spars=0, *right_spars=0; // parameters of the active senders, they must exist until the senders finish
+  receiverParameters *left_rpars=0, *right_rpars=0; // parameters of the active receivers, they must exist until the receivers finish
+
+  if ( num_pairs > 1 ) {
+    measurePairs(leftport, rightport);
+    return;
+  }
+  if ( core_consol ) {
+    measureConsolidated(leftport, rightport);
+    return;
+  }
+
+  startPortStats(); // before anything is sent
+
   // set common parameters for senders
   senderCommonParameters scp(ipv6_frame_size,ipv4_frame_size,frame_rate,duration,n,m,hz,start_tsc);
+  if ( timeline_interval )
+    scp.timeline_tsc = hz*timeline_interval/1000;
+  scp.max_lateness_tsc = hz*max_lateness/1000000;
+  scp.arrival_dist = arrival_dist;
+  scp.arrival_burst = arrival_burst;
+  scp.arrival_peak = arrival_peak;
+  if ( size_mix.num_sizes )
+    scp.mix = &size_mix;
+  if ( rate_profile.num_segments ) {
+    scp.profile = &rate_profile;
+    scp.frames_to_send = rate_profile.segments[rate_profile.num_segments-1].end_frame;
+  }
+  if ( train_length ) {
+    scp.train_length = train_length;
+    scp.frames_to_send = (uint64_t) duration*train_length;
+  }
 
   if ( forward ) {	// Left to right direction is active
     // set individual parameters for the left sender
@@ -801,19 +1645,12 @@ void Throughput::measure(uint16_t leftport, uint16_t rightport) {
                &ipv6_left_real,&ipv6_right_real,&ipv6_left_virtual,&ipv6_right_virtual);
 
     // then, initialize the parameter class instance
-    senderParameters spars(&scp,ip_left_version,pkt_pool_left_sender,leftport,"Forward",(ether_addr *)mac_left_dut,(ether_addr *)mac_left_tester,
-                           ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_left_real,&ipv6_right_real,num_right_nets);
-                            
-    // start left sender
-    if ( rte_eal_remote_launch(send, &spars, cpu_left_sender) )
-      std::cout << "Error: could not start Left Sender." << std::endl;
-
-    // set parameters for the right receiver
-    receiverParameters rpars(finish_receiving,rightport,"Forward");
-
-    // start right receiver
-    if ( rte_eal_remote_launch(receive, &rpars, cpu_right_receiver) )
-      std::cout << "Error: could not start Right Receiver." << std::endl;
+    left_spars = new senderParameters(&scp,ip_left_version,pkt_pool_left_sender,leftport,"Forward",(ether_addr *)mac_left_dut,(ether_addr *)mac_left_tester,
+                                      ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_left_real,&ipv6_right_real,num_right_nets);
+    if ( timeline_interval )
+      left_spars->timeline = left_sent = new timelineRing(rte_lcore_to_socket_id(cpu_left_sender));
+    if ( live )
+      left_spars->live = &live->role[LIVE_LEFT_SENDER];
   }
 
   if ( reverse ) {	// Right to Left direction is active 
@@ -824,23 +1661,89 @@ void Throughput::measure(uint16_t leftport, uint16_t rightport) {
                &ipv6_right_real,&ipv6_left_real,&ipv6_right_virtual,&ipv6_left_virtual);
 
     // then, initialize the parameter class instance
-    senderParameters spars(&scp,ip_right_version,pkt_pool_right_sender,rightport,"Reverse",(ether_addr *)mac_right_dut,(ether_addr *)mac_right_tester,
-                           ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_right_real,&ipv6_left_real,num_left_nets);
+    right_spars = new senderParameters(&scp,ip_right_version,pkt_pool_right_sender,rightport,"Reverse",(ether_addr *)mac_right_dut,(ether_addr *)mac_right_tester,
+                                       ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_right_real,&ipv6_left_real,num_left_nets);
+    if ( timeline_interval )
+      right_spars->timeline = right_sent = new timelineRing(rte_lcore_to_socket_id(cpu_right_sender));
+    if ( live )
+      right_spars->live = &live->role[LIVE_RIGHT_SENDER];
+  }
+
+  // the frames are pre-generated in parallel, and the senders start START_DELAY after it
+  pregenerateFrames(this, left_spars, right_spars, noStamp::copies, mkTestFrame4, mkTestFrame6);
+  setStartTime();
+  scp.start_tsc = start_tsc;
+  startRefDut();
+  startLivePage();
+  if ( hw_pacing && !train_length && !rate_profile.num_segments && arrival_dist == 'P' ) {
+    if ( forward )
+      startHwPacing(left_spars);
+    if ( reverse )
+      startHwPacing(right_spars);
+  }
+
+  if ( forward ) {
+    // start left sender
+    if ( rte_eal_remote_launch(send, left_spars, cpu_left_sender) )
+      std::cout << "Error: could not start Left Sender." << std::endl;
 
+    // set parameters for the right receiver
+    right_rpars = new receiverParameters(finish_receiving,rightport,"Forward");
+    if ( timeline_interval ) {
+      right_rpars->timeline = right_received = new timelineRing(rte_lcore_to_socket_id(cpu_right_receiver));
+      right_rpars->timeline_tsc = scp.timeline_tsc;
+    }
+    if ( live )
+      right_rpars->live = &live->role[LIVE_RIGHT_RECEIVER];
+    right_rpars->mix = scp.mix;
+    right_rpars->frames_to_send = scp.frames_to_send;
+    right_rpars->profile = scp.profile;
+    right_rpars->start_tsc = start_tsc;
+
+    // start right receiver
+    if ( rte_eal_remote_launch(receive, right_rpars, cpu_right_receiver) )
+      std::cout << "Error: could not start Right Receiver." << std::endl;
+  }
+
+  if ( reverse ) {
     // start right sender
-    if (rte_eal_remote_launch(send, &spars, cpu_right_sender) )
+    if (rte_eal_remote_launch(send, right_spars, cpu_right_sender) )
       std::cout << "Error: could not start Right Sender." << std::endl;
 
     // set parameters for the left receiver
-    receiverParameters rpars(finish_receiving,leftport,"Reverse");
+    left_rpars = new receiverParameters(finish_receiving,leftport,"Reverse");
+    if ( timeline_interval ) {
+      left_rpars->timeline = left_received = new timelineRing(rte_lcore_to_socket_id(cpu_left_receiver));
+      left_rpars->timeline_tsc = scp.timeline_tsc;
+    }
+    if ( live )
+      left_rpars->live = &live->role[LIVE_LEFT_RECEIVER];
+    left_rpars->mix = scp.mix;
+    left_rpars->frames_to_send = scp.frames_to_send;
+    left_rpars->profile = scp.profile;
+    left_rpars->start_tsc = start_tsc;
 
     // start left receiver
-    if ( rte_eal_remote_launch(receive, &rpars, cpu_left_receiver) )
+    if ( rte_eal_remote_launch(receive, left_rpars, cpu_left_receiver) )
       std::cout << "Error: could not start Left Receiver." << std::endl;
   }
 
   std::cout << "Info: Testing started." << std::endl;
 
+  // collect the timeline snapshots periodically, while the test is running
+  if ( timeline_interval )
+    while ( lcoresRunning() ) {
+      rte_delay_ms(timeline_interval);
+      if ( forward ) {
+        left_sent->drain();
+        right_received->drain();
+      }
+      if ( reverse ) {
+        right_sent->drain();
+        left_received->drain();
+      }
+    }
+
   // wait until active senders and receivers finish 
   if ( forward ) {
     rte_eal_wait_lcore(cpu_left_sender);
@@ -850,11 +1753,412 @@ void Throughput::measure(uint16_t leftport, uint16_t rightport) {
     rte_eal_wait_lcore(cpu_right_sender);
     rte_eal_wait_lcore(cpu_left_receiver);
   }
+  if ( forward )
+    finishHwPacing(left_spars);
+  if ( reverse )
+    finishHwPacing(right_spars);
+  deleteSenderParameters(left_spars);
+  deleteSenderParameters(right_spars);
+  delete left_rpars;
+  delete right_rpars;
+  finishRefDut();
+  finishPortStats();
+
+  if ( timeline_interval ) {
+    if ( forward )
+      reportTimeline(left_sent, right_received, start_tsc, hz, timeline_interval, "Forward");
+    if ( reverse )
+      reportTimeline(right_sent, left_received, start_tsc, hz, timeline_interval, "Reverse");
+    delete left_sent;
+    delete right_received;
+    delete right_sent;
+    delete left_received;
+  }
+  std::cout << "Info: Test finished." << std::endl;
+}
+
+// measures the throughput with core consolidation: the senders and the receivers are served by run-to-completion loops on the lcores
+// of the senders, one loop for each direction (Core-Consol 1), or a single loop for both directions (Core-Consol 2)
+void Throughput::measureConsolidated(uint16_t leftport, uint16_t rightport) {
+  senderParameters *left_spars=0, *right_spars=0; // parameters of the active senders, they must exist until the senders finish
+
+  startPortStats(); // before anything is sent
+
+  // set common parameters for senders (only periodic sending of a single frame size is supported)
+  senderCommonParameters scp(ipv6_frame_size,ipv4_frame_size,frame_rate,duration,n,m,hz,start_tsc);
+  scp.max_lateness_tsc = hz*max_lateness/1000000;
+
+  if ( forward ) {	// Left to right direction is active
+    ipQuad ipq(ip_left_version,ip_right_version,&ipv4_left_real,&ipv4_right_real,&ipv4_left_virtual,&ipv4_right_virtual,
+               &ipv6_left_real,&ipv6_right_real,&ipv6_left_virtual,&ipv6_right_virtual);
+    left_spars = new senderParameters(&scp,ip_left_version,pkt_pool_left_sender,leftport,"Forward",(ether_addr *)mac_left_dut,(ether_addr *)mac_left_tester,
+                                      ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_left_real,&ipv6_right_real,num_right_nets);
+  }
+  if ( reverse ) {	// Right to Left direction is active
+    ipQuad ipq(ip_right_version,ip_left_version,&ipv4_right_real,&ipv4_left_real,&ipv4_right_virtual,&ipv4_left_virtual,
+               &ipv6_right_real,&ipv6_left_real,&ipv6_right_virtual,&ipv6_left_virtual);
+    right_spars = new senderParameters(&scp,ip_right_version,pkt_pool_right_sender,rightport,"Reverse",(ether_addr *)mac_right_dut,(ether_addr *)mac_right_tester,
+                                       ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,&ipv6_right_real,&ipv6_left_real,num_left_nets);
+  }
+
+  // the frames are pre-generated, and the senders start START_DELAY after it
+  pregenerateFrames(this, left_spars, right_spars, noStamp::copies, mkTestFrame4, mkTestFrame6);
+  setStartTime();
+  scp.start_tsc = start_tsc;
+  startRefDut();
+
+  // assign the senders and the receivers to the loops: the Right Receiver counts the Forward frames, the Left Receiver the Reverse ones
+  receiverParameters right_rpars(finish_receiving,rightport,"Forward"), left_rpars(finish_receiving,leftport,"Reverse");
+  consolParameters left_loop(cpu_left_sender), right_loop(cpu_right_sender);
+  consolParameters *reverse_loop = forward && cpu_right_sender == cpu_left_sender ? &left_loop : &right_loop;
+  if ( forward ) {
+    left_loop.spars[0] = left_spars;
+    left_loop.rpars[0] = &right_rpars;
+    left_spars->consol = &left_loop;
+  }
+  if ( reverse ) {
+    reverse_loop->spars[1] = right_spars;
+    reverse_loop->rpars[1] = &left_rpars;
+    right_spars->consol = reverse_loop;
+  }
+
+  if ( forward && rte_eal_remote_launch(sendReceive, &left_loop, cpu_left_sender) )
+    std::cout << "Error: could not start the loop of consolidated lcore " << cpu_left_sender << "." << std::endl;
+  if ( reverse_loop == &right_loop && rte_eal_remote_launch(sendReceive, &right_loop, cpu_right_sender) )
+    std::cout << "Error: could not start the loop of consolidated lcore " << cpu_right_sender << "." << std::endl;
+
+  std::cout << "Info: Testing started." << std::endl;
+
+  // wait until the loops finish
+  if ( forward )
+    rte_eal_wait_lcore(cpu_left_sender);
+  if ( reverse_loop == &right_loop )
+    rte_eal_wait_lcore(cpu_right_sender);
+  deleteSenderParameters(left_spars);
+  deleteSenderParameters(right_spars);
+  finishRefDut();
+  finishPortStats();
+  std::cout << "Info: Test finished." << std::endl;
+}
+
+// measures the throughput of all port pairs in parallel: each pair has its own senders and receivers, but they have a common start time
+// the results are reported per pair, and their sums are reported as the "Forward/Reverse frames sent/received" lines
+void Throughput::measurePairs(uint16_t leftport, uint16_t rightport) {
+  Throughput *t[MAX_PORT_PAIRS];	// the port pairs
+  senderCommonParameters *scp[MAX_PORT_PAIRS];	// common parameters of the senders of each pair
+  senderParameters *left_spars[MAX_PORT_PAIRS], *right_spars[MAX_PORT_PAIRS]; // parameters of the active senders
+  receiverParameters *left_rpars[MAX_PORT_PAIRS], *right_rpars[MAX_PORT_PAIRS]; // parameters of the active receivers
+  char fwd_side[MAX_PORT_PAIRS][16], rev_side[MAX_PORT_PAIRS][16]; // "Forward" and "Reverse" followed by the index of the pair
+  uint64_t fwd_sent=0, fwd_received=0, rev_sent=0, rev_received=0; // sums for all port pairs
+  int any_fwd=0, any_rev=0;	// the direction is active in any of the port pairs
+  int k;
+
+  for ( k=0; k<num_pairs; k++ ) {
+    Throughput *p = t[k] = k ? pair[k] : this;
+    uint16_t left = leftport+2*k, right = rightport+2*k; // port IDs of the pair
+
+    p->startPortStats(); // before anything is sent
+    left_spars[k] = right_spars[k] = 0;
+    left_rpars[k] = right_rpars[k] = 0;
+    snprintf(fwd_side[k], 16, "Forward %d", k);
+    snprintf(rev_side[k], 16, "Reverse %d", k);
+
+    // set common parameters for the senders of the pair
+    scp[k] = new senderCommonParameters(p->ipv6_frame_size,p->ipv4_frame_size,p->frame_rate,p->duration,p->n,p->m,hz,start_tsc);
+    scp[k]->max_lateness_tsc = hz*p->max_lateness/1000000;
+    scp[k]->arrival_dist = p->arrival_dist;
+    scp[k]->arrival_burst = p->arrival_burst;
+    scp[k]->arrival_peak = p->arrival_peak;
+    if ( p->size_mix.num_sizes )
+      scp[k]->mix = &p->size_mix;
+    if ( p->rate_profile.num_segments ) {
+      scp[k]->profile = &p->rate_profile;
+      scp[k]->frames_to_send = p->rate_profile.segments[p->rate_profile.num_segments-1].end_frame;
+    }
+    if ( p->train_length ) {
+      scp[k]->train_length = p->train_length;
+      scp[k]->frames_to_send = (uint64_t) p->duration*p->train_length;
+    }
+
+    if ( p->forward ) {
+      ipQuad ipq(p->ip_left_version,p->ip_right_version,&p->ipv4_left_real,&p->ipv4_right_real,&p->ipv4_left_virtual,&p->ipv4_right_virtual,
+                 &p->ipv6_left_real,&p->ipv6_right_real,&p->ipv6_left_virtual,&p->ipv6_right_virtual);
+      left_spars[k] = new senderParameters(scp[k],p->ip_left_version,p->pkt_pool_left_sender,left,fwd_side[k],(ether_addr *)p->mac_left_dut,
+                                           (ether_addr *)p->mac_left_tester,ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,
+                                           &p->ipv6_left_real,&p->ipv6_right_real,p->num_right_nets);
+    }
+    if ( p->reverse ) {
+      ipQuad ipq(p->ip_right_version,p->ip_left_version,&p->ipv4_right_real,&p->ipv4_left_real,&p->ipv4_right_virtual,&p->ipv4_left_virtual,
+                 &p->ipv6_right_real,&p->ipv6_left_real,&p->ipv6_right_virtual,&p->ipv6_left_virtual);
+      right_spars[k] = new senderParameters(scp[k],p->ip_right_version,p->pkt_pool_right_sender,right,rev_side[k],(ether_addr *)p->mac_right_dut,
+                                            (ether_addr *)p->mac_right_tester,ipq.src_ipv4,ipq.dst_ipv4,ipq.src_ipv6,ipq.dst_ipv6,
+                                            &p->ipv6_right_real,&p->ipv6_left_real,p->num_left_nets);
+    }
+    pregenerateFrames(p, left_spars[k], right_spars[k], noStamp::copies, mkTestFrame4, mkTestFrame6);
+  }
+
+  // all pairs start at the same time
+  setStartTime();
+  for ( k=0; k<num_pairs; k++ ) {
+    Throughput *p = t[k];
+    p->start_tsc = scp[k]->start_tsc = start_tsc;
+    p->finish_receiving = finish_receiving;
+    if ( p->hw_pacing && !p->train_length && !p->rate_profile.num_segments && p->arrival_dist == 'P' ) {
+      if ( p->forward )
+        p->startHwPacing(left_spars[k]);
+      if ( p->reverse )
+        p->startHwPacing(right_spars[k]);
+    }
+  }
+
+  for ( k=0; k<num_pairs; k++ ) {
+    Throughput *p = t[k];
+    if ( p->forward ) {
+      if ( rte_eal_remote_launch(send, left_spars[k], p->cpu_left_sender) )
+        std::cout << "Error: could not start Left Sender " << k << "." << std::endl;
+      right_rpars[k] = new receiverParameters(finish_receiving,rightport+2*k,fwd_side[k]);
+      right_rpars[k]->mix = scp[k]->mix;
+      right_rpars[k]->frames_to_send = scp[k]->frames_to_send;
+      right_rpars[k]->profile = scp[k]->profile;
+      right_rpars[k]->start_tsc = start_tsc;
+      if ( rte_eal_remote_launch(receive, right_rpars[k], p->cpu_right_receiver) )
+        std::cout << "Error: could not start Right Receiver " << k << "." << std::endl;
+    }
+    if ( p->reverse ) {
+      if ( rte_eal_remote_launch(send, right_spars[k], p->cpu_right_sender) )
+        std::cout << "Error: could not start Right Sender " << k << "." << std::endl;
+      left_rpars[k] = new receiverParameters(finish_receiving,leftport+2*k,rev_side[k]);
+      left_rpars[k]->mix = scp[k]->mix;
+      left_rpars[k]->frames_to_send = scp[k]->frames_to_send;
+      left_rpars[k]->profile = scp[k]->profile;
+      left_rpars[k]->start_tsc = start_tsc;
+      if ( rte_eal_remote_launch(receive, left_rpars[k], p->cpu_left_receiver) )
+        std::cout << "Error: could not start Left Receiver " << k << "." << std::endl;
+    }
+  }
+
+  std::cout << "Info: Testing started on " << num_pairs << " port pairs." << std::endl;
+
+  // wait until active senders and receivers finish
+  for ( k=0; k<num_pairs; k++ ) {
+    Throughput *p = t[k];
+    if ( p->forward ) {
+      rte_eal_wait_lcore(p->cpu_left_sender);
+      rte_eal_wait_lcore(p->cpu_right_receiver);
+    }
+    if ( p->reverse ) {
+      rte_eal_wait_lcore(p->cpu_right_sender);
+      rte_eal_wait_lcore(p->cpu_left_receiver);
+    }
+  }
+  for ( k=0; k<num_pairs; k++ ) {
+    Throughput *p = t[k];
+    if ( p->forward ) {
+      any_fwd = 1;
+      fwd_sent += scp[k]->frames_to_send;
+      fwd_received += right_rpars[k]->received;
+      p->finishHwPacing(left_spars[k]);
+    }
+    if ( p->reverse ) {
+      any_rev = 1;
+      rev_sent += scp[k]->frames_to_send;
+      rev_received += left_rpars[k]->received;
+      p->finishHwPacing(right_spars[k]);
+    }
+    deleteSenderParameters(left_spars[k]);
+    deleteSenderParameters(right_spars[k]);
+    delete left_rpars[k];
+    delete right_rpars[k];
+    delete scp[k];
+    p->finishPortStats();
+  }
+
+  // the sums are reported in the same format as the results of a single port pair
+  if ( any_fwd ) {
+    printf("Forward frames sent: %lu\n", fwd_sent);
+    printf("Forward frames received: %lu\n", fwd_received);
+  }
+  if ( any_rev ) {
+    printf("Reverse frames sent: %lu\n", rev_sent);
+    printf("Reverse frames received: %lu\n", rev_received);
+  }
   std::cout << "Info: Test finished." << std::endl;
 }
 
+// sets the rate limit of the TX queue of the sender to the line rate of the test traffic, if the NIC supports it,
+// otherwise the sender falls back to TSC based pacing
+void Throughput::startHwPacing(senderParameters *p) {
+  // the line rate needed: the average frame size plus the preamble, SFD and the inter-frame gap (20 bytes) is used
+  double ipv6_size = ipv6_frame_size; // average IPv6 frame size
+  if ( size_mix.num_sizes ) {
+    ipv6_size = 0;
+    for ( int i=0; i<size_mix.num_sizes; i++ )
+      ipv6_size += (double) size_mix.ipv6_size[i]*size_mix.weight[i]/size_mix.seq_len;
+  }
+  double fg_size = p->ip_version == 4 ? ipv6_size-20 : ipv6_size;
+  double avg_size = m >= n ? fg_size : ( m*fg_size + (n-m)*ipv6_size ) / n;
+  uint64_t rate = ((uint64_t) ((avg_size+20)*8*frame_rate) + 999999)/1000000; // rounded up to Mbps
+  uint16_t mbps = rate > 65535 ? 65535 : rate;
+
+  if ( rte_eth_set_queue_rate_limit(p->eth_id, 0, mbps) ) {
+    printf("Warning: %s port does not support TX queue rate limiting, the %s Sender is paced by the TSC.\n", p->side, p->side);
+    return;
+  }
+  p->hw_pacing = 1;
+  printf("Info: %s TX queue is rate limited to %u Mbps by the NIC.\n", p->side, mbps);
+}
+
+// removes the rate limit of the TX queue of the sender, if it was set by startHwPacing()
+void Throughput::finishHwPacing(senderParameters *p) {
+  if ( p && p->hw_pacing && rte_eth_set_queue_rate_limit(p->eth_id, 0, 0) )
+    printf("Warning: Could not remove the rate limit of the %s TX queue.\n", p->side);
+}
+
+// fills in the header of the live counters page and clears the counters of the active roles (if there is a live page)
+void Throughput::startLivePage() {
+  if ( !live )
+    return;
+  live->hz = hz;
+  live->start_tsc = start_tsc;
+  live->finish_receiving = finish_receiving;
+  live->frame_rate = frame_rate;
+  live->duration = duration;
+  live->active = (forward ? (1<<LIVE_LEFT_SENDER | 1<<LIVE_RIGHT_RECEIVER) : 0) | (reverse ? (1<<LIVE_RIGHT_SENDER | 1<<LIVE_LEFT_RECEIVER) : 0);
+  memset(live->role, 0, sizeof(live->role));
+  live->trial = live->trial + 1;
+}
+
+// takes the statistics of both ports at the beginning of the test
+void Throughput::startPortStats() {
+  left_port_stats->start();
+  right_port_stats->start();
+}
+
+// reports the differences of the statistics of both ports, and whether the Tester's ports dropped frames
+uint64_t Throughput::finishPortStats() {
+  return left_port_stats->finish() + right_port_stats->finish();
+}
+
+// creates the net_ring ports of the Tester and of the reference DUT, and sets up the ports and the address mappings of the reference DUT
+// the ports of the Tester are configured by init() as if they were NICs
+int Throughput::initRefDut(uint16_t leftport, uint16_t rightport) {
+  uint16_t tester_left, tester_right;	// port IDs of the net_ring ports of the Tester
+  struct rte_eth_conf cfg_port;		// for configuring the ports of the reference DUT
+  unsigned socket = rte_lcore_to_socket_id(cpu_ref_dut); // all rings and ports are on the NUMA node of the reference DUT
+
+  if ( createRefDutPorts(socket, &tester_left, &tester_right, &ref_dut_left_port, &ref_dut_right_port) < 0 ) {
+    std::cerr << "Error: Cannot create the net_ring ports for the reference DUT, Tester exits." << std::endl;
+    return -1;
+  }
+  if ( tester_left != leftport || tester_right != rightport ) {
+    std::cerr << "Error: The net_ring ports of the Tester got port IDs #" << tester_left << " and #" << tester_right <<
+      " instead of #" << leftport << " and #" << rightport << ", Tester exits." << std::endl;
+    return -1;
+  }
+
+  memset(&cfg_port, 0, sizeof(cfg_port));
+  if ( rte_eth_dev_configure(ref_dut_left_port, 1, 1, &cfg_port) < 0 || rte_eth_dev_configure(ref_dut_right_port, 1, 1, &cfg_port) < 0 ||
+       rte_eth_tx_queue_setup(ref_dut_left_port, 0, REF_DUT_RING_SIZE, socket, NULL) < 0 ||
+       rte_eth_tx_queue_setup(ref_dut_right_port, 0, REF_DUT_RING_SIZE, socket, NULL) < 0 ) {
+    std::cerr << "Error: Cannot set up the ports of the reference DUT, Tester exits." << std::endl;
+    return -1;
+  }
+  imp_queue_size = impQueueSize();
+  if ( createRefDutPool() < 0 )
+    return -1;
+
+  // the mappings are the address pairs of siitperf.conf: the IPv4 allusion of an IPv6 address and the IPv6 allusion of an IPv4 address
+  ref_dut_eam = new eamTable;
+  if ( ref_dut_eam->addNets(&ipv6_left_real, ipv4_left_virtual, num_left_nets, 1) || ref_dut_eam->addNets(&ipv6_right_virtual, ipv4_right_real, num_right_nets, 0) ||
+       ref_dut_eam->addNets(&ipv6_left_virtual, ipv4_left_real, num_left_nets, 0) || ref_dut_eam->addNets(&ipv6_right_real, ipv4_right_virtual, num_right_nets, 1) ) {
+    std::cerr << "Error: Too many address mappings for the reference DUT, Tester exits." << std::endl;
+    return -1;
+  }
+  std::cout << "Info: Reference DUT uses " << ref_dut_eam->entries << " address mappings." << std::endl;
+  return 0;
+}
+
+// the impairment queues must hold the frames of the delay (of at most 4 times the jitter) at the frame rate of the trial, and the duplicates
+// returns 0, if no impairment is used
+uint32_t Throughput::impQueueSize() {
+  uint32_t size;
+
+  if ( !imp_delay && !imp_jitter && !imp_loss && !imp_dup && !imp_reorder )
+    return 0;
+  uint64_t frames_delayed = 2*(uint64_t)frame_rate*(imp_delay+4*imp_jitter)/1000000 + REF_DUT_RING_SIZE;
+  for ( size = REF_DUT_RING_SIZE; size < frames_delayed && size < IMP_MAX_QUEUE_SIZE; size *= 2 );
+  return size;
+}
+
+// creates the packet pool of the reference DUT for the current size of the impairment queues, and starts the ports of the
+// reference DUT with it (their RX queues are set up again, thus they must be stopped, if the pool is recreated)
+int Throughput::createRefDutPool() {
+  unsigned socket = rte_lcore_to_socket_id(cpu_ref_dut);
+
+  if ( imp_queue_size )
+    std::cout << "Info: The impairment queues of the reference DUT can store " << imp_queue_size << " frames each." << std::endl;
+  // ring size for the frames towards the Tester, plus the ones being processed, plus the ones in the impairment queues
+  // translated frames may be 20 bytes longer than the longest Ethernet frame (IPv4 to IPv6)
+  pkt_pool_ref_dut = rte_pktmbuf_pool_create ( "pp_ref_dut", 2*REF_DUT_RING_SIZE + 4*MAX_PKT_BURST + 100 + 2*(imp_queue_size+1), PKTPOOL_CACHE, 0,
+                                               RTE_PKTMBUF_HEADROOM + ETHER_MAX_LEN + 20, socket);
+  if ( !pkt_pool_ref_dut ) {
+    std::cerr << "Error: Cannot create packet pool for the reference DUT, Tester exits." << std::endl;
+    return -1;
+  }
+  if ( rte_eth_rx_queue_setup(ref_dut_left_port, 0, REF_DUT_RING_SIZE, socket, NULL, pkt_pool_ref_dut) < 0 ||
+       rte_eth_rx_queue_setup(ref_dut_right_port, 0, REF_DUT_RING_SIZE, socket, NULL, pkt_pool_ref_dut) < 0 ||
+       rte_eth_dev_start(ref_dut_left_port) < 0 || rte_eth_dev_start(ref_dut_right_port) < 0 ) {
+    std::cerr << "Error: Cannot set up the ports of the reference DUT, Tester exits." << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// starts the reference DUT (if used) for the duration of the test
+void Throughput::startRefDut() {
+  if ( cpu_ref_dut < 0 )
+    return;
+  ref_dut_pars = new refDutParameters(ref_dut_left_port, ref_dut_right_port, pkt_pool_ref_dut, ref_dut_eam,
+                                      (ether_addr *)mac_left_dut, (ether_addr *)mac_right_dut, (ether_addr *)mac_left_tester,
+                                      (ether_addr *)mac_right_tester, finish_receiving);
+  if ( imp_queue_size ) {
+    ref_dut_pars->imp_cfg.delay_tsc = hz*imp_delay/1000000;
+    ref_dut_pars->imp_cfg.jitter_tsc = hz*imp_jitter/1000000;
+    ref_dut_pars->imp_cfg.jitter_dist = imp_dist;
+    ref_dut_pars->imp_cfg.loss_ppm = imp_loss;
+    ref_dut_pars->imp_cfg.loss_burst = imp_burst;
+    ref_dut_pars->imp_cfg.dup_ppm = imp_dup;
+    ref_dut_pars->imp_cfg.reorder_ppm = imp_reorder;
+    ref_dut_pars->forward_imp = new impairment(&ref_dut_pars->imp_cfg, imp_queue_size, hz, rte_lcore_to_socket_id(cpu_ref_dut));
+    ref_dut_pars->reverse_imp = new impairment(&ref_dut_pars->imp_cfg, imp_queue_size, hz, rte_lcore_to_socket_id(cpu_ref_dut));
+  }
+  if ( rte_eal_remote_launch(refDut, ref_dut_pars, cpu_ref_dut) )
+    std::cout << "Error: could not start the reference DUT." << std::endl;
+}
+
+// waits until the reference DUT (if used) finishes and reports its counters
+void Throughput::finishRefDut() {
+  if ( cpu_ref_dut < 0 )
+    return;
+  rte_eal_wait_lcore(cpu_ref_dut);
+  delete ref_dut_pars->forward_imp;
+  delete ref_dut_pars->reverse_imp;
+  delete ref_dut_pars;
+  ref_dut_pars = 0;
+  drainRefDutRings(); // the next trial frees the pools of the frames still in the rings
+}
+
+// checks if any of the active senders and receivers is still running
+int Throughput::lcoresRunning() {
+  if ( forward && ( rte_eal_get_lcore_state(cpu_left_sender) == RUNNING || rte_eal_get_lcore_state(cpu_right_receiver) == RUNNING ) )
+    return 1;
+  if ( reverse && ( rte_eal_get_lcore_state(cpu_right_sender) == RUNNING || rte_eal_get_lcore_state(cpu_left_receiver) == RUNNING ) )
+    return 1;
+  return 0;
+}
+
 // sets the values of the data fields
-senderCommonParameters::senderCommonParameters(uint16_t ipv6_frame_size_, uint16_t ipv4_frame_size_, uint32_t frame_rate_, uint16_t duration_, 
+senderCommonParameters::senderCommonParameters(uint16_t ipv6_frame_size_, uint16_t ipv4_frame_size_, uint32_t frame_rate_, uint32_t duration_, 
                                                uint32_t n_, uint32_t m_, uint64_t hz_, uint64_t start_tsc_) {
   ipv6_frame_size = ipv6_frame_size_;
   ipv4_frame_size = ipv4_frame_size_;
@@ -864,6 +2168,14 @@ senderCommonParameters::senderCommonParameters(uint16_t ipv6_frame_size_, uint16
   m = m_;
   hz = hz_;
   start_tsc = start_tsc_;
+  frames_to_send = (uint64_t) duration*frame_rate;
+  timeline_tsc = 0;
+  max_lateness_tsc = 0;
+  mix = 0;
+  profile = 0;
+  train_length = 0;
+  arrival_dist = 'P';
+  arrival_burst = arrival_peak = 0;
 }
 
 // sets the values of the data fields
@@ -885,6 +2197,13 @@ senderParameters::senderParameters(class senderCommonParameters *cp_, int ip_ver
   src_bg = src_bg_;
   dst_bg = dst_bg_;
   num_dest_nets = num_dest_nets_;
+  timeline = 0;
+  live = 0;
+  frames = 0;
+  hw_pacing = 0;
+  arrivals = 0;
+  arrivals_end_tsc = 0;
+  consol = 0;
 }
 
 // sets the values of the data fields
@@ -892,6 +2211,23 @@ receiverParameters::receiverParameters(uint64_t finish_receiving_, uint8_t eth_i
   finish_receiving=finish_receiving_;
   eth_id = eth_id_;
   side = side_;
+  timeline = 0;
+  start_tsc = 0;
+  timeline_tsc = 0;
+  live = 0;
+  mix = 0;
+  profile = 0;
+  frames_to_send = 0;
+  received = 0;
+}
+
+// the senders and receivers of the consolidated lcore are added by measureConsolidated()
+consolParameters::consolParameters(int cpu_) {
+  cpu = cpu_;
+  spars[0] = spars[1] = 0;
+  rpars[0] = rpars[1] = 0;
+  all_frames[0] = all_frames[1] = 0;
+  polls = last_poll = longest_poll = 0;
 }
 
 // collects the apppropriate IP addresses
@@ -21,6 +21,51 @@
 #ifndef THROUGHPUT_H_INCLUDED
 #define THROUGHPUT_H_INCLUDED
 
+class timelineRing;	// see timeline.h
+class portStats;	// see nicstats.h
+class eamTable;		// see refdut.h
+class refDutParameters;	// see refdut.h
+class senderParameters;	// see below
+class consolParameters;	// see below
+struct livePage;	// see live.h
+struct liveCounters;	// see live.h
+struct senderFrames;	// see sender.h
+
+// frame size mix (e.g. IMIX) of siitperf-tp: the frames cycle through a sequence of size classes, in which each class occurs
+// as many times as its weight, evenly spread
+struct sizeMix {
+  int num_sizes;			// number of size classes, 0: no mix, all frames have the size given in the command line
+  uint16_t ipv6_size[MAX_SIZE_CLASSES];	// IPv6 frame size of each class (the IPv4 frames are 20 bytes shorter)
+  uint16_t weight[MAX_SIZE_CLASSES];	// number of occurrences of each class in the sequence
+  uint16_t seq_len;			// length of the sequence (sum of the weights)
+  uint8_t seq[MAX_SIZE_SEQ];		// size class of each frame of the sequence
+};
+
+// returns the number of frames of the given size class among the first "frames" frames
+uint64_t sizeMixCount(const sizeMix *mix, int size_class, uint64_t frames);
+
+// a segment of a rate profile: the frame rate changes linearly from start_rate to end_rate (they are equal for a step)
+struct profileSegment {
+  uint32_t end_ms;		// end of the segment in milliseconds from the start of sending
+  uint32_t start_rate, end_rate;	// frame rate at the beginning and at the end of the segment
+  uint64_t end_frame;		// number of frames sent until the end of the segment
+};
+
+// a step of the schedule of a rate profile: the frames are sent at a constant rate (a ramp consists of many steps)
+struct profileStep {
+  uint64_t first_frame;		// the first frame of the step
+  uint32_t start_ms;		// beginning of the step in milliseconds from the start of sending
+  uint32_t rate;		// frame rate of the step
+};
+
+// rate profile of siitperf-tp: the frame rate changes over time, piecewise linearly or stepwise
+struct rateProfile {
+  int num_segments;		// number of segments, 0: no profile, the frame rate of the command line is used
+  profileSegment *segments;
+  int num_steps;		// number of steps, they are followed by a sentinel with first_frame = ~0
+  profileStep *steps;
+};
+
 // the main class for siitperf
 // data members are used for storing parameters
 // member functions are used for the most important functions
@@ -54,16 +99,38 @@ public:
   int cpu_right_receiver; 	// lcore for right side Receiver
   int cpu_right_sender; 	// lcore for right side Sender
   int cpu_left_receiver; 	// lcore for left side Receiver
+  int cpu_ref_dut;		// lcore for the built-in reference DUT, -1: no reference DUT, the Tester uses its NICs
+  int cpu_auto;			// if 1, the lcores not set in the config file are chosen by placeLcores()
+  uint32_t imp_delay, imp_jitter;	// impairments of the reference DUT: fixed delay and jitter (in microseconds)
+  char imp_dist;			// distribution of the jitter: 'U', 'E' or 'N' (see refdut.h)
+  uint32_t imp_loss, imp_dup, imp_reorder;	// probability of loss events, duplication and reordering (per million frames)
+  uint16_t imp_burst;			// number of frames lost in a loss event
+  int ring_loopback;		// if non-zero, the Left and Right ports are net_ring ports connected back to back (for calibration)
 
   uint8_t memory_channels; // Number of memory channnels (for the EAL init.)
+  uint16_t timeline_interval; // length of the intervals of the throughput timeline in milliseconds, 0: no timeline
+  char live_page_name[LINELEN+1]; // name of the shared memory segment for the live counters, empty: no live counters
+  rateProfile rate_profile;	// rate profile, used by siitperf-tp only (it gives the frame rate and the duration)
+  sizeMix size_mix;		// frame size mix, used by siitperf-tp only (the largest size is used as ipv6_frame_size)
+  char arrival_dist;		// arrival process of the frames: 'P': periodic, 'E': exponential gaps (Poisson), 'O': Markov on/off
+  uint16_t arrival_burst;	// Markov on/off: mean number of frames of an on period
+  uint16_t arrival_peak;	// Markov on/off: frame rate of the on periods divided by the mean frame rate
+  int hw_pacing;			// if 1, the frames are spaced by the rate limiter of the TX queue of the NIC (siitperf-tp only)
+  uint32_t max_lateness;	// the test is invalid, if a frame is started later than its scheduled time plus this value (in microseconds), 0: not checked
+  int num_pairs;		// number of port pairs, the further ones are described by their own configuration files (siitperf-tp only)
+  char pair_config[MAX_PORT_PAIRS][LINELEN+1];	// configuration files of the further port pairs (pair_config[0] is not used)
+  int core_consol;		// core consolidation (siitperf-tp only), 0: none, 1: the sender and receiver of each direction share an lcore, 2: all of them
 
   // positional parameters from command line
   uint16_t ipv6_frame_size;	// size of the frames carrying IPv6 datagrams (including the 4 bytes of the FCS at the end) 
   uint16_t ipv4_frame_size; 	// redundant parameter, automatically set as ipv6_frame_size-20
   uint32_t frame_rate;		// number of frames per second
-  uint16_t duration;		// test duration (in seconds, 1-3600)
+  uint32_t duration;		// test duration (in seconds, 1-3600, soak test: 1-MAX_SOAK_DURATION)
   uint16_t global_timeout;	// global timeout (in milliseconds, 0-60000)
   uint32_t n, m;		// modulo and threshold for controlling background traffic proportion
+  uint32_t train_length;	// back-to-back test: number of frames of the train sent in every second, 0: continuous sending
+
+  const char *program;		// "tp", "lat" or "pdv", used for finding the calibration data
 
   // further data members, set by init()
   rte_mempool *pkt_pool_left_sender, *pkt_pool_right_receiver;	// packet pools for the forward direction testing
@@ -72,17 +139,57 @@ public:
   uint64_t start_tsc;		// sending of the test frames will begin at this time
   uint64_t finish_receiving;	// receiving of the test frames will end at this time
   uint64_t frames_to_send;	// number of frames to send 
+  livePage *live;		// live counters page (NULL, if not used)
+  portStats *left_port_stats, *right_port_stats;	// for the statistics of the ports taken before and after each test
+  uint16_t ref_dut_left_port, ref_dut_right_port;	// net_ring ports of the reference DUT (if used)
+  rte_mempool *pkt_pool_ref_dut;	// packet pool of the reference DUT (if used)
+  eamTable *ref_dut_eam;		// address mappings of the reference DUT (if used)
+  refDutParameters *ref_dut_pars;	// parameters of the running reference DUT (if used)
+  uint32_t imp_queue_size;		// size of the queues of the impairment stages, 0: no impairment
+  Throughput *pair[MAX_PORT_PAIRS];	// the further port pairs (set by readConfigFile(), pair[0] is not used, it is this object)
+  int pair_id;				// the index of this object among the port pairs
+  char left_name[16], right_name[16];	// "Left" and "Right" followed by pair_id, if there are more port pairs
 
   // helper functions (see their description at their definition)
   int findKey(const char *line, const char *key);
+  int readSizeMix(const char *spec);
+  int readRateProfile(const char *filename);
+  int setRateProfile(profileSegment *seg, int num_segments);
   int readConfigFile(const char *filename);
+  int readPairs();
+  void setPairId(int id);
+  const char *poolName(char *name, const char *base);
   int readCmdLine(int argc, const char *argv[]);
+  int checkCalibration(const char *cal_prog, int hard_limit);
   int init(const char *argv0, uint16_t leftport, uint16_t rightport);
+  int initPorts(uint16_t leftport, uint16_t rightport);
+  int createSenderPools();
+  int waitLinks(uint16_t leftport, uint16_t rightport);
+  void setStartTime();
+  void adopt(const Throughput &session);
+  int prepareTrial(uint16_t leftport, uint16_t rightport, int restart);
   virtual int senderPoolSize(int numDestNets);
+  virtual uint64_t timestampMemory();
+  void reportMemory();
   void numaCheck(uint16_t port, const char *port_side, int cpu, const char *cpu_name);
+  int placeLcores(uint16_t leftport, uint16_t rightport);
+  void smtCheck();
+  int lcoresRunning();
+  void startLivePage();
+  void startHwPacing(senderParameters *p);
+  void finishHwPacing(senderParameters *p);
+  void startPortStats();
+  uint64_t finishPortStats();
+  int initRefDut(uint16_t leftport, uint16_t rightport);
+  uint32_t impQueueSize();
+  int createRefDutPool();
+  void startRefDut();
+  void finishRefDut();
 
   // perform throughput measurement
   void measure(uint16_t leftport, uint16_t rightport);
+  void measurePairs(uint16_t leftport, uint16_t rightport);
+  void measureConsolidated(uint16_t leftport, uint16_t rightport);
 
   Throughput();
 };
@@ -94,12 +201,14 @@ struct rte_mbuf *mkTestFrame4(uint16_t length, rte_mempool *pkt_pool, const char
 void mkEthHeader(struct ether_hdr *eth, const struct ether_addr *dst_mac, const struct ether_addr *src_mac, const uint16_t ether_type);
 void mkIpv4Header(struct ipv4_hdr *ip, uint16_t length, const uint32_t *src_ip, const uint32_t *dst_ip);
 void mkUdpHeader(struct udp_hdr *udp, uint16_t length); 
-void mkData(uint8_t *data, uint16_t length);
 struct rte_mbuf *mkTestFrame6(uint16_t length, rte_mempool *pkt_pool, const char *side,
                                 const struct ether_addr *dst_mac, const struct ether_addr *src_mac,
                                 const struct in6_addr *src_ip, const struct in6_addr *dst_ip);
 void mkIpv6Header(struct ipv6_hdr *ip, uint16_t length, const struct in6_addr *src_ip, const struct in6_addr *dst_ip);
 
+// checks if there is some non comment information in the line
+int nonComment(const char *line);
+
 // report the current TSC of the exeucting core
 int report_tsc(void *par);
 
@@ -112,18 +221,28 @@ int send(void *par);
 // receive and count test frames
 int receive(void *par);
 
+// send and receive test frames on a single lcore (core consolidation)
+int sendReceive(void *par);
+
 // to store identical parameters for both senders
 class senderCommonParameters {
   public:
   uint16_t ipv6_frame_size;     // size of the frames carrying IPv6 datagrams (including the 4 bytes of the FCS at the end)
   uint16_t ipv4_frame_size;     // redundant parameter, automatically set as ipv6_frame_size-20
   uint32_t frame_rate;          // number of frames per second
-  uint16_t duration;            // test duration (in seconds, 1-3600)
+  uint32_t duration;            // test duration (in seconds)
   uint32_t n, m;         	// modulo and threshold for controlling background traffic proportion
   uint64_t hz;                  // number of clock cycles per second
   uint64_t start_tsc;           // sending of the test frames will begin at this time
   uint64_t frames_to_send;      // number of frames to send
-  senderCommonParameters(uint16_t ipv6_frame_size_, uint16_t ipv4_frame_size_, uint32_t frame_rate_, uint16_t duration_,
+  uint64_t timeline_tsc;        // length of a timeline interval in TSC, 0: no timeline (set by measure() after construction)
+  uint64_t max_lateness_tsc;    // maximum allowed frame lateness in TSC, 0: not checked (set by measure() after construction)
+  const sizeMix *mix;		// frame size mix, NULL: all frames have the above sizes (set by measure() after construction)
+  const rateProfile *profile;	// rate profile, NULL: the frame rate is constant (set by measure() after construction)
+  uint32_t train_length;	// frames are sent in trains of this length once per second, 0: continuous (set by measure() after construction)
+  char arrival_dist;		// arrival process: 'P', 'E' or 'O', see class Throughput (set by measure() after construction)
+  uint16_t arrival_burst, arrival_peak;	// parameters of the Markov on/off process (set by measure() after construction)
+  senderCommonParameters(uint16_t ipv6_frame_size_, uint16_t ipv4_frame_size_, uint32_t frame_rate_, uint32_t duration_,
                          uint32_t n_, uint32_t m_, uint64_t hz_, uint64_t start_tsc_);
 };
 
@@ -140,10 +259,18 @@ class senderParameters {
   struct in6_addr *src_ipv6, *dst_ipv6;
   struct in6_addr *src_bg, *dst_bg;
   uint16_t num_dest_nets;
+  timelineRing *timeline;	// counter snapshots are published here, if not NULL (set by measure() after construction)
+  liveCounters *live;		// live counters are published here, if not NULL (set by measure() after construction)
+  senderFrames *frames;		// pre-generated frames (set by pregenerateFrames())
+  int hw_pacing;		// 1: the TX queue is rate limited by the NIC (set by startHwPacing())
+  uint64_t *arrivals;		// scheduled times of the frames of a random arrival process relative to the start of their cycle (set by pregenerate())
+  uint64_t arrivals_end_tsc;	// scheduled time of the last frame relative to start_tsc (set by pregenerate(), if arrivals is set)
+  consolParameters *consol;	// the lcore is shared with these receivers (set by measureConsolidated() with core consolidation)
   senderParameters(class senderCommonParameters *cp_, int ip_version_, rte_mempool *pkt_pool_, uint8_t eth_id_, const char *side_,
                    struct ether_addr *dst_mac_,  struct ether_addr *src_mac_,  uint32_t *src_ipv4_, uint32_t *dst_ipv4_,
                    struct in6_addr *src_ipv6_, struct in6_addr *dst_ipv6_, struct in6_addr *src_bg_, struct in6_addr *dst_bg_,
                    uint16_t num_dest_nets_);
+  virtual ~senderParameters() {}	// the parameters of the senders are deleted through base class pointers
 };
 
 // to store parameters for each receiver 
@@ -152,9 +279,29 @@ class receiverParameters {
   uint64_t finish_receiving;     // this one is common, but it was not worth dealing with it.
   uint8_t eth_id;
   const char *side;
+  timelineRing *timeline;	// counter snapshots are published here, if not NULL (set by measure() after construction)
+  uint64_t start_tsc;		// the first timeline interval starts here
+  uint64_t timeline_tsc;	// length of a timeline interval in TSC
+  liveCounters *live;		// live counters are published here, if not NULL (set by measure() after construction)
+  const sizeMix *mix;		// frame size mix, the frames are counted per size class, if not NULL (set by measure() after construction)
+  const rateProfile *profile;	// rate profile, the frames are counted per segment, if not NULL (set by measure() after construction)
+  uint64_t frames_to_send;	// number of frames sent by the sender, used for the frame loss of the size classes
+  uint64_t received;		// number of Test Frames received (set by receive() at its end, or counted by a consolidated lcore)
   receiverParameters(uint64_t finish_receiving_, uint8_t eth_id_, const char *side_);
 };
 
+// the senders and receivers served by the run-to-completion loop of a consolidated lcore (the inactive ones are NULL)
+class consolParameters {
+  public:
+  int cpu;			// the lcore of the loop
+  senderParameters *spars[2];	// Left and Right Sender
+  receiverParameters *rpars[2];	// Right and Left Receiver
+  uint64_t all_frames[2];	// number of all frames received by the receivers (including the foreign ones)
+  uint64_t polls;		// number of times the receivers were polled
+  uint64_t last_poll, longest_poll;	// TSC of the last poll and the longest time between two polls
+  consolParameters(int cpu_);
+};
+
 // to collect source and destionation IPv4 and IPv6 addresses
 class ipQuad {
   public:
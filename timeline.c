@@ -0,0 +1,81 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "defines.h"
+#include "includes.h"
+#include "timeline.h"
+
+// allocates the slots of the ring on the NUMA node of the producer
+timelineRing::timelineRing(int socket_id) {
+  slot = (timelineSnapshot *) rte_zmalloc_socket(0, TIMELINE_RING_SIZE*sizeof(timelineSnapshot), RTE_CACHE_LINE_SIZE, socket_id);
+  if ( !slot )
+    rte_exit(EXIT_FAILURE, "Error: Tester can't allocate memory for timeline snapshots!\n");
+  head = tail = overwritten = 0;
+}
+
+timelineRing::~timelineRing() {
+  rte_free(slot);
+}
+
+// the producer may have overwritten some slots, while they were being read, thus head is checked again after reading
+// the producer writes slot[head] before incrementing head, thus the slot of tail is being overwritten, if head-tail == TIMELINE_RING_SIZE
+void timelineRing::drain() {
+  uint64_t h = head;
+  rte_smp_rmb();	// slots must not be read before head
+  if ( h - tail >= TIMELINE_RING_SIZE ) {
+    overwritten += h - tail - TIMELINE_RING_SIZE + 1;
+    tail = h - TIMELINE_RING_SIZE + 1;
+  }
+  for ( ; tail < h; tail++ ) {
+    timelineSnapshot s = slot[tail & (TIMELINE_RING_SIZE-1)];
+    rte_smp_rmb();
+    if ( head - tail >= TIMELINE_RING_SIZE ) {
+      overwritten++; // the slot was overwritten while it was being read
+      continue;
+    }
+    series.push_back(s);
+  }
+}
+
+// both the sender and the receiver publish exactly one snapshot per interval (and a final one at the end of their operation),
+// thus the snapshots are paired by their index; the time of the interval is taken from the receiver
+// a frame is considered lost in the interval in which it was sent, thus the received frames are shifted by the delay of the DUT
+// (it is not an issue, if the interval is much longer than the delay)
+void reportTimeline(timelineRing *sent, timelineRing *received, uint64_t start_tsc, uint64_t hz, uint16_t interval, const char *side) {
+  uint64_t i;	// cycle variable
+  uint64_t sent_prev=0, received_prev=0;	// cumulative values at the end of the previous interval
+
+  sent->drain();
+  received->drain();
+  if ( sent->overwritten || received->overwritten )
+    printf("Warning: %s timeline: %lu sender and %lu receiver snapshots were lost.\n", side, sent->overwritten, received->overwritten);
+  if ( received->series.empty() )
+    return;
+  printf("Info: %s timeline (interval: %u ms): end of interval (ms), frames sent, frames received, frames lost\n", side, interval);
+  for ( i=0; i<received->series.size(); i++ ) {
+    uint64_t sent_cum = sent->series.empty() ? 0 : i < sent->series.size() ? sent->series[i].frames : sent->series.back().frames;
+    uint64_t received_cum = received->series[i].frames;
+    int64_t sent_now = sent_cum - sent_prev;
+    int64_t received_now = received_cum - received_prev;
+    printf("%s timeline: %.3lf, %ld, %ld, %ld\n", side, 1000.0*(received->series[i].tsc-start_tsc)/hz, sent_now, received_now, sent_now-received_now);
+    sent_prev = sent_cum;
+    received_prev = received_cum;
+  }
+}
@@ -0,0 +1,60 @@
+/* Siitperf is an RFC 8219 SIIT (stateless NAT64) tester written in C++ using DPDK
+ *
+ *  Copyright (C) 2019 Gabor Lencse
+ *
+ *  This file is part of siitperf.
+ *
+ *  Siitperf is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Siitperf is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with siitperf.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMELINE_H_INCLUDED
+#define TIMELINE_H_INCLUDED
+
+// a counter snapshot taken by a sender or a receiver at the end of a timeline interval
+struct timelineSnapshot {
+  uint64_t tsc;		// when the snapshot was taken
+  uint64_t frames;	// number of frames sent or received so far
+};
+
+// lock-free single-producer single-consumer ring for counter snapshots
+// the producer is a sender or receiver lcore, the consumer is the main lcore, which drains it into "series"
+class timelineRing {
+public:
+  timelineSnapshot *slot;			// TIMELINE_RING_SIZE number of slots, NUMA local to the producer
+  volatile uint64_t head;			// number of snapshots published, written by the producer only
+  uint8_t pad[RTE_CACHE_LINE_SIZE];		// keeps head and the data of the consumer in different cache lines
+  uint64_t tail;				// number of snapshots collected, used by the consumer only
+  uint64_t overwritten;				// number of snapshots lost, because the consumer was too slow
+  std::vector<timelineSnapshot> series;		// snapshots collected by the consumer
+
+  timelineRing(int socket_id);
+  ~timelineRing();
+
+  // called by the producer: it never blocks, the oldest snapshot is overwritten, if the ring is full
+  inline void publish(uint64_t tsc, uint64_t frames) {
+    timelineSnapshot *s = &slot[head & (TIMELINE_RING_SIZE-1)];
+    s->tsc = tsc;
+    s->frames = frames;
+    rte_smp_wmb();	// the contents of the slot must be visible before the new head
+    head = head + 1;
+  }
+
+  // called by the consumer: moves the published snapshots into "series"
+  void drain();
+};
+
+// prints the per-interval sent, received and lost frame counts of one direction
+void reportTimeline(timelineRing *sent, timelineRing *received, uint64_t start_tsc, uint64_t hz, uint16_t interval, const char *side);
+
+#endif